@@ -29,6 +29,29 @@ LICENSE
 #define MVX_API static
 #endif
 
+/* Optional SIMD kernels for the triangle sweep. Define one of these before
+ * including mvx.h (and enable the instruction set in your compiler). Without
+ * them the portable scalar path is used, which is also the reference.
+ *
+ *   MVX_USE_SSE2   4 voxels per step
+ *   MVX_USE_AVX2   8 voxels per step
+ *   MVX_USE_NEON   4 voxels per step (AArch64)
+ *
+ * MVX_USE_BMI2 (-mbmi2) computes Morton codes with pdep/pext instead of the
+ * shift and mask sequence.
+ */
+#if defined(MVX_USE_AVX2)
+#include <immintrin.h>
+#elif defined(MVX_USE_SSE2)
+#include <emmintrin.h>
+#elif defined(MVX_USE_NEON)
+#include <arm_neon.h>
+#endif
+
+#if defined(MVX_USE_BMI2) && !defined(MVX_USE_AVX2)
+#include <immintrin.h>
+#endif
+
 /* #############################################################################
  * # Linear Algebra & Math functions
  * #############################################################################
@@ -107,6 +130,38 @@ MVX_API MVX_INLINE int mvx_clampi(int v, int min, int max)
   return v;
 }
 
+/* Returns 0 for v <= 0 */
+MVX_API MVX_INLINE float mvx_sqrtf(float v)
+{
+#if defined(MVX_USE_AVX2) || defined(MVX_USE_SSE2)
+  return v > 0.0f ? _mm_cvtss_f32(_mm_sqrt_ss(_mm_set_ss(v))) : 0.0f;
+#elif defined(MVX_USE_NEON)
+  return v > 0.0f ? vgetq_lane_f32(vsqrtq_f32(vdupq_n_f32(v)), 0) : 0.0f;
+#else
+  union
+  {
+    float f;
+    unsigned int i;
+  } u;
+  float r;
+
+  if (!(v > 0.0f))
+  {
+    return 0.0f;
+  }
+
+  /* exponent halving guess (~4% error), three newton steps reach float precision */
+  u.f = v;
+  u.i = 0x1fbd1df5u + (u.i >> 1);
+  r = u.f;
+  r = 0.5f * (r + v / r);
+  r = 0.5f * (r + v / r);
+  r = 0.5f * (r + v / r);
+
+  return r;
+#endif
+}
+
 MVX_API MVX_INLINE mvx_v3 mvx_v3_init(float x, float y, float z)
 {
   mvx_v3 result;
@@ -257,6 +312,114 @@ MVX_API MVX_INLINE int mvx_point_in_box_eps_world(mvx_v3 p, mvx_v3 c, mvx_v3 h,
   return 1;
 }
 
+/* #############################################################################
+ * # Statistics
+ * #############################################################################
+ *
+ * Opt-in hot path counters and phase timers. Define MVX_STATS before
+ * including mvx.h and hand a caller owned mvx_stats to a job (the stats
+ * member of mvx_voxelize_job, 0 when unused) or to
+ * mvx_voxelize_mesh_stats_target, the sweep adds to it. Parallel jobs each
+ * fill their own struct, which the caller sums with mvx_stats_add. Without
+ * MVX_STATS the macros expand to nothing.
+ *
+ * The phase times are in MVX_STATS_TIMER() units (rdtsc cycles by default,
+ * define MVX_STATS_TIMER before including mvx.h to use another clock). With
+ * MVX_STATS the conservative sweep uses the scalar kernel, so the counters
+ * follow its test order.
+ */
+#define MVX_STATS_REJECT_AABB 0   /* triangle bounds vs box */
+#define MVX_STATS_REJECT_PLANE 1  /* triangle normal */
+#define MVX_STATS_REJECT_EDGE_X 2 /* X-axis family of the edge cross products */
+#define MVX_STATS_REJECT_EDGE_Y 3 /* Y-axis family */
+#define MVX_STATS_REJECT_EDGE_Z 4 /* Z-axis family */
+#define MVX_STATS_REJECT_COUNT 5
+
+typedef struct mvx_stats
+{
+  double clear_time;        /* clearing the target */
+  double bounds_time;       /* mesh bounds pass (grid fitting) */
+  double sweep_time;        /* triangle sweep including the solid fill */
+  double phase_start;
+
+  unsigned long triangles;  /* triangles with a non-empty candidate range */
+  unsigned long candidates; /* voxels in the plane band the sweep visits for those triangles (candidates / triangles per triangle) */
+  unsigned long rows_rejected;     /* candidate rows rejected before any voxel test */
+  unsigned long tests;             /* voxel overlap tests */
+  unsigned long point_hits;        /* tests decided by the point in box shortcut */
+  unsigned long rejects[MVX_STATS_REJECT_COUNT]; /* tests rejected per separating axis family */
+  unsigned long hits;              /* tests that overlap (hits / tests is the hit ratio) */
+
+} mvx_stats;
+
+#ifdef MVX_STATS
+
+#ifndef MVX_STATS_TIMER
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#include <intrin.h>
+#define MVX_STATS_TIMER() ((double)__rdtsc())
+#elif (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+static MVX_INLINE double mvx_stats_rdtsc(void)
+{
+  unsigned int lo, hi;
+  __asm__ __volatile__("rdtsc" : "=a"(lo), "=d"(hi));
+  return (double)hi * 4294967296.0 + (double)lo;
+}
+#define MVX_STATS_TIMER() mvx_stats_rdtsc()
+#else
+#define MVX_STATS_TIMER() 0.0
+#endif
+#endif
+
+#define MVX_STATS_ADD(stats, field, n) ((void)((stats) ? ((stats)->field += (n)) : 0))
+#define MVX_STATS_REJECT(stats, family) ((void)((stats) ? ++(stats)->rejects[family] : 0))
+#define MVX_STATS_PHASE_BEGIN(stats) ((void)((stats) ? ((stats)->phase_start = MVX_STATS_TIMER()) : 0.0))
+#define MVX_STATS_PHASE_END(stats, field) ((void)((stats) ? ((stats)->field += MVX_STATS_TIMER() - (stats)->phase_start) : 0.0))
+
+#else
+
+#define MVX_STATS_ADD(stats, field, n) ((void)0)
+#define MVX_STATS_REJECT(stats, family) ((void)0)
+#define MVX_STATS_PHASE_BEGIN(stats) ((void)0)
+#define MVX_STATS_PHASE_END(stats, field) ((void)0)
+
+#endif
+
+MVX_API MVX_INLINE void mvx_stats_init(mvx_stats *stats)
+{
+  int i;
+
+  stats->clear_time = stats->bounds_time = stats->sweep_time = stats->phase_start = 0.0;
+  stats->triangles = stats->candidates = stats->rows_rejected = 0;
+  stats->tests = stats->point_hits = stats->hits = 0;
+
+  for (i = 0; i < MVX_STATS_REJECT_COUNT; ++i)
+  {
+    stats->rejects[i] = 0;
+  }
+}
+
+/* Adds the counters and phase times of stats to sum, e.g. the per job stats of a parallel sweep */
+MVX_API MVX_INLINE void mvx_stats_add(mvx_stats *sum, mvx_stats *stats)
+{
+  int i;
+
+  sum->clear_time += stats->clear_time;
+  sum->bounds_time += stats->bounds_time;
+  sum->sweep_time += stats->sweep_time;
+  sum->triangles += stats->triangles;
+  sum->candidates += stats->candidates;
+  sum->rows_rejected += stats->rows_rejected;
+  sum->tests += stats->tests;
+  sum->point_hits += stats->point_hits;
+  sum->hits += stats->hits;
+
+  for (i = 0; i < MVX_STATS_REJECT_COUNT; ++i)
+  {
+    sum->rejects[i] += stats->rejects[i];
+  }
+}
+
 /* #############################################################################
  * # Mesh Voxelization Algorythm
  * #############################################################################
@@ -344,17 +507,9 @@ MVX_API MVX_INLINE int mvx_triangle_box_overlap(
     mvx_v3 tri_max = mvx_v3_max(v0, mvx_v3_max(v1, v2));
     mvx_v3 bh = mvx_v3_add(boxhalf, mvx_v3_init(SLOP, SLOP, SLOP));
 
-    if (tri_max.x < -bh.x || tri_min.x > bh.x)
-    {
-      return 0;
-    }
-
-    if (tri_max.y < -bh.y || tri_min.y > bh.y)
-    {
-      return 0;
-    }
-
-    if (tri_max.z < -bh.z || tri_min.z > bh.z)
+    if (tri_max.x < -bh.x || tri_min.x > bh.x ||
+        tri_max.y < -bh.y || tri_min.y > bh.y ||
+        tri_max.z < -bh.z || tri_min.z > bh.z)
     {
       return 0;
     }
@@ -366,78 +521,249 @@ MVX_API MVX_INLINE int mvx_triangle_box_overlap(
     float d = -mvx_v3_dot(n, v0);
     float rad = mvx_v3_dot(boxhalf, mvx_v3_abs(n)) + SLOP;
     if (d > rad || d < -rad)
+    {
       return 0;
+    }
   }
 
   return 1;
 }
 
-/* Aspect-ratio preserving, centered voxelizer with padding */
-MVX_API MVX_INLINE int mvx_voxelize_mesh(
-    float *vertices,              /* The array of vertex positions (x, y, z) for the mesh. */
-    unsigned long vertices_size,  /* The number of floats in the vertices array. This should be 3 times the number of vertices. */
-    int *indices,                 /* The array of triangle indices. Each triplet of indices forms a triangle. */
-    unsigned long indices_size,   /* The number of integers in the indices array. This should be 3 times the number of triangles. */
-    int grid_x,                   /* The total number of voxels along the x-axis of the grid. */
-    int grid_y,                   /* The total number of voxels along the y-axis of the grid. */
-    int grid_z,                   /* The total number of voxels along the z-axis of the grid. */
-    int grid_pad_x,               /* The number of empty voxels to pad on both the left and right sides of the grid. */
-    int grid_pad_y,               /* The number of empty voxels to pad on both the bottom and top sides of the grid. */
-    int grid_pad_z,               /* The number of empty voxels to pad on both the front and back sides of the grid. */
-    unsigned char *output_voxels) /* The output array of unsigned characters where the voxelized mesh will be stored. A value of 1 means the voxel is occupied. */
+/* Per-triangle constants of mvx_triangle_box_overlap for a fixed box half size
+ * (Schwarz-Seidel style setup). Everything that does not depend on the box center
+ * is computed once by mvx_triangle_setup_init. Coordinates are relative to v0.
+ */
+typedef struct mvx_triangle_setup
 {
-  unsigned long vcount = vertices_size / 3;
-  unsigned long tricount = indices_size / 3;
+  mvx_v3 v0, v1, v2; /* world space vertices (point in box shortcut) */
+  mvx_v3 boxhalf;    /* box half size the setup was computed for */
 
-  mvx_v3 min_b = mvx_v3_init(0, 0, 0);
-  mvx_v3 max_b = mvx_v3_init(0, 0, 0);
+  mvx_v3 n;         /* triangle normal */
+  float plane_rad;  /* box radius along the normal */
+  mvx_v3 tri_min;   /* triangle bounds relative to v0 */
+  mvx_v3 tri_max;
+  mvx_v3 bh;        /* box half size including slop */
 
-  int first = 1;
-  long total = (long)grid_x * (long)grid_y * (long)grid_z;
-  long q;
-  unsigned long t;
-  float vxsize;
+  /* 9 edge axes: the projection of the triangle onto axis i is [min, max].
+   * X family axis = (0, ax, bx), Y family = (ay, 0, by), Z family = (az, bz, 0)
+   */
+  float ax[3], bx[3], x_min[3], x_max[3], x_rad[3];
+  float ay[3], by[3], y_min[3], y_max[3], y_rad[3];
+  float az[3], bz[3], z_min[3], z_max[3], z_rad[3];
 
-  mvx_v3 size;
-  mvx_v3 effective_grid;
-  mvx_v3 need_v;
-  mvx_v3i margin;
+  mvx_stats *stats; /* optional counters of the tests (MVX_STATS), 0 after the init */
 
-  int ia, ib, ic;
+} mvx_triangle_setup;
 
-  mvx_v3 v0, v1, v2;
-  mvx_v3 tmin_b, tmax_b;
-  mvx_v3i i_min, i_max;
+MVX_API MVX_INLINE void mvx_triangle_setup_init(
+    mvx_triangle_setup *s,
+    mvx_v3 triv0, mvx_v3 triv1, mvx_v3 triv2,
+    mvx_v3 boxhalf)
+{
+  float SLOP = 1e-6f; /* absolute, world-space (same as mvx_triangle_box_overlap) */
 
-  int x, y, z;
+  /* move triangle to v0 space */
+  mvx_v3 p[3];
+  mvx_v3 e[3];
+  int i;
+
+  p[0] = mvx_v3_init(0.0f, 0.0f, 0.0f);
+  p[1] = mvx_v3_sub(triv1, triv0);
+  p[2] = mvx_v3_sub(triv2, triv0);
+
+  e[0] = p[1];
+  e[1] = mvx_v3_sub(p[2], p[1]);
+  e[2] = mvx_v3_sub(p[0], p[2]);
+
+  s->v0 = triv0;
+  s->stats = 0;
+  s->v1 = triv1;
+  s->v2 = triv2;
+  s->boxhalf = boxhalf;
 
-  if (!vertices || !indices || vcount == 0 || tricount == 0 || grid_x <= 0 || grid_y <= 0 || grid_z <= 0)
+  for (i = 0; i < 3; ++i)
   {
-    return 0;
+    mvx_v3 f = mvx_v3_abs(e[i]);
+    float p0, p1, p2;
+
+    /* X-axis family */
+    s->ax[i] = -e[i].z;
+    s->bx[i] = e[i].y;
+    p0 = p[0].y * s->ax[i] + p[0].z * s->bx[i];
+    p1 = p[1].y * s->ax[i] + p[1].z * s->bx[i];
+    p2 = p[2].y * s->ax[i] + p[2].z * s->bx[i];
+    s->x_min[i] = mvx_minf(mvx_minf(p0, p1), p2);
+    s->x_max[i] = mvx_maxf(mvx_maxf(p0, p1), p2);
+    s->x_rad[i] = boxhalf.y * f.z + boxhalf.z * f.y + SLOP;
+
+    /* Y-axis family */
+    s->ay[i] = e[i].z;
+    s->by[i] = -e[i].x;
+    p0 = p[0].x * s->ay[i] + p[0].z * s->by[i];
+    p1 = p[1].x * s->ay[i] + p[1].z * s->by[i];
+    p2 = p[2].x * s->ay[i] + p[2].z * s->by[i];
+    s->y_min[i] = mvx_minf(mvx_minf(p0, p1), p2);
+    s->y_max[i] = mvx_maxf(mvx_maxf(p0, p1), p2);
+    s->y_rad[i] = boxhalf.x * f.z + boxhalf.z * f.x + SLOP;
+
+    /* Z-axis family */
+    s->az[i] = -e[i].y;
+    s->bz[i] = e[i].x;
+    p0 = p[0].x * s->az[i] + p[0].y * s->bz[i];
+    p1 = p[1].x * s->az[i] + p[1].y * s->bz[i];
+    p2 = p[2].x * s->az[i] + p[2].y * s->bz[i];
+    s->z_min[i] = mvx_minf(mvx_minf(p0, p1), p2);
+    s->z_max[i] = mvx_maxf(mvx_maxf(p0, p1), p2);
+    s->z_rad[i] = boxhalf.x * f.y + boxhalf.y * f.x + SLOP;
   }
 
-  /* clear voxels */
-  for (q = 0; q < total; ++q)
+  /* AABB vs AABB */
+  s->tri_min = mvx_v3_min(p[0], mvx_v3_min(p[1], p[2]));
+  s->tri_max = mvx_v3_max(p[0], mvx_v3_max(p[1], p[2]));
+  s->bh = mvx_v3_add(boxhalf, mvx_v3_init(SLOP, SLOP, SLOP));
+
+  /* plane-box overlap */
+  s->n = mvx_v3_cross(e[0], e[1]);
+  s->plane_rad = mvx_v3_dot(boxhalf, mvx_v3_abs(s->n)) + SLOP;
+}
+
+/* Triangle-box overlap of a box with the half size of the setup centered at boxcenter.
+ * Includes the point in box shortcut for the three vertices.
+ */
+MVX_API MVX_INLINE int mvx_triangle_setup_overlap(mvx_triangle_setup *s, mvx_v3 boxcenter)
+{
+  float eps = 1e-6f;
+  mvx_v3 c;
+  int i;
+
+  if (mvx_point_in_box_eps_world(s->v0, boxcenter, s->boxhalf, eps) ||
+      mvx_point_in_box_eps_world(s->v1, boxcenter, s->boxhalf, eps) ||
+      mvx_point_in_box_eps_world(s->v2, boxcenter, s->boxhalf, eps))
   {
-    output_voxels[q] = 0;
+    return 1;
   }
 
-  /* mesh bounds */
-  for (t = 0; t < vcount; ++t)
+  c = mvx_v3_sub(boxcenter, s->v0);
+
+  for (i = 0; i < 3; ++i)
   {
-    mvx_v3 current_v = mvx_v3_init(vertices[3 * t + 0], vertices[3 * t + 1], vertices[3 * t + 2]);
+    float px = s->ax[i] * c.y + s->bx[i] * c.z;
+    float py = s->ay[i] * c.x + s->by[i] * c.z;
+    float pz = s->az[i] * c.x + s->bz[i] * c.y;
 
-    if (first)
+    if (s->x_max[i] - px < -s->x_rad[i] || s->x_min[i] - px > s->x_rad[i] ||
+        s->y_max[i] - py < -s->y_rad[i] || s->y_min[i] - py > s->y_rad[i] ||
+        s->z_max[i] - pz < -s->z_rad[i] || s->z_min[i] - pz > s->z_rad[i])
     {
-      min_b = max_b = current_v;
-      first = 0;
+      return 0;
     }
-    else
+  }
+
+  if (s->tri_max.x - c.x < -s->bh.x || s->tri_min.x - c.x > s->bh.x ||
+      s->tri_max.y - c.y < -s->bh.y || s->tri_min.y - c.y > s->bh.y ||
+      s->tri_max.z - c.z < -s->bh.z || s->tri_min.z - c.z > s->bh.z)
+  {
+    return 0;
+  }
+
+  {
+    float d = mvx_v3_dot(s->n, c);
+    if (d > s->plane_rad || d < -s->plane_rad)
     {
-      min_b = mvx_v3_min(min_b, current_v);
-      max_b = mvx_v3_max(max_b, current_v);
+      return 0;
     }
   }
+
+  return 1;
+}
+
+/* #############################################################################
+ * # Memory Arena
+ * #############################################################################
+ *
+ * mvx.h never allocates. Functions that need scratch memory take an arena
+ * over a caller supplied memory block (e.g. from VirtualAlloc or mmap) which
+ * should be aligned to MVX_ARENA_ALIGNMENT bytes.
+ */
+#define MVX_ARENA_ALIGNMENT 16
+
+typedef struct mvx_arena
+{
+  unsigned char *base;
+  unsigned long size;
+  unsigned long used;
+
+} mvx_arena;
+
+MVX_API MVX_INLINE void mvx_arena_init(mvx_arena *arena, void *memory, unsigned long memory_size)
+{
+  arena->base = (unsigned char *)memory;
+  arena->size = memory ? memory_size : 0;
+  arena->used = 0;
+}
+
+/* The number of bytes mvx_arena_push reserves for a request of "bytes" */
+MVX_API MVX_INLINE unsigned long mvx_arena_aligned_size(unsigned long bytes)
+{
+  return (bytes + (MVX_ARENA_ALIGNMENT - 1)) & ~(unsigned long)(MVX_ARENA_ALIGNMENT - 1);
+}
+
+/* Returns 0 if the arena is out of memory */
+MVX_API MVX_INLINE void *mvx_arena_push(mvx_arena *arena, unsigned long bytes)
+{
+  unsigned long aligned = mvx_arena_aligned_size(bytes);
+  void *result;
+
+  if (aligned > arena->size - arena->used)
+  {
+    return 0;
+  }
+
+  result = arena->base + arena->used;
+  arena->used += aligned;
+
+  return result;
+}
+
+MVX_API MVX_INLINE void mvx_arena_reset(mvx_arena *arena)
+{
+  arena->used = 0;
+}
+
+/* #############################################################################
+ * # Voxel Grid Mapping
+ * #############################################################################
+ */
+typedef struct mvx_grid
+{
+  int x;           /* The total number of voxels along the x-axis of the grid. */
+  int y;           /* The total number of voxels along the y-axis of the grid. */
+  int z;           /* The total number of voxels along the z-axis of the grid. */
+  mvx_v3 min_b;    /* World position that maps to the first voxel of the object (at margin). */
+  mvx_v3i margin;  /* Voxel offset of the object inside the grid (padding + centering). */
+  mvx_v3i need;    /* How many voxels the object actually needs along each axis. */
+  float vxsize;    /* Uniform world size of a single voxel. */
+
+} mvx_grid;
+
+/* Computes the aspect-ratio preserving, centered mapping of the bounds min_b..max_b into the grid */
+MVX_API MVX_INLINE int mvx_grid_fit_bounds(
+    mvx_grid *grid,
+    mvx_v3 min_b, mvx_v3 max_b,
+    int grid_x, int grid_y, int grid_z,
+    int grid_pad_x, int grid_pad_y, int grid_pad_z)
+{
+  float vxsize;
+
+  mvx_v3 size;
+  mvx_v3 effective_grid;
+  mvx_v3 need_v;
+
+  if (!grid || grid_x <= 0 || grid_y <= 0 || grid_z <= 0)
+  {
+    return 0;
+  }
+
   if (max_b.x <= min_b.x)
   {
     max_b.x = min_b.x + 1e-6f;
@@ -474,107 +800,6889 @@ MVX_API MVX_INLINE int mvx_voxelize_mesh(
 
   need_v = mvx_v3_min(need_v, effective_grid);
 
+  grid->x = grid_x;
+  grid->y = grid_y;
+  grid->z = grid_z;
+  grid->min_b = min_b;
+  grid->vxsize = vxsize;
+  grid->need = mvx_v3i_init((int)need_v.x, (int)need_v.y, (int)need_v.z);
+
   /* integer margins: the initial gap plus the centering margin within the effective grid */
-  margin = mvx_v3i_init(
+  grid->margin = mvx_v3i_init(
       grid_pad_x + mvx_floorf((effective_grid.x - need_v.x) / 2.0f),
       grid_pad_y + mvx_floorf((effective_grid.y - need_v.y) / 2.0f),
       grid_pad_z + mvx_floorf((effective_grid.z - need_v.z) / 2.0f));
 
-  /* triangle sweep */
-  for (t = 0; t < tricount; ++t)
-  {
-    ia = indices[3 * t + 0];
-    ib = indices[3 * t + 1];
-    ic = indices[3 * t + 2];
+  return 1;
+}
 
-    if (ia < 0 || ib < 0 || ic < 0)
-    {
-      continue;
-    }
+/* Computes the aspect-ratio preserving, centered mapping of the mesh vertices into the grid */
+MVX_API MVX_INLINE int mvx_grid_fit(
+    mvx_grid *grid,
+    float *vertices, unsigned long vertices_size,
+    int grid_x, int grid_y, int grid_z,
+    int grid_pad_x, int grid_pad_y, int grid_pad_z)
+{
+  unsigned long vcount = vertices_size / 3;
+  unsigned long t;
 
-    if ((unsigned long)ia >= vcount || (unsigned long)ib >= vcount || (unsigned long)ic >= vcount)
-    {
-      continue;
-    }
+  mvx_v3 min_b, max_b;
 
-    v0 = mvx_v3_init(vertices[3 * ia + 0], vertices[3 * ia + 1], vertices[3 * ia + 2]);
-    v1 = mvx_v3_init(vertices[3 * ib + 0], vertices[3 * ib + 1], vertices[3 * ib + 2]);
-    v2 = mvx_v3_init(vertices[3 * ic + 0], vertices[3 * ic + 1], vertices[3 * ic + 2]);
-
-    /* tri AABB in world */
-    tmin_b = mvx_v3_init(
-        mvx_minf(v0.x, mvx_minf(v1.x, v2.x)),
-        mvx_minf(v0.y, mvx_minf(v1.y, v2.y)),
-        mvx_minf(v0.z, mvx_minf(v1.z, v2.z)));
-
-    tmax_b = mvx_v3_init(
-        mvx_maxf(v0.x, mvx_maxf(v1.x, v2.x)),
-        mvx_maxf(v0.y, mvx_maxf(v1.y, v2.y)),
-        mvx_maxf(v0.z, mvx_maxf(v1.z, v2.z)));
-
-    /* map to voxel index range */
-    i_min = mvx_v3i_init(
-        mvx_floorf((tmin_b.x - min_b.x) / vxsize) + margin.x,
-        mvx_floorf((tmin_b.y - min_b.y) / vxsize) + margin.y,
-        mvx_floorf((tmin_b.z - min_b.z) / vxsize) + margin.z);
-
-    i_max = mvx_v3i_init(
-        mvx_ceilf((tmax_b.x - min_b.x) / vxsize) + margin.x,
-        mvx_ceilf((tmax_b.y - min_b.y) / vxsize) + margin.y,
-        mvx_ceilf((tmax_b.z - min_b.z) / vxsize) + margin.z);
-
-    /* clamp to object's voxel range and overall grid */
-    i_min.x = mvx_clampi(i_min.x, margin.x, margin.x + (int)need_v.x - 1);
-    i_min.y = mvx_clampi(i_min.y, margin.y, margin.y + (int)need_v.y - 1);
-    i_min.z = mvx_clampi(i_min.z, margin.z, margin.z + (int)need_v.z - 1);
-    i_max.x = mvx_clampi(i_max.x, margin.x, margin.x + (int)need_v.x - 1);
-    i_max.y = mvx_clampi(i_max.y, margin.y, margin.y + (int)need_v.y - 1);
-    i_max.z = mvx_clampi(i_max.z, margin.z, margin.z + (int)need_v.z - 1);
-
-    i_min.x = mvx_clampi(i_min.x, 0, grid_x - 1);
-    i_min.y = mvx_clampi(i_min.y, 0, grid_y - 1);
-    i_min.z = mvx_clampi(i_min.z, 0, grid_z - 1);
-    i_max.x = mvx_clampi(i_max.x, 0, grid_x - 1);
-    i_max.y = mvx_clampi(i_max.y, 0, grid_y - 1);
-    i_max.z = mvx_clampi(i_max.z, 0, grid_z - 1);
-
-    if (i_min.x > i_max.x || i_min.y > i_max.y || i_min.z > i_max.z)
-    {
-      continue;
-    }
+  if (!vertices || vcount == 0)
+  {
+    return 0;
+  }
 
-    /* scan candidate voxels */
-    for (z = i_min.z; z <= i_max.z; ++z)
-    {
-      for (y = i_min.y; y <= i_max.y; ++y)
-      {
-        for (x = i_min.x; x <= i_max.x; ++x)
-        {
-          mvx_v3 boxc, boxh;
-          float eps = 1e-6f;
-          /* world center of voxel (account for margins) */
-          boxc.x = min_b.x + ((float)(x - margin.x) + 0.5f) * vxsize;
-          boxc.y = min_b.y + ((float)(y - margin.y) + 0.5f) * vxsize;
-          boxc.z = min_b.z + ((float)(z - margin.z) + 0.5f) * vxsize;
-          boxh.x = boxh.y = boxh.z = 0.5f * vxsize;
-
-          if (mvx_point_in_box_eps_world(v0, boxc, boxh, eps) ||
-              mvx_point_in_box_eps_world(v1, boxc, boxh, eps) ||
-              mvx_point_in_box_eps_world(v2, boxc, boxh, eps) ||
-              mvx_triangle_box_overlap(boxc, boxh, v0, v1, v2))
-          {
-            long id = (long)x + (long)y * grid_x + (long)z * grid_x * grid_y;
+  /* mesh bounds */
+  min_b = max_b = mvx_v3_init(vertices[0], vertices[1], vertices[2]);
 
-            output_voxels[id] = 1;
-          }
-        }
-      }
-    }
+  for (t = 1; t < vcount; ++t)
+  {
+    mvx_v3 current_v = mvx_v3_init(vertices[3 * t + 0], vertices[3 * t + 1], vertices[3 * t + 2]);
+    min_b = mvx_v3_min(min_b, current_v);
+    max_b = mvx_v3_max(max_b, current_v);
   }
 
+  return mvx_grid_fit_bounds(grid, min_b, max_b, grid_x, grid_y, grid_z, grid_pad_x, grid_pad_y, grid_pad_z);
+}
+
+/* Explicit mapping: voxel (0, 0, 0) starts at origin and the object owns the whole grid
+ * (no margin). Geometry outside of the grid is culled instead of fitted.
+ */
+MVX_API MVX_INLINE int mvx_grid_init(
+    mvx_grid *grid,
+    mvx_v3 origin, float vxsize,
+    int grid_x, int grid_y, int grid_z)
+{
+  if (!grid || !(vxsize > 0.0f) || grid_x <= 0 || grid_y <= 0 || grid_z <= 0)
+  {
+    return 0;
+  }
+
+  grid->x = grid_x;
+  grid->y = grid_y;
+  grid->z = grid_z;
+  grid->min_b = origin;
+  grid->vxsize = vxsize;
+  grid->need = mvx_v3i_init(grid_x, grid_y, grid_z);
+  grid->margin = mvx_v3i_init(0, 0, 0);
+
   return 1;
 }
 
+/* Index range of the voxels (over the whole grid, margins included) whose centers lie in [lo, hi] along one axis */
+MVX_API MVX_INLINE int mvx_grid_center_range(float lo, float hi, float min_b, float vxsize, int margin, int count, int *begin, int *end)
+{
+  float f_begin = (lo - min_b) / vxsize + (float)margin - 0.5f;
+  float f_end = (hi - min_b) / vxsize + (float)margin - 0.5f;
+
+  /* keep far away values in int range */
+  *begin = mvx_maxi(mvx_ceilf(mvx_clampf(f_begin, -1.0f, (float)count)), 0);
+  *end = mvx_mini(mvx_floorf(mvx_clampf(f_end, -1.0f, (float)count)), count - 1);
+
+  return *begin <= *end;
+}
+
+/* world center of voxel (account for margins) */
+MVX_API MVX_INLINE mvx_v3 mvx_grid_voxel_center(mvx_grid *grid, int x, int y, int z)
+{
+  mvx_v3 result;
+  result.x = grid->min_b.x + ((float)(x - grid->margin.x) + 0.5f) * grid->vxsize;
+  result.y = grid->min_b.y + ((float)(y - grid->margin.y) + 0.5f) * grid->vxsize;
+  result.z = grid->min_b.z + ((float)(z - grid->margin.z) + 0.5f) * grid->vxsize;
+  return result;
+}
+
+/* Candidate voxel index range (inclusive) of a world space box. Returns 0 if the range is empty
+ * (boxes outside of the object's voxel range are culled).
+ */
+MVX_API MVX_INLINE int mvx_grid_box_range(
+    mvx_grid *grid,
+    mvx_v3 tmin_b, mvx_v3 tmax_b,
+    mvx_v3i *i_min_out, mvx_v3i *i_max_out)
+{
+  mvx_v3 f_min, f_max, f_need;
+  mvx_v3i i_min, i_max;
+  mvx_v3i margin = grid->margin;
+  mvx_v3i need = grid->need;
+  mvx_v3 min_b = grid->min_b;
+  float vxsize = grid->vxsize;
+
+  /* voxel coordinates relative to the object's voxel range [0, need] */
+  f_min = mvx_v3_init(
+      (tmin_b.x - min_b.x) / vxsize,
+      (tmin_b.y - min_b.y) / vxsize,
+      (tmin_b.z - min_b.z) / vxsize);
+  f_max = mvx_v3_init(
+      (tmax_b.x - min_b.x) / vxsize,
+      (tmax_b.y - min_b.y) / vxsize,
+      (tmax_b.z - min_b.z) / vxsize);
+  f_need = mvx_v3_init((float)need.x, (float)need.y, (float)need.z);
+
+  if (f_max.x < 0.0f || f_max.y < 0.0f || f_max.z < 0.0f ||
+      f_min.x > f_need.x || f_min.y > f_need.y || f_min.z > f_need.z)
+  {
+    return 0;
+  }
+
+  /* keep far away vertices in int range */
+  f_min = mvx_v3_max_scalar(f_min, -1.0f);
+  f_max = mvx_v3_min(f_max, mvx_v3_init(f_need.x + 1.0f, f_need.y + 1.0f, f_need.z + 1.0f));
+
+  /* map to voxel index range */
+  i_min = mvx_v3i_init(
+      mvx_floorf(f_min.x) + margin.x,
+      mvx_floorf(f_min.y) + margin.y,
+      mvx_floorf(f_min.z) + margin.z);
+
+  i_max = mvx_v3i_init(
+      mvx_ceilf(f_max.x) + margin.x,
+      mvx_ceilf(f_max.y) + margin.y,
+      mvx_ceilf(f_max.z) + margin.z);
+
+  /* clamp to object's voxel range and overall grid */
+  i_min.x = mvx_clampi(i_min.x, margin.x, margin.x + need.x - 1);
+  i_min.y = mvx_clampi(i_min.y, margin.y, margin.y + need.y - 1);
+  i_min.z = mvx_clampi(i_min.z, margin.z, margin.z + need.z - 1);
+  i_max.x = mvx_clampi(i_max.x, margin.x, margin.x + need.x - 1);
+  i_max.y = mvx_clampi(i_max.y, margin.y, margin.y + need.y - 1);
+  i_max.z = mvx_clampi(i_max.z, margin.z, margin.z + need.z - 1);
+
+  i_min.x = mvx_clampi(i_min.x, 0, grid->x - 1);
+  i_min.y = mvx_clampi(i_min.y, 0, grid->y - 1);
+  i_min.z = mvx_clampi(i_min.z, 0, grid->z - 1);
+  i_max.x = mvx_clampi(i_max.x, 0, grid->x - 1);
+  i_max.y = mvx_clampi(i_max.y, 0, grid->y - 1);
+  i_max.z = mvx_clampi(i_max.z, 0, grid->z - 1);
+
+  *i_min_out = i_min;
+  *i_max_out = i_max;
+
+  return !(i_min.x > i_max.x || i_min.y > i_max.y || i_min.z > i_max.z);
+}
+
+/* Candidate voxel index range (inclusive) of a triangle. Returns 0 if the range is empty. */
+MVX_API MVX_INLINE int mvx_grid_triangle_range(
+    mvx_grid *grid,
+    mvx_v3 v0, mvx_v3 v1, mvx_v3 v2,
+    mvx_v3i *i_min_out, mvx_v3i *i_max_out)
+{
+  /* tri AABB in world */
+  mvx_v3 tmin_b = mvx_v3_init(
+      mvx_minf(v0.x, mvx_minf(v1.x, v2.x)),
+      mvx_minf(v0.y, mvx_minf(v1.y, v2.y)),
+      mvx_minf(v0.z, mvx_minf(v1.z, v2.z)));
+
+  mvx_v3 tmax_b = mvx_v3_init(
+      mvx_maxf(v0.x, mvx_maxf(v1.x, v2.x)),
+      mvx_maxf(v0.y, mvx_maxf(v1.y, v2.y)),
+      mvx_maxf(v0.z, mvx_maxf(v1.z, v2.z)));
+
+  return mvx_grid_box_range(grid, tmin_b, tmax_b, i_min_out, i_max_out);
+}
+
+/* #############################################################################
+ * # Bit-packed Voxel Grid
+ * #############################################################################
+ *
+ * One bit per voxel. Every (y, z) row along the x-axis starts at a new word and
+ * is padded up to the next multiple of MVX_BITS_PER_WORD voxels. The padding
+ * bits are always zero.
+ *
+ *   word = (y + z * grid_y) * mvx_bits_row_words(grid_x) + x / MVX_BITS_PER_WORD
+ *   bit  = x % MVX_BITS_PER_WORD
+ */
+#define MVX_BITS_PER_WORD 32
+
+MVX_API MVX_INLINE int mvx_bits_row_words(int grid_x)
+{
+  return (grid_x + MVX_BITS_PER_WORD - 1) / MVX_BITS_PER_WORD;
+}
+
+/* The number of unsigned int words required for a bit-packed grid */
+MVX_API MVX_INLINE long mvx_bits_size(int grid_x, int grid_y, int grid_z)
+{
+  return (long)mvx_bits_row_words(grid_x) * (long)grid_y * (long)grid_z;
+}
+
+MVX_API MVX_INLINE int mvx_bits_get(unsigned int *bits, int grid_x, int grid_y, int x, int y, int z)
+{
+  long id = ((long)y + (long)z * grid_y) * mvx_bits_row_words(grid_x) + x / MVX_BITS_PER_WORD;
+  return (int)((bits[id] >> (x % MVX_BITS_PER_WORD)) & 1u);
+}
+
+/* #############################################################################
+ * # Occupancy Level of Detail
+ * #############################################################################
+ *
+ * Mip chain of bit-packed grids: a voxel of level l + 1 is set if any of the
+ * 2x2x2 voxels of level l it covers is set. Level l + 1 has ceil(size / 2)
+ * voxels per axis, the chain ends at 1x1x1. Each coarse row ORs four fine rows
+ * and folds the bit pairs of every word, so a level costs a fraction of the
+ * words of the previous one and no triangle is swept again.
+ *
+ * Optionally every coarse voxel also gets its coverage count (0..8 set fine
+ * voxels) as one byte in linear order.
+ */
+#define MVX_LOD_MAX_LEVELS 32
+
+typedef struct mvx_lod_level
+{
+  int x, y, z;           /* Size in voxels. */
+  unsigned int *bits;    /* mvx_bits_size(x, y, z) words. */
+  unsigned char *counts; /* Optional: x * y * z coverage counts (0 for level 0). */
+
+} mvx_lod_level;
+
+typedef struct mvx_lod
+{
+  int level_count;
+  mvx_lod_level levels[MVX_LOD_MAX_LEVELS]; /* levels[0] is the input grid */
+
+} mvx_lod;
+
+/* The number of levels down to 1x1x1, including the input */
+MVX_API MVX_INLINE int mvx_lod_level_count(int grid_x, int grid_y, int grid_z)
+{
+  int count = 1;
+
+  while (grid_x > 1 || grid_y > 1 || grid_z > 1)
+  {
+    grid_x = (grid_x + 1) / 2;
+    grid_y = (grid_y + 1) / 2;
+    grid_z = (grid_z + 1) / 2;
+    ++count;
+  }
+
+  return count;
+}
+
+/* Bytes for the levels 1..level_count - 1, level_count 0 for the whole chain */
+MVX_API MVX_INLINE unsigned long mvx_lod_memory_size(int grid_x, int grid_y, int grid_z, int level_count, int with_counts)
+{
+  unsigned long size = 0;
+  int l;
+
+  if (level_count <= 0)
+  {
+    level_count = mvx_lod_level_count(grid_x, grid_y, grid_z);
+  }
+
+  for (l = 1; l < level_count; ++l)
+  {
+    grid_x = (grid_x + 1) / 2;
+    grid_y = (grid_y + 1) / 2;
+    grid_z = (grid_z + 1) / 2;
+
+    size += mvx_arena_aligned_size((unsigned long)mvx_bits_size(grid_x, grid_y, grid_z) * (unsigned long)sizeof(unsigned int));
+
+    if (with_counts)
+    {
+      size += mvx_arena_aligned_size((unsigned long)grid_x * (unsigned long)grid_y * (unsigned long)grid_z);
+    }
+  }
+
+  return size;
+}
+
+/* Moves the even bits of v into the lower 16 bits */
+MVX_API MVX_INLINE unsigned int mvx_lod_compact2(unsigned int v)
+{
+#if defined(MVX_USE_BMI2)
+  return _pext_u32(v, 0x55555555u);
+#else
+  v &= 0x55555555u;
+  v = (v | (v >> 1)) & 0x33333333u;
+  v = (v | (v >> 2)) & 0x0F0F0F0Fu;
+  v = (v | (v >> 4)) & 0x00FF00FFu;
+  v = (v | (v >> 8)) & 0x0000FFFFu;
+  return v;
+#endif
+}
+
+/* One 2x2x2 reduction of the fine level into the coarse level (sizes already set) */
+MVX_API MVX_INLINE void mvx_lod_reduce(mvx_lod_level *fine, mvx_lod_level *coarse)
+{
+  int fine_words = mvx_bits_row_words(fine->x);
+  int coarse_words = mvx_bits_row_words(coarse->x);
+  int y, z, k, r, h, c;
+
+  for (z = 0; z < coarse->z; ++z)
+  {
+    for (y = 0; y < coarse->y; ++y)
+    {
+      unsigned int *rows[4];
+      unsigned int *out = coarse->bits + ((long)y + (long)z * coarse->y) * coarse_words;
+      int has_y = 2 * y + 1 < fine->y;
+      int has_z = 2 * z + 1 < fine->z;
+
+      /* the last coarse row of an odd size only covers one fine row, it is repeated for the OR */
+      for (r = 0; r < 4; ++r)
+      {
+        int fy = 2 * y + ((r & 1) && has_y);
+        int fz = 2 * z + ((r >> 1) && has_z);
+        rows[r] = fine->bits + ((long)fy + (long)fz * fine->y) * fine_words;
+      }
+
+      for (k = 0; k < coarse_words; ++k)
+      {
+        unsigned int word = 0;
+
+        /* each fine word becomes one half of the coarse word */
+        for (h = 0; h < 2 && 2 * k + h < fine_words; ++h)
+        {
+          int i = 2 * k + h;
+          unsigned int v = rows[0][i] | rows[1][i] | rows[2][i] | rows[3][i];
+
+          word |= mvx_lod_compact2(v | (v >> 1)) << (16 * h);
+
+          if (coarse->counts)
+          {
+            /* pair counts of the rows that exist, summed in 4 bit fields for the even and odd pairs */
+            unsigned int even = 0;
+            unsigned int odd = 0;
+            int x0 = (k * MVX_BITS_PER_WORD) + 16 * h;
+
+            for (r = 0; r < 4; ++r)
+            {
+              unsigned int p;
+
+              if (((r & 1) && !has_y) || ((r >> 1) && !has_z))
+              {
+                continue;
+              }
+
+              p = (rows[r][i] & 0x55555555u) + ((rows[r][i] >> 1) & 0x55555555u);
+              even += p & 0x33333333u;
+              odd += (p >> 2) & 0x33333333u;
+            }
+
+            for (c = 0; c < 16 && x0 + c < coarse->x; ++c)
+            {
+              unsigned int fields = (c & 1) ? odd : even;
+              coarse->counts[x0 + c + (long)y * coarse->x + (long)z * coarse->x * coarse->y] = (unsigned char)((fields >> (4 * (c >> 1))) & 15u);
+            }
+          }
+        }
+
+        out[k] = word;
+      }
+    }
+  }
+}
+
+/* Builds the levels 1..level_count - 1 of a bit-packed grid (e.g. from mvx_voxelize_mesh_bits).
+ * level_count 0 builds the whole chain, see mvx_lod_level_count.
+ */
+MVX_API MVX_INLINE int mvx_lod_build(
+    unsigned int *bits, int grid_x, int grid_y, int grid_z,
+    int level_count,
+    int with_counts,                         /* 1 to also store the coverage counts. */
+    void *memory, unsigned long memory_size, /* See mvx_lod_memory_size. */
+    mvx_lod *lod)
+{
+  mvx_arena arena;
+  int l;
+
+  if (!bits || !lod || grid_x <= 0 || grid_y <= 0 || grid_z <= 0)
+  {
+    return 0;
+  }
+
+  if (level_count <= 0)
+  {
+    level_count = mvx_lod_level_count(grid_x, grid_y, grid_z);
+  }
+
+  if (level_count > MVX_LOD_MAX_LEVELS)
+  {
+    return 0;
+  }
+
+  mvx_arena_init(&arena, memory, memory_size);
+
+  lod->level_count = level_count;
+  lod->levels[0].x = grid_x;
+  lod->levels[0].y = grid_y;
+  lod->levels[0].z = grid_z;
+  lod->levels[0].bits = bits;
+  lod->levels[0].counts = 0;
+
+  for (l = 1; l < level_count; ++l)
+  {
+    mvx_lod_level *level = &lod->levels[l];
+
+    level->x = (lod->levels[l - 1].x + 1) / 2;
+    level->y = (lod->levels[l - 1].y + 1) / 2;
+    level->z = (lod->levels[l - 1].z + 1) / 2;
+    level->bits = (unsigned int *)mvx_arena_push(&arena, (unsigned long)mvx_bits_size(level->x, level->y, level->z) * (unsigned long)sizeof(unsigned int));
+    level->counts = with_counts ? (unsigned char *)mvx_arena_push(&arena, (unsigned long)level->x * (unsigned long)level->y * (unsigned long)level->z) : 0;
+
+    if (!level->bits || (with_counts && !level->counts))
+    {
+      return 0;
+    }
+
+    mvx_lod_reduce(&lod->levels[l - 1], level);
+  }
+
+  return 1;
+}
+
+/* #############################################################################
+ * # Sparse Brick Map
+ * #############################################################################
+ *
+ * Two-level sparse occupancy: a coarse index with one entry per brick of
+ * MVX_BRICK_SIZE^3 voxels and a pool of dense bit bricks that are only
+ * allocated where triangles land. Memory scales with the surface area.
+ *
+ *   index[bx + by * count.x + bz * count.x * count.y] = 0 (empty) or 1 + brick number
+ *   brick words = bricks + (brick number) * MVX_BRICK_WORDS
+ *   bit (lx + MVX_BRICK_SIZE * (ly + MVX_BRICK_SIZE * lz)) of the brick, 32 bits per word
+ *
+ * So every local row (ly, lz) of a brick is one byte of its words.
+ */
+#define MVX_BRICK_SIZE 8
+#define MVX_BRICK_WORDS 16
+
+typedef struct mvx_brickmap
+{
+  int grid_x;                  /* Grid size in voxels. */
+  int grid_y;
+  int grid_z;
+  mvx_v3i count;               /* Number of bricks along each axis. */
+  unsigned int *index;         /* count.x * count.y * count.z entries. */
+  unsigned int *bricks;        /* brick_count * MVX_BRICK_WORDS words, contiguous. */
+  unsigned int brick_count;    /* Allocated bricks. */
+  unsigned int brick_capacity; /* Bricks that fit into the memory block. */
+  int overflow;                /* Set if a brick could not be allocated. */
+
+} mvx_brickmap;
+
+MVX_API MVX_INLINE long mvx_brickmap_index_count(int grid_x, int grid_y, int grid_z)
+{
+  return (long)((grid_x + MVX_BRICK_SIZE - 1) / MVX_BRICK_SIZE) *
+         (long)((grid_y + MVX_BRICK_SIZE - 1) / MVX_BRICK_SIZE) *
+         (long)((grid_z + MVX_BRICK_SIZE - 1) / MVX_BRICK_SIZE);
+}
+
+/* Takes the index from the arena and uses the rest of it as brick pool. Returns 0 if the index does not fit. */
+MVX_API MVX_INLINE int mvx_brickmap_init(mvx_brickmap *map, int grid_x, int grid_y, int grid_z, mvx_arena *arena)
+{
+  long entries = mvx_brickmap_index_count(grid_x, grid_y, grid_z);
+  unsigned long pool;
+  long i;
+
+  map->grid_x = grid_x;
+  map->grid_y = grid_y;
+  map->grid_z = grid_z;
+  map->count = mvx_v3i_init(
+      (grid_x + MVX_BRICK_SIZE - 1) / MVX_BRICK_SIZE,
+      (grid_y + MVX_BRICK_SIZE - 1) / MVX_BRICK_SIZE,
+      (grid_z + MVX_BRICK_SIZE - 1) / MVX_BRICK_SIZE);
+  map->index = (unsigned int *)mvx_arena_push(arena, (unsigned long)entries * (unsigned long)sizeof(unsigned int));
+  map->brick_count = 0;
+  map->overflow = 0;
+
+  if (!map->index)
+  {
+    return 0;
+  }
+
+  for (i = 0; i < entries; ++i)
+  {
+    map->index[i] = 0;
+  }
+
+  pool = (arena->size - arena->used) / (MVX_BRICK_WORDS * (unsigned long)sizeof(unsigned int));
+  map->bricks = (unsigned int *)(arena->base + arena->used);
+  map->brick_capacity = (unsigned int)(pool > 0xFFFFFFFEul ? 0xFFFFFFFEul : pool);
+
+  return 1;
+}
+
+/* Marks the bricks allocated so far as used in the arena */
+MVX_API MVX_INLINE void mvx_brickmap_commit(mvx_brickmap *map, mvx_arena *arena)
+{
+  arena->used += (unsigned long)map->brick_count * MVX_BRICK_WORDS * (unsigned long)sizeof(unsigned int);
+}
+
+/* Returns the words of brick (bx, by, bz), allocating it if needed (0 if the pool is exhausted) */
+MVX_API MVX_INLINE unsigned int *mvx_brickmap_brick(mvx_brickmap *map, int bx, int by, int bz)
+{
+  long id = bx + by * map->count.x + (long)bz * map->count.x * map->count.y;
+  unsigned int *brick;
+  int i;
+
+  if (map->index[id])
+  {
+    return map->bricks + (unsigned long)(map->index[id] - 1) * MVX_BRICK_WORDS;
+  }
+
+  if (map->brick_count >= map->brick_capacity)
+  {
+    map->overflow = 1;
+    return 0;
+  }
+
+  brick = map->bricks + (unsigned long)map->brick_count * MVX_BRICK_WORDS;
+  for (i = 0; i < MVX_BRICK_WORDS; ++i)
+  {
+    brick[i] = 0;
+  }
+
+  map->index[id] = ++map->brick_count;
+
+  return brick;
+}
+
+MVX_API MVX_INLINE int mvx_brickmap_get(mvx_brickmap *map, int x, int y, int z)
+{
+  unsigned int entry = map->index[x / MVX_BRICK_SIZE + (y / MVX_BRICK_SIZE) * map->count.x + (long)(z / MVX_BRICK_SIZE) * map->count.x * map->count.y];
+  int bit;
+
+  if (!entry)
+  {
+    return 0;
+  }
+
+  bit = x % MVX_BRICK_SIZE + MVX_BRICK_SIZE * (y % MVX_BRICK_SIZE + MVX_BRICK_SIZE * (z % MVX_BRICK_SIZE));
+
+  return (int)((map->bricks[(unsigned long)(entry - 1) * MVX_BRICK_WORDS + (unsigned long)(bit / 32)] >> (bit % 32)) & 1u);
+}
+
+/* #############################################################################
+ * # Voxel Reference Counts
+ * #############################################################################
+ *
+ * For incremental updates every voxel keeps the number of triangles that
+ * overlap it. Adding a triangle increments the counts of its voxels, removing
+ * it runs the exact same sweep and decrements them again, so a voxel is set
+ * as long as any triangle still covers it.
+ */
+typedef struct mvx_counts
+{
+  unsigned short *counts; /* One count per voxel (grid_x * grid_y * grid_z). */
+  unsigned char *voxels;  /* 1 while the count of the voxel is not 0. */
+  int delta;              /* +1 while adding a triangle, -1 while removing one. */
+  int overflow;           /* Set if a count would exceed 65535. */
+
+} mvx_counts;
+
+/* Applies delta to voxel id */
+MVX_API MVX_INLINE void mvx_counts_apply(mvx_counts *counts, long id)
+{
+  unsigned short c = counts->counts[id];
+
+  if (counts->delta > 0)
+  {
+    if (c == 0xFFFFu)
+    {
+      counts->overflow = 1;
+      return;
+    }
+
+    ++c;
+  }
+  else if (c > 0)
+  {
+    --c;
+  }
+
+  counts->counts[id] = c;
+  counts->voxels[id] = c ? 1 : 0;
+}
+
+/* #############################################################################
+ * # Voxel Attributes
+ * #############################################################################
+ *
+ * Optional per voxel channels written during the triangle sweep, so the mesh
+ * does not have to be queried again for every set voxel. Every channel has
+ * its own write loop and is skipped if its array is 0. Only surface voxels
+ * get attributes, the interior of a solid voxelization stays MVX_ATTRIBUTE_NONE.
+ */
+#define MVX_ATTRIBUTE_NONE 0xFFFFFFFFu
+
+typedef struct mvx_attributes
+{
+  unsigned int *triangles;          /* Optional: first (lowest index) triangle overlapping the voxel. */
+  unsigned int *materials;          /* Optional: triangle_materials entry of that triangle. */
+  float *normals;                   /* Optional: 3 floats per voxel, sum of the area weighted normals of all
+                                       overlapping triangles (normalize it for the average normal). */
+  unsigned int *triangle_materials; /* Material id per triangle, required for materials. */
+
+} mvx_attributes;
+
+/* Resets the voxels first..end - 1 */
+MVX_API MVX_INLINE void mvx_attributes_clear(mvx_attributes *attributes, long first, long end)
+{
+  long q;
+
+  if (attributes->triangles)
+  {
+    for (q = first; q < end; ++q)
+    {
+      attributes->triangles[q] = MVX_ATTRIBUTE_NONE;
+    }
+  }
+
+  if (attributes->materials)
+  {
+    for (q = first; q < end; ++q)
+    {
+      attributes->materials[q] = MVX_ATTRIBUTE_NONE;
+    }
+  }
+
+  if (attributes->normals)
+  {
+    for (q = 3 * first; q < 3 * end; ++q)
+    {
+      attributes->normals[q] = 0.0f;
+    }
+  }
+}
+
+/* Triangles are swept in ascending order (per slab, brick and job), so the first one that
+ * reaches a voxel has the lowest index.
+ */
+MVX_API MVX_INLINE void mvx_attributes_write_triangle(unsigned int *channel, long id, unsigned int mask, unsigned int value)
+{
+  for (; mask; mask >>= 1, ++id)
+  {
+    if ((mask & 1u) && channel[id] == MVX_ATTRIBUTE_NONE)
+    {
+      channel[id] = value;
+    }
+  }
+}
+
+MVX_API MVX_INLINE void mvx_attributes_write_normal(float *normals, long id, unsigned int mask, mvx_v3 n)
+{
+  for (; mask; mask >>= 1, ++id)
+  {
+    if (mask & 1u)
+    {
+      normals[3 * id + 0] += n.x;
+      normals[3 * id + 1] += n.y;
+      normals[3 * id + 2] += n.z;
+    }
+  }
+}
+
+/* #############################################################################
+ * # Run-Length Encoded Rows
+ * #############################################################################
+ *
+ * Every (y, z) row along the x-axis is stored as a sorted list of disjoint
+ * spans of occupied voxels. The sweep appends the x interval every triangle
+ * covers on a row (one record per triangle and row, the word chunks are joined
+ * on the fly), mvx_rle_finish then sorts the records by row and merges the
+ * overlapping and touching intervals.
+ */
+typedef struct mvx_span
+{
+  int begin; /* first occupied voxel */
+  int end;   /* one past the last occupied voxel */
+
+} mvx_span;
+
+typedef struct mvx_rle_record
+{
+  unsigned long row; /* y + z * grid_y */
+  mvx_span span;
+
+} mvx_rle_record;
+
+typedef struct mvx_rle
+{
+  int x, y, z;
+  unsigned long *rows;  /* y * z + 1 offsets: row (y, z) are the spans rows[r]..rows[r + 1] - 1, r = y + z * grid_y */
+  mvx_span *spans;
+  unsigned long span_count;
+
+  mvx_rle_record *records; /* build: the triangle intervals in sweep order */
+  unsigned long record_count;
+  unsigned long record_capacity;
+  int overflow;            /* build: more records than record_capacity */
+
+} mvx_rle;
+
+MVX_API MVX_INLINE unsigned long mvx_rle_rows_size(int grid_y, int grid_z)
+{
+  return mvx_arena_aligned_size(((unsigned long)grid_y * (unsigned long)grid_z + 1) * (unsigned long)sizeof(unsigned long));
+}
+
+/* Bytes of rows, records and spans for a grid and a record_capacity */
+MVX_API MVX_INLINE unsigned long mvx_rle_memory_size(int grid_y, int grid_z, unsigned long record_capacity)
+{
+  return mvx_rle_rows_size(grid_y, grid_z) + 2 * MVX_ARENA_ALIGNMENT +
+         record_capacity * (unsigned long)(sizeof(mvx_rle_record) + sizeof(mvx_span));
+}
+
+/* The largest record_capacity that fits into memory_size bytes */
+MVX_API MVX_INLINE unsigned long mvx_rle_capacity(int grid_y, int grid_z, unsigned long memory_size)
+{
+  unsigned long fixed = mvx_rle_memory_size(grid_y, grid_z, 0);
+
+  return memory_size > fixed ? (memory_size - fixed) / (unsigned long)(sizeof(mvx_rle_record) + sizeof(mvx_span)) : 0;
+}
+
+/* An empty rle for the build, returns 0 if the arena is too small */
+MVX_API MVX_INLINE int mvx_rle_init(mvx_rle *rle, int grid_x, int grid_y, int grid_z, unsigned long record_capacity, mvx_arena *arena)
+{
+  rle->x = grid_x;
+  rle->y = grid_y;
+  rle->z = grid_z;
+  rle->rows = (unsigned long *)mvx_arena_push(arena, mvx_rle_rows_size(grid_y, grid_z));
+  rle->records = (mvx_rle_record *)mvx_arena_push(arena, record_capacity * (unsigned long)sizeof(mvx_rle_record));
+  rle->spans = (mvx_span *)mvx_arena_push(arena, record_capacity * (unsigned long)sizeof(mvx_span));
+  rle->span_count = 0;
+  rle->record_count = 0;
+  rle->record_capacity = record_capacity;
+  rle->overflow = 0;
+
+  return rle->rows && ((rle->records && rle->spans) || record_capacity == 0);
+}
+
+/* Appends the runs of a row chunk mask starting at voxel x */
+MVX_API MVX_INLINE void mvx_rle_append(mvx_rle *rle, unsigned long row, int x, unsigned int mask)
+{
+  while (mask)
+  {
+    int begin;
+
+    for (; !(mask & 1u); mask >>= 1)
+    {
+      ++x;
+    }
+
+    for (begin = x; mask & 1u; mask >>= 1)
+    {
+      ++x;
+    }
+
+    /* join the chunks of the same triangle */
+    if (rle->record_count > 0 &&
+        rle->records[rle->record_count - 1].row == row &&
+        rle->records[rle->record_count - 1].span.end == begin)
+    {
+      rle->records[rle->record_count - 1].span.end = x;
+    }
+    else if (rle->record_count < rle->record_capacity)
+    {
+      rle->records[rle->record_count].row = row;
+      rle->records[rle->record_count].span.begin = begin;
+      rle->records[rle->record_count].span.end = x;
+      rle->record_count++;
+    }
+    else
+    {
+      rle->overflow = 1;
+    }
+  }
+}
+
+/* Sorts the records into rows and merges them to spans, returns 0 if records were lost */
+MVX_API MVX_INLINE int mvx_rle_finish(mvx_rle *rle)
+{
+  unsigned long row_count = (unsigned long)rle->y * (unsigned long)rle->z;
+  unsigned long r, i, j, total = 0;
+
+  if (rle->overflow)
+  {
+    return 0;
+  }
+
+  for (r = 0; r <= row_count; ++r)
+  {
+    rle->rows[r] = 0;
+  }
+
+  /* counting sort by row, keeps the sweep order within a row */
+  for (i = 0; i < rle->record_count; ++i)
+  {
+    rle->rows[rle->records[i].row]++;
+  }
+
+  for (r = 0; r < row_count; ++r)
+  {
+    unsigned long c = rle->rows[r];
+    rle->rows[r] = total;
+    total += c;
+  }
+  rle->rows[row_count] = total;
+
+  for (i = 0; i < rle->record_count; ++i)
+  {
+    rle->spans[rle->rows[rle->records[i].row]++] = rle->records[i].span;
+  }
+
+  /* rows[r] is now the end of row r, merge and move the starts back */
+  for (r = 0, i = 0, total = 0; r < row_count; ++r)
+  {
+    unsigned long begin = i;
+    unsigned long end = rle->rows[r];
+    unsigned long first = total;
+
+    /* rows hold few intervals, mostly in order already */
+    for (i = begin + 1; i < end; ++i)
+    {
+      mvx_span s = rle->spans[i];
+
+      for (j = i; j > begin && rle->spans[j - 1].begin > s.begin; --j)
+      {
+        rle->spans[j] = rle->spans[j - 1];
+      }
+      rle->spans[j] = s;
+    }
+
+    /* in place, total never passes i */
+    for (i = begin; i < end; ++i)
+    {
+      if (total > first && rle->spans[i].begin <= rle->spans[total - 1].end)
+      {
+        rle->spans[total - 1].end = mvx_maxi(rle->spans[total - 1].end, rle->spans[i].end);
+      }
+      else
+      {
+        rle->spans[total++] = rle->spans[i];
+      }
+    }
+
+    rle->rows[r] = first;
+  }
+
+  rle->rows[row_count] = total;
+  rle->span_count = total;
+
+  return 1;
+}
+
+/* The spans of row (y, z), count receives their number */
+MVX_API MVX_INLINE mvx_span *mvx_rle_row_spans(mvx_rle *rle, int y, int z, unsigned long *count)
+{
+  unsigned long r = (unsigned long)y + (unsigned long)z * (unsigned long)rle->y;
+
+  *count = rle->rows[r + 1] - rle->rows[r];
+  return rle->spans + rle->rows[r];
+}
+
+/* Expands row (y, z) into x bytes (1 = occupied) */
+MVX_API MVX_INLINE void mvx_rle_decode_row(mvx_rle *rle, int y, int z, unsigned char *row)
+{
+  unsigned long count, i;
+  mvx_span *spans = mvx_rle_row_spans(rle, y, z, &count);
+  int x = 0;
+
+  for (i = 0; i < count; ++i)
+  {
+    for (; x < spans[i].begin; ++x)
+    {
+      row[x] = 0;
+    }
+    for (; x < spans[i].end; ++x)
+    {
+      row[x] = 1;
+    }
+  }
+
+  for (; x < rle->x; ++x)
+  {
+    row[x] = 0;
+  }
+}
+
+MVX_API MVX_INLINE int mvx_rle_get(mvx_rle *rle, int x, int y, int z)
+{
+  unsigned long count, i;
+  mvx_span *spans = mvx_rle_row_spans(rle, y, z, &count);
+
+  for (i = 0; i < count && spans[i].begin <= x; ++i)
+  {
+    if (x < spans[i].end)
+    {
+      return 1;
+    }
+  }
+
+  return 0;
+}
+
+/* #############################################################################
+ * # Voxel Layouts
+ * #############################################################################
+ *
+ * Byte grids can be stored in other orders than the linear
+ * x + y * grid_x + z * grid_x * grid_y, so that neighbours along y and z are
+ * close in memory too:
+ *
+ *   MVX_LAYOUT_MORTON   Z-order curve of (x, y, z), x in the lowest bit. The codes
+ *                       of a non power of two grid have holes, so the buffer holds
+ *                       mvx_morton_encode3(grid_x - 1, grid_y - 1, grid_z - 1) + 1
+ *                       bytes. At most 1024 voxels per axis.
+ *   MVX_LAYOUT_TILED4/8 linear order of 4^3 (8^3) voxel tiles, each tile linear.
+ *
+ * The index of a voxel is mvx_layout_row(y, z) + mvx_layout_x(x), so the sweep
+ * computes the row part once per row.
+ */
+#define MVX_LAYOUT_LINEAR 0
+#define MVX_LAYOUT_MORTON 1
+#define MVX_LAYOUT_TILED4 2
+#define MVX_LAYOUT_TILED8 3
+
+/* Spreads the lower 10 bits of v to every third bit */
+MVX_API MVX_INLINE unsigned int mvx_morton_spread3(unsigned int v)
+{
+#if defined(MVX_USE_BMI2)
+  return _pdep_u32(v, 0x09249249u);
+#else
+  v &= 0x000003FFu;
+  v = (v | (v << 16)) & 0x030000FFu;
+  v = (v | (v << 8)) & 0x0300F00Fu;
+  v = (v | (v << 4)) & 0x030C30C3u;
+  v = (v | (v << 2)) & 0x09249249u;
+  return v;
+#endif
+}
+
+/* 30 bit Morton code of (x, y, z) with x in the lowest bit */
+MVX_API MVX_INLINE unsigned int mvx_morton_encode3(unsigned int x, unsigned int y, unsigned int z)
+{
+  return mvx_morton_spread3(x) | (mvx_morton_spread3(y) << 1) | (mvx_morton_spread3(z) << 2);
+}
+
+/* Inverse of mvx_morton_spread3 */
+MVX_API MVX_INLINE unsigned int mvx_morton_compact3(unsigned int v)
+{
+#if defined(MVX_USE_BMI2)
+  return _pext_u32(v, 0x09249249u);
+#else
+  v &= 0x09249249u;
+  v = (v | (v >> 2)) & 0x030C30C3u;
+  v = (v | (v >> 4)) & 0x0300F00Fu;
+  v = (v | (v >> 8)) & 0x030000FFu;
+  v = (v | (v >> 16)) & 0x000003FFu;
+  return v;
+#endif
+}
+
+/* Edge length of a tile, 0 for the other layouts */
+MVX_API MVX_INLINE int mvx_layout_tile(int layout)
+{
+  return layout == MVX_LAYOUT_TILED4 ? 4 : (layout == MVX_LAYOUT_TILED8 ? 8 : 0);
+}
+
+/* 1 if grids of this size can be stored in the layout */
+MVX_API MVX_INLINE int mvx_layout_valid(int layout, int grid_x, int grid_y, int grid_z)
+{
+  if (layout < MVX_LAYOUT_LINEAR || layout > MVX_LAYOUT_TILED8 || grid_x <= 0 || grid_y <= 0 || grid_z <= 0)
+  {
+    return 0;
+  }
+
+  return layout != MVX_LAYOUT_MORTON || (grid_x <= 1024 && grid_y <= 1024 && grid_z <= 1024);
+}
+
+/* The number of bytes of a grid in the layout */
+MVX_API MVX_INLINE long mvx_layout_size(int layout, int grid_x, int grid_y, int grid_z)
+{
+  int t = mvx_layout_tile(layout);
+
+  if (layout == MVX_LAYOUT_MORTON)
+  {
+    return (long)mvx_morton_encode3((unsigned int)(grid_x - 1), (unsigned int)(grid_y - 1), (unsigned int)(grid_z - 1)) + 1;
+  }
+  else if (t)
+  {
+    return (long)((grid_x + t - 1) / t) * (long)((grid_y + t - 1) / t) * (long)((grid_z + t - 1) / t) * t * t * t;
+  }
+
+  return (long)grid_x * (long)grid_y * (long)grid_z;
+}
+
+/* The part of the index that only depends on the row (y, z) */
+MVX_API MVX_INLINE long mvx_layout_row(int layout, int grid_x, int grid_y, int y, int z)
+{
+  int t = mvx_layout_tile(layout);
+
+  if (layout == MVX_LAYOUT_MORTON)
+  {
+    return (long)((mvx_morton_spread3((unsigned int)y) << 1) | (mvx_morton_spread3((unsigned int)z) << 2));
+  }
+  else if (t)
+  {
+    long tiles_x = (grid_x + t - 1) / t;
+    long tiles_y = (grid_y + t - 1) / t;
+
+    return ((long)(y / t) * tiles_x + (long)(z / t) * tiles_x * tiles_y) * t * t * t + (long)(y % t) * t + (long)(z % t) * t * t;
+  }
+
+  return (long)y * grid_x + (long)z * grid_x * grid_y;
+}
+
+/* The part of the index that only depends on x */
+MVX_API MVX_INLINE long mvx_layout_x(int layout, int x)
+{
+  int t = mvx_layout_tile(layout);
+
+  if (layout == MVX_LAYOUT_MORTON)
+  {
+    return (long)mvx_morton_spread3((unsigned int)x);
+  }
+  else if (t)
+  {
+    return (long)(x / t) * t * t * t + x % t;
+  }
+
+  return x;
+}
+
+MVX_API MVX_INLINE long mvx_layout_index(int layout, int grid_x, int grid_y, int x, int y, int z)
+{
+  return mvx_layout_row(layout, grid_x, grid_y, y, z) + mvx_layout_x(layout, x);
+}
+
+/* Reorders a linear byte grid into the layout (mvx_layout_size bytes, holes are zero) */
+MVX_API MVX_INLINE void mvx_layout_from_linear(int layout, int grid_x, int grid_y, int grid_z, unsigned char *linear, unsigned char *output)
+{
+  long size = mvx_layout_size(layout, grid_x, grid_y, grid_z);
+  long q;
+  int x, y, z;
+
+  for (q = 0; q < size; ++q)
+  {
+    output[q] = 0;
+  }
+
+  for (z = 0; z < grid_z; ++z)
+  {
+    for (y = 0; y < grid_y; ++y)
+    {
+      long row = mvx_layout_row(layout, grid_x, grid_y, y, z);
+
+      for (x = 0; x < grid_x; ++x)
+      {
+        output[row + mvx_layout_x(layout, x)] = *linear++;
+      }
+    }
+  }
+}
+
+/* Reorders a byte grid in the layout back into linear order */
+MVX_API MVX_INLINE void mvx_layout_to_linear(int layout, int grid_x, int grid_y, int grid_z, unsigned char *voxels, unsigned char *linear)
+{
+  int x, y, z;
+
+  for (z = 0; z < grid_z; ++z)
+  {
+    for (y = 0; y < grid_y; ++y)
+    {
+      long row = mvx_layout_row(layout, grid_x, grid_y, y, z);
+
+      for (x = 0; x < grid_x; ++x)
+      {
+        *linear++ = voxels[row + mvx_layout_x(layout, x)];
+      }
+    }
+  }
+}
+
+/* #############################################################################
+ * # Voxel Output Targets
+ * #############################################################################
+ *
+ * The triangle sweep produces one MVX_BITS_PER_WORD wide mask per aligned
+ * chunk of a voxel row and hands it to the writer of the target kind.
+ * Supporting a new output format only requires a new kind and its writer.
+ */
+#define MVX_TARGET_BYTES 0
+#define MVX_TARGET_BITS 1
+#define MVX_TARGET_BRICKMAP 2
+#define MVX_TARGET_COUNTS 3
+#define MVX_TARGET_ATTRIBUTES 4
+#define MVX_TARGET_SPANS 5
+#define MVX_TARGET_LAYOUT 6
+
+struct mvx_target;
+
+/* Writes the voxels of chunk "word" of row (y, z) whose bits are set in mask */
+typedef void (*mvx_target_write_function)(struct mvx_target *target, mvx_grid *grid, int word, int y, int z, unsigned int mask);
+
+typedef struct mvx_target
+{
+  int kind;               /* MVX_TARGET_* */
+  mvx_target_write_function write; /* writer of the kind, selected by mvx_target_init */
+  unsigned char *bytes;   /* MVX_TARGET_BYTES: one byte per voxel */
+  unsigned int *bits;     /* MVX_TARGET_BITS: see mvx_bits_row_words */
+  mvx_brickmap *brickmap; /* MVX_TARGET_BRICKMAP: single threaded only, no solid fill */
+  mvx_counts *counts;     /* MVX_TARGET_COUNTS: adds or removes coverage, no solid fill */
+  mvx_attributes *attributes; /* MVX_TARGET_ATTRIBUTES: bytes plus the attribute channels */
+  mvx_rle *rle;           /* MVX_TARGET_SPANS: appends row intervals, single threaded only, no solid fill */
+  int layout;             /* MVX_TARGET_LAYOUT: bytes in MVX_LAYOUT_* order (whole grid, no z_origin) */
+  unsigned int triangle;  /* attributes: index of the triangle being swept */
+  mvx_v3 normal;          /* attributes: its area weighted normal */
+  int z_origin;           /* bytes/bits: first slice stored in the buffer (streaming slabs) */
+
+} mvx_target;
+
+/* Tells the target which triangle the following writes belong to (only attributes need it) */
+MVX_API MVX_INLINE void mvx_target_triangle(mvx_target *target, unsigned long t, mvx_v3 v0, mvx_v3 v1, mvx_v3 v2)
+{
+  if (target->kind == MVX_TARGET_ATTRIBUTES)
+  {
+    target->triangle = (unsigned int)t;
+    target->normal = mvx_v3_scale(mvx_v3_cross(mvx_v3_sub(v1, v0), mvx_v3_sub(v2, v0)), 0.5f);
+  }
+}
+
+/* Clears the slices z_begin..z_end - 1 */
+MVX_API MVX_INLINE void mvx_target_clear(mvx_target *target, mvx_grid *grid, int z_begin, int z_end)
+{
+  long q;
+
+  if (target->kind == MVX_TARGET_BITS)
+  {
+    long slice = (long)mvx_bits_row_words(grid->x) * (long)grid->y;
+    long end = slice * (z_end - target->z_origin);
+    for (q = slice * (z_begin - target->z_origin); q < end; ++q)
+    {
+      target->bits[q] = 0;
+    }
+  }
+  else if (target->kind == MVX_TARGET_BRICKMAP || target->kind == MVX_TARGET_COUNTS || target->kind == MVX_TARGET_SPANS)
+  {
+    /* a brick map and spans start empty (mvx_brickmap_init, mvx_rle_init), counts are only changed by their triangles */
+  }
+  else if (target->kind == MVX_TARGET_LAYOUT)
+  {
+    int x, y, z;
+
+    /* the whole grid includes the holes, slabs are not contiguous */
+    if (z_begin == 0 && z_end == grid->z)
+    {
+      long size = mvx_layout_size(target->layout, grid->x, grid->y, grid->z);
+
+      for (q = 0; q < size; ++q)
+      {
+        target->bytes[q] = 0;
+      }
+      return;
+    }
+
+    for (z = z_begin; z < z_end; ++z)
+    {
+      for (y = 0; y < grid->y; ++y)
+      {
+        long row = mvx_layout_row(target->layout, grid->x, grid->y, y, z);
+
+        for (x = 0; x < grid->x; ++x)
+        {
+          target->bytes[row + mvx_layout_x(target->layout, x)] = 0;
+        }
+      }
+    }
+  }
+  else
+  {
+    long slice = (long)grid->x * (long)grid->y;
+    long end = slice * (z_end - target->z_origin);
+    for (q = slice * (z_begin - target->z_origin); q < end; ++q)
+    {
+      target->bytes[q] = 0;
+    }
+
+    if (target->kind == MVX_TARGET_ATTRIBUTES)
+    {
+      mvx_attributes_clear(target->attributes, slice * (z_begin - target->z_origin), end);
+    }
+  }
+}
+
+/* Sets the bytes id.. of the set bits of mask */
+MVX_API MVX_INLINE void mvx_target_write_bytes(unsigned char *bytes, long id, unsigned int mask)
+{
+  for (; mask; mask >>= 1, ++id)
+  {
+    if (mask & 1u)
+    {
+      bytes[id] = 1;
+    }
+  }
+}
+
+MVX_API MVX_INLINE void mvx_target_bytes_write(mvx_target *target, mvx_grid *grid, int word, int y, int z, unsigned int mask)
+{
+  long id = (long)word * MVX_BITS_PER_WORD + (long)y * grid->x + (long)(z - target->z_origin) * grid->x * grid->y;
+  mvx_target_write_bytes(target->bytes, id, mask);
+}
+
+MVX_API MVX_INLINE void mvx_target_bits_write(mvx_target *target, mvx_grid *grid, int word, int y, int z, unsigned int mask)
+{
+  long id = ((long)y + (long)(z - target->z_origin) * grid->y) * mvx_bits_row_words(grid->x) + word;
+  target->bits[id] |= mask;
+}
+
+MVX_API MVX_INLINE void mvx_target_brickmap_write(mvx_target *target, mvx_grid *grid, int word, int y, int z, unsigned int mask)
+{
+  /* every byte of the mask is one local row of a brick */
+  int row = y % MVX_BRICK_SIZE + MVX_BRICK_SIZE * (z % MVX_BRICK_SIZE);
+  int bx = word * (MVX_BITS_PER_WORD / MVX_BRICK_SIZE);
+
+  (void)grid;
+
+  for (; mask; mask >>= MVX_BRICK_SIZE, ++bx)
+  {
+    unsigned int bits = mask & 0xFFu;
+    unsigned int *brick;
+
+    if (!bits)
+    {
+      continue;
+    }
+
+    brick = mvx_brickmap_brick(target->brickmap, bx, y / MVX_BRICK_SIZE, z / MVX_BRICK_SIZE);
+
+    if (brick)
+    {
+      brick[row / 4] |= bits << ((row % 4) * 8);
+    }
+  }
+}
+
+MVX_API MVX_INLINE void mvx_target_layout_write(mvx_target *target, mvx_grid *grid, int word, int y, int z, unsigned int mask)
+{
+  long row = mvx_layout_row(target->layout, grid->x, grid->y, y, z);
+  int x = word * MVX_BITS_PER_WORD;
+
+  for (; mask; mask >>= 1, ++x)
+  {
+    if (mask & 1u)
+    {
+      target->bytes[row + mvx_layout_x(target->layout, x)] = 1;
+    }
+  }
+}
+
+MVX_API MVX_INLINE void mvx_target_spans_write(mvx_target *target, mvx_grid *grid, int word, int y, int z, unsigned int mask)
+{
+  mvx_rle_append(target->rle, (unsigned long)y + (unsigned long)z * (unsigned long)grid->y, word * MVX_BITS_PER_WORD, mask);
+}
+
+MVX_API MVX_INLINE void mvx_target_counts_write(mvx_target *target, mvx_grid *grid, int word, int y, int z, unsigned int mask)
+{
+  long id = (long)word * MVX_BITS_PER_WORD + (long)y * grid->x + (long)z * grid->x * grid->y;
+
+  for (; mask; mask >>= 1, ++id)
+  {
+    if (mask & 1u)
+    {
+      mvx_counts_apply(target->counts, id);
+    }
+  }
+}
+
+MVX_API MVX_INLINE void mvx_target_attributes_write(mvx_target *target, mvx_grid *grid, int word, int y, int z, unsigned int mask)
+{
+  long id = (long)word * MVX_BITS_PER_WORD + (long)y * grid->x + (long)(z - target->z_origin) * grid->x * grid->y;
+  mvx_attributes *a = target->attributes;
+
+  if (a->triangles)
+  {
+    mvx_attributes_write_triangle(a->triangles, id, mask, target->triangle);
+  }
+  if (a->materials)
+  {
+    mvx_attributes_write_triangle(a->materials, id, mask, a->triangle_materials[target->triangle]);
+  }
+  if (a->normals)
+  {
+    mvx_attributes_write_normal(a->normals, id, mask, target->normal);
+  }
+
+  mvx_target_write_bytes(target->bytes, id, mask);
+}
+
+/* The writer of a MVX_TARGET_* kind, picked once so the sweep does not branch on the kind per chunk */
+MVX_API MVX_INLINE mvx_target_write_function mvx_target_writer(int kind)
+{
+  if (kind == MVX_TARGET_BITS)
+  {
+    return mvx_target_bits_write;
+  }
+  if (kind == MVX_TARGET_BRICKMAP)
+  {
+    return mvx_target_brickmap_write;
+  }
+  if (kind == MVX_TARGET_COUNTS)
+  {
+    return mvx_target_counts_write;
+  }
+  if (kind == MVX_TARGET_ATTRIBUTES)
+  {
+    return mvx_target_attributes_write;
+  }
+  if (kind == MVX_TARGET_SPANS)
+  {
+    return mvx_target_spans_write;
+  }
+  if (kind == MVX_TARGET_LAYOUT)
+  {
+    return mvx_target_layout_write;
+  }
+  return mvx_target_bytes_write;
+}
+
+MVX_API MVX_INLINE mvx_target mvx_target_init(int kind)
+{
+  mvx_target result;
+  result.kind = kind;
+  result.write = mvx_target_writer(kind);
+  result.bytes = 0;
+  result.bits = 0;
+  result.brickmap = 0;
+  result.counts = 0;
+  result.attributes = 0;
+  result.rle = 0;
+  result.layout = MVX_LAYOUT_LINEAR;
+  result.triangle = 0;
+  result.normal = mvx_v3_init(0.0f, 0.0f, 0.0f);
+  result.z_origin = 0;
+  return result;
+}
+
+/* Writes the voxels of chunk "word" of row (y, z) whose bits are set in mask */
+MVX_API MVX_INLINE void mvx_target_write(mvx_target *target, mvx_grid *grid, int word, int y, int z, unsigned int mask)
+{
+  target->write(target, grid, word, y, z, mask);
+}
+
+/* Flips voxel (x, y, z). Used to record parity crossings for solid voxelization. */
+MVX_API MVX_INLINE void mvx_target_toggle(mvx_target *target, mvx_grid *grid, int x, int y, int z)
+{
+  if (target->kind == MVX_TARGET_BITS)
+  {
+    long id = ((long)y + (long)(z - target->z_origin) * grid->y) * mvx_bits_row_words(grid->x) + x / MVX_BITS_PER_WORD;
+    target->bits[id] ^= 1u << (x % MVX_BITS_PER_WORD);
+  }
+  else if (target->kind == MVX_TARGET_LAYOUT)
+  {
+    target->bytes[mvx_layout_index(target->layout, grid->x, grid->y, x, y, z)] ^= 1;
+  }
+  else
+  {
+    long id = (long)x + (long)y * grid->x + (long)(z - target->z_origin) * grid->x * grid->y;
+    target->bytes[id] ^= 1;
+  }
+}
+
+/* Kinds mvx_target_toggle and mvx_target_fill_parity can fill (bricks, counts and spans have no parity pass) */
+MVX_API MVX_INLINE int mvx_target_solid_kind(int kind)
+{
+  return kind == MVX_TARGET_BYTES || kind == MVX_TARGET_BITS || kind == MVX_TARGET_ATTRIBUTES || kind == MVX_TARGET_LAYOUT;
+}
+
+/* Turns the toggles of every row of the slices z_begin..z_end - 1 into filled spans in
+ * one linear pass: a voxel is set if an odd number of toggles lie at or before it in its row.
+ */
+MVX_API MVX_INLINE void mvx_target_fill_parity(mvx_target *target, mvx_grid *grid, int z_begin, int z_end)
+{
+  long row;
+  long rows = (long)grid->y * (long)(z_end - target->z_origin);
+
+  if (target->kind == MVX_TARGET_BITS)
+  {
+    int row_words = mvx_bits_row_words(grid->x);
+    int tail = grid->x % MVX_BITS_PER_WORD;
+    unsigned int tail_mask = tail ? (1u << tail) - 1u : ~0u;
+
+    for (row = (long)grid->y * (z_begin - target->z_origin); row < rows; ++row)
+    {
+      unsigned int *w = target->bits + row * row_words;
+      unsigned int carry = 0;
+      int i;
+
+      for (i = 0; i < row_words; ++i)
+      {
+        /* prefix xor inside the word, then apply the parity of the previous words */
+        unsigned int v = w[i];
+        v ^= v << 1;
+        v ^= v << 2;
+        v ^= v << 4;
+        v ^= v << 8;
+        v ^= v << 16;
+        v ^= carry;
+        carry = (v >> (MVX_BITS_PER_WORD - 1)) ? ~0u : 0u;
+        w[i] = v;
+      }
+
+      w[row_words - 1] &= tail_mask;
+    }
+  }
+  else if (target->kind == MVX_TARGET_LAYOUT)
+  {
+    for (row = (long)grid->y * z_begin; row < rows; ++row)
+    {
+      long base = mvx_layout_row(target->layout, grid->x, grid->y, (int)(row % grid->y), (int)(row / grid->y));
+      unsigned char inside = 0;
+      int x;
+
+      for (x = 0; x < grid->x; ++x)
+      {
+        unsigned char *b = target->bytes + base + mvx_layout_x(target->layout, x);
+        inside ^= *b;
+        *b = inside;
+      }
+    }
+  }
+  else
+  {
+    for (row = (long)grid->y * (z_begin - target->z_origin); row < rows; ++row)
+    {
+      unsigned char *b = target->bytes + row * grid->x;
+      unsigned char inside = 0;
+      int x;
+
+      for (x = 0; x < grid->x; ++x)
+      {
+        inside ^= b[x];
+        b[x] = inside;
+      }
+    }
+  }
+}
+
+/* The parts of the setup overlap test that only depend on y and z of a voxel row */
+typedef struct mvx_triangle_row
+{
+  float cy;            /* row center relative to v0 */
+  float cz;
+  float py[3];         /* y/z parts of the Y and Z family projections */
+  float pz[3];
+  float plane;         /* y/z part of the plane distance */
+  unsigned int points; /* vertices (bit 0..2) that pass the point in box shortcut on y and z */
+  int sat;             /* 0 if an axis independent of x already separates the row */
+#ifdef MVX_STATS
+  int reject;          /* MVX_STATS_REJECT_* family that separates the row */
+#endif
+
+} mvx_triangle_row;
+
+/* Evaluates everything of row (y, z) that does not depend on x. Returns 0 if no voxel of the row can overlap. */
+MVX_API MVX_INLINE int mvx_triangle_row_init(mvx_triangle_setup *s, mvx_grid *grid, int y, int z, mvx_triangle_row *row)
+{
+  float eps = 1e-6f;
+  mvx_v3 boxc = mvx_grid_voxel_center(grid, 0, y, z);
+  mvx_v3 h = s->boxhalf;
+  int i;
+
+  row->cy = boxc.y - s->v0.y;
+  row->cz = boxc.z - s->v0.z;
+  row->points = 0;
+  row->sat = 1;
+#ifdef MVX_STATS
+  row->reject = MVX_STATS_REJECT_AABB;
+#endif
+
+  /* vertices that can be inside a box of this row (point in box shortcut) */
+  if (!(s->v0.y < boxc.y - h.y - eps || s->v0.y > boxc.y + h.y + eps || s->v0.z < boxc.z - h.z - eps || s->v0.z > boxc.z + h.z + eps))
+  {
+    row->points |= 1u;
+  }
+  if (!(s->v1.y < boxc.y - h.y - eps || s->v1.y > boxc.y + h.y + eps || s->v1.z < boxc.z - h.z - eps || s->v1.z > boxc.z + h.z + eps))
+  {
+    row->points |= 2u;
+  }
+  if (!(s->v2.y < boxc.y - h.y - eps || s->v2.y > boxc.y + h.y + eps || s->v2.z < boxc.z - h.z - eps || s->v2.z > boxc.z + h.z + eps))
+  {
+    row->points |= 4u;
+  }
+
+  /* separating axes that do not depend on x */
+  if (s->tri_max.y - row->cy < -s->bh.y || s->tri_min.y - row->cy > s->bh.y ||
+      s->tri_max.z - row->cz < -s->bh.z || s->tri_min.z - row->cz > s->bh.z)
+  {
+    row->sat = 0;
+#ifdef MVX_STATS
+    row->reject = MVX_STATS_REJECT_AABB;
+#endif
+  }
+
+  for (i = 0; i < 3; ++i)
+  {
+    float px = s->ax[i] * row->cy + s->bx[i] * row->cz;
+
+    if (s->x_max[i] - px < -s->x_rad[i] || s->x_min[i] - px > s->x_rad[i])
+    {
+#ifdef MVX_STATS
+      row->reject = row->sat ? MVX_STATS_REJECT_EDGE_X : row->reject;
+#endif
+      row->sat = 0;
+    }
+
+    row->py[i] = s->by[i] * row->cz;
+    row->pz[i] = s->bz[i] * row->cy;
+  }
+
+  row->plane = s->n.y * row->cy + s->n.z * row->cz;
+
+  return row->sat || row->points;
+}
+
+/* Scalar overlap test of voxel x of an initialized row */
+MVX_API MVX_INLINE int mvx_triangle_row_overlap(mvx_triangle_setup *s, mvx_triangle_row *row, mvx_grid *grid, int x)
+{
+  float eps = 1e-6f;
+  float hx = s->boxhalf.x;
+  float wx = grid->min_b.x + ((float)(x - grid->margin.x) + 0.5f) * grid->vxsize;
+  float cx = wx - s->v0.x;
+  float d;
+  int i;
+
+  MVX_STATS_ADD(s->stats, tests, 1);
+
+  if (((row->points & 1u) && !(s->v0.x < wx - hx - eps || s->v0.x > wx + hx + eps)) ||
+      ((row->points & 2u) && !(s->v1.x < wx - hx - eps || s->v1.x > wx + hx + eps)) ||
+      ((row->points & 4u) && !(s->v2.x < wx - hx - eps || s->v2.x > wx + hx + eps)))
+  {
+    MVX_STATS_ADD(s->stats, point_hits, 1);
+    MVX_STATS_ADD(s->stats, hits, 1);
+    return 1;
+  }
+
+  if (!row->sat)
+  {
+    MVX_STATS_REJECT(s->stats, row->reject);
+    return 0;
+  }
+
+  if (s->tri_max.x - cx < -s->bh.x || s->tri_min.x - cx > s->bh.x)
+  {
+    MVX_STATS_REJECT(s->stats, MVX_STATS_REJECT_AABB);
+    return 0;
+  }
+
+  d = s->n.x * cx + row->plane;
+  if (d > s->plane_rad || d < -s->plane_rad)
+  {
+    MVX_STATS_REJECT(s->stats, MVX_STATS_REJECT_PLANE);
+    return 0;
+  }
+
+  for (i = 0; i < 3; ++i)
+  {
+    float ppy = s->ay[i] * cx + row->py[i];
+    float ppz = s->az[i] * cx + row->pz[i];
+
+    if (s->y_max[i] - ppy < -s->y_rad[i] || s->y_min[i] - ppy > s->y_rad[i])
+    {
+      MVX_STATS_REJECT(s->stats, MVX_STATS_REJECT_EDGE_Y);
+      return 0;
+    }
+
+    if (s->z_max[i] - ppz < -s->z_rad[i] || s->z_min[i] - ppz > s->z_rad[i])
+    {
+      MVX_STATS_REJECT(s->stats, MVX_STATS_REJECT_EDGE_Z);
+      return 0;
+    }
+  }
+
+  MVX_STATS_ADD(s->stats, hits, 1);
+  return 1;
+}
+
+#if defined(MVX_USE_AVX2)
+#define MVX_SIMD_LANES 8
+
+/* mvx_triangle_row_overlap for voxels x..x+7, returns one bit per voxel */
+MVX_API MVX_INLINE unsigned int mvx_triangle_row_overlap_x8(mvx_triangle_setup *s, mvx_triangle_row *row, mvx_grid *grid, int x)
+{
+  __m256 eps = _mm256_set1_ps(1e-6f);
+  __m256 hx = _mm256_set1_ps(s->boxhalf.x);
+  __m256 wx = _mm256_add_ps(_mm256_set1_ps((float)(x - grid->margin.x)), _mm256_set_ps(7.0f, 6.0f, 5.0f, 4.0f, 3.0f, 2.0f, 1.0f, 0.0f));
+  __m256 lo, hi, hit;
+  int i;
+
+  wx = _mm256_add_ps(_mm256_set1_ps(grid->min_b.x), _mm256_mul_ps(_mm256_add_ps(wx, _mm256_set1_ps(0.5f)), _mm256_set1_ps(grid->vxsize)));
+  lo = _mm256_sub_ps(_mm256_sub_ps(wx, hx), eps);
+  hi = _mm256_add_ps(_mm256_add_ps(wx, hx), eps);
+  hit = _mm256_setzero_ps();
+
+  if (row->points & 1u)
+  {
+    __m256 p = _mm256_set1_ps(s->v0.x);
+    hit = _mm256_or_ps(hit, _mm256_and_ps(_mm256_cmp_ps(lo, p, _CMP_LE_OQ), _mm256_cmp_ps(p, hi, _CMP_LE_OQ)));
+  }
+  if (row->points & 2u)
+  {
+    __m256 p = _mm256_set1_ps(s->v1.x);
+    hit = _mm256_or_ps(hit, _mm256_and_ps(_mm256_cmp_ps(lo, p, _CMP_LE_OQ), _mm256_cmp_ps(p, hi, _CMP_LE_OQ)));
+  }
+  if (row->points & 4u)
+  {
+    __m256 p = _mm256_set1_ps(s->v2.x);
+    hit = _mm256_or_ps(hit, _mm256_and_ps(_mm256_cmp_ps(lo, p, _CMP_LE_OQ), _mm256_cmp_ps(p, hi, _CMP_LE_OQ)));
+  }
+
+  if (row->sat)
+  {
+    __m256 cx = _mm256_sub_ps(wx, _mm256_set1_ps(s->v0.x));
+    __m256 d = _mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(s->n.x), cx), _mm256_set1_ps(row->plane));
+    __m256 sat;
+
+    sat = _mm256_and_ps(
+        _mm256_cmp_ps(_mm256_sub_ps(_mm256_set1_ps(s->tri_max.x), cx), _mm256_set1_ps(-s->bh.x), _CMP_GE_OQ),
+        _mm256_cmp_ps(_mm256_sub_ps(_mm256_set1_ps(s->tri_min.x), cx), _mm256_set1_ps(s->bh.x), _CMP_LE_OQ));
+    sat = _mm256_and_ps(sat, _mm256_and_ps(
+                                 _mm256_cmp_ps(d, _mm256_set1_ps(s->plane_rad), _CMP_LE_OQ),
+                                 _mm256_cmp_ps(d, _mm256_set1_ps(-s->plane_rad), _CMP_GE_OQ)));
+
+    /* most candidates of large triangles are already rejected by the plane */
+    for (i = 0; i < 3 && _mm256_movemask_ps(sat); ++i)
+    {
+      __m256 ppy = _mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(s->ay[i]), cx), _mm256_set1_ps(row->py[i]));
+      __m256 ppz = _mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(s->az[i]), cx), _mm256_set1_ps(row->pz[i]));
+
+      sat = _mm256_and_ps(sat, _mm256_and_ps(
+                                   _mm256_cmp_ps(_mm256_sub_ps(_mm256_set1_ps(s->y_max[i]), ppy), _mm256_set1_ps(-s->y_rad[i]), _CMP_GE_OQ),
+                                   _mm256_cmp_ps(_mm256_sub_ps(_mm256_set1_ps(s->y_min[i]), ppy), _mm256_set1_ps(s->y_rad[i]), _CMP_LE_OQ)));
+      sat = _mm256_and_ps(sat, _mm256_and_ps(
+                                   _mm256_cmp_ps(_mm256_sub_ps(_mm256_set1_ps(s->z_max[i]), ppz), _mm256_set1_ps(-s->z_rad[i]), _CMP_GE_OQ),
+                                   _mm256_cmp_ps(_mm256_sub_ps(_mm256_set1_ps(s->z_min[i]), ppz), _mm256_set1_ps(s->z_rad[i]), _CMP_LE_OQ)));
+    }
+
+    hit = _mm256_or_ps(hit, sat);
+  }
+
+  return (unsigned int)_mm256_movemask_ps(hit);
+}
+
+#elif defined(MVX_USE_SSE2)
+#define MVX_SIMD_LANES 4
+
+/* mvx_triangle_row_overlap for voxels x..x+3, returns one bit per voxel */
+MVX_API MVX_INLINE unsigned int mvx_triangle_row_overlap_x4(mvx_triangle_setup *s, mvx_triangle_row *row, mvx_grid *grid, int x)
+{
+  __m128 eps = _mm_set1_ps(1e-6f);
+  __m128 hx = _mm_set1_ps(s->boxhalf.x);
+  __m128 wx = _mm_add_ps(_mm_set1_ps((float)(x - grid->margin.x)), _mm_set_ps(3.0f, 2.0f, 1.0f, 0.0f));
+  __m128 lo, hi, hit;
+  int i;
+
+  wx = _mm_add_ps(_mm_set1_ps(grid->min_b.x), _mm_mul_ps(_mm_add_ps(wx, _mm_set1_ps(0.5f)), _mm_set1_ps(grid->vxsize)));
+  lo = _mm_sub_ps(_mm_sub_ps(wx, hx), eps);
+  hi = _mm_add_ps(_mm_add_ps(wx, hx), eps);
+  hit = _mm_setzero_ps();
+
+  if (row->points & 1u)
+  {
+    __m128 p = _mm_set1_ps(s->v0.x);
+    hit = _mm_or_ps(hit, _mm_and_ps(_mm_cmple_ps(lo, p), _mm_cmple_ps(p, hi)));
+  }
+  if (row->points & 2u)
+  {
+    __m128 p = _mm_set1_ps(s->v1.x);
+    hit = _mm_or_ps(hit, _mm_and_ps(_mm_cmple_ps(lo, p), _mm_cmple_ps(p, hi)));
+  }
+  if (row->points & 4u)
+  {
+    __m128 p = _mm_set1_ps(s->v2.x);
+    hit = _mm_or_ps(hit, _mm_and_ps(_mm_cmple_ps(lo, p), _mm_cmple_ps(p, hi)));
+  }
+
+  if (row->sat)
+  {
+    __m128 cx = _mm_sub_ps(wx, _mm_set1_ps(s->v0.x));
+    __m128 d = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(s->n.x), cx), _mm_set1_ps(row->plane));
+    __m128 sat;
+
+    sat = _mm_and_ps(
+        _mm_cmpge_ps(_mm_sub_ps(_mm_set1_ps(s->tri_max.x), cx), _mm_set1_ps(-s->bh.x)),
+        _mm_cmple_ps(_mm_sub_ps(_mm_set1_ps(s->tri_min.x), cx), _mm_set1_ps(s->bh.x)));
+    sat = _mm_and_ps(sat, _mm_and_ps(
+                              _mm_cmple_ps(d, _mm_set1_ps(s->plane_rad)),
+                              _mm_cmpge_ps(d, _mm_set1_ps(-s->plane_rad))));
+
+    /* most candidates of large triangles are already rejected by the plane */
+    for (i = 0; i < 3 && _mm_movemask_ps(sat); ++i)
+    {
+      __m128 ppy = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(s->ay[i]), cx), _mm_set1_ps(row->py[i]));
+      __m128 ppz = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(s->az[i]), cx), _mm_set1_ps(row->pz[i]));
+
+      sat = _mm_and_ps(sat, _mm_and_ps(
+                                _mm_cmpge_ps(_mm_sub_ps(_mm_set1_ps(s->y_max[i]), ppy), _mm_set1_ps(-s->y_rad[i])),
+                                _mm_cmple_ps(_mm_sub_ps(_mm_set1_ps(s->y_min[i]), ppy), _mm_set1_ps(s->y_rad[i]))));
+      sat = _mm_and_ps(sat, _mm_and_ps(
+                                _mm_cmpge_ps(_mm_sub_ps(_mm_set1_ps(s->z_max[i]), ppz), _mm_set1_ps(-s->z_rad[i])),
+                                _mm_cmple_ps(_mm_sub_ps(_mm_set1_ps(s->z_min[i]), ppz), _mm_set1_ps(s->z_rad[i]))));
+    }
+
+    hit = _mm_or_ps(hit, sat);
+  }
+
+  return (unsigned int)_mm_movemask_ps(hit);
+}
+
+#elif defined(MVX_USE_NEON)
+#define MVX_SIMD_LANES 4
+
+/* mvx_triangle_row_overlap for voxels x..x+3, returns one bit per voxel */
+MVX_API MVX_INLINE unsigned int mvx_triangle_row_overlap_x4(mvx_triangle_setup *s, mvx_triangle_row *row, mvx_grid *grid, int x)
+{
+  float lane_offsets[4] = {0.0f, 1.0f, 2.0f, 3.0f};
+  unsigned int lane_bits[4] = {1u, 2u, 4u, 8u};
+  float32x4_t eps = vdupq_n_f32(1e-6f);
+  float32x4_t hx = vdupq_n_f32(s->boxhalf.x);
+  float32x4_t wx = vaddq_f32(vdupq_n_f32((float)(x - grid->margin.x)), vld1q_f32(lane_offsets));
+  float32x4_t lo, hi;
+  uint32x4_t hit;
+  int i;
+
+  wx = vaddq_f32(vdupq_n_f32(grid->min_b.x), vmulq_f32(vaddq_f32(wx, vdupq_n_f32(0.5f)), vdupq_n_f32(grid->vxsize)));
+  lo = vsubq_f32(vsubq_f32(wx, hx), eps);
+  hi = vaddq_f32(vaddq_f32(wx, hx), eps);
+  hit = vdupq_n_u32(0);
+
+  if (row->points & 1u)
+  {
+    float32x4_t p = vdupq_n_f32(s->v0.x);
+    hit = vorrq_u32(hit, vandq_u32(vcleq_f32(lo, p), vcleq_f32(p, hi)));
+  }
+  if (row->points & 2u)
+  {
+    float32x4_t p = vdupq_n_f32(s->v1.x);
+    hit = vorrq_u32(hit, vandq_u32(vcleq_f32(lo, p), vcleq_f32(p, hi)));
+  }
+  if (row->points & 4u)
+  {
+    float32x4_t p = vdupq_n_f32(s->v2.x);
+    hit = vorrq_u32(hit, vandq_u32(vcleq_f32(lo, p), vcleq_f32(p, hi)));
+  }
+
+  if (row->sat)
+  {
+    float32x4_t cx = vsubq_f32(wx, vdupq_n_f32(s->v0.x));
+    float32x4_t d = vaddq_f32(vmulq_f32(vdupq_n_f32(s->n.x), cx), vdupq_n_f32(row->plane));
+    uint32x4_t sat;
+
+    sat = vandq_u32(
+        vcgeq_f32(vsubq_f32(vdupq_n_f32(s->tri_max.x), cx), vdupq_n_f32(-s->bh.x)),
+        vcleq_f32(vsubq_f32(vdupq_n_f32(s->tri_min.x), cx), vdupq_n_f32(s->bh.x)));
+    sat = vandq_u32(sat, vandq_u32(
+                             vcleq_f32(d, vdupq_n_f32(s->plane_rad)),
+                             vcgeq_f32(d, vdupq_n_f32(-s->plane_rad))));
+
+    /* most candidates of large triangles are already rejected by the plane */
+    for (i = 0; i < 3 && vmaxvq_u32(sat); ++i)
+    {
+      float32x4_t ppy = vaddq_f32(vmulq_f32(vdupq_n_f32(s->ay[i]), cx), vdupq_n_f32(row->py[i]));
+      float32x4_t ppz = vaddq_f32(vmulq_f32(vdupq_n_f32(s->az[i]), cx), vdupq_n_f32(row->pz[i]));
+
+      sat = vandq_u32(sat, vandq_u32(
+                               vcgeq_f32(vsubq_f32(vdupq_n_f32(s->y_max[i]), ppy), vdupq_n_f32(-s->y_rad[i])),
+                               vcleq_f32(vsubq_f32(vdupq_n_f32(s->y_min[i]), ppy), vdupq_n_f32(s->y_rad[i]))));
+      sat = vandq_u32(sat, vandq_u32(
+                               vcgeq_f32(vsubq_f32(vdupq_n_f32(s->z_max[i]), ppz), vdupq_n_f32(-s->z_rad[i])),
+                               vcleq_f32(vsubq_f32(vdupq_n_f32(s->z_min[i]), ppz), vdupq_n_f32(s->z_rad[i]))));
+    }
+
+    hit = vorrq_u32(hit, sat);
+  }
+
+  return vaddvq_u32(vandq_u32(hit, vld1q_u32(lane_bits)));
+}
+
+#endif
+
+/* Tests the voxels x_begin..x_end (inclusive, inside one chunk) of row (y, z) */
+MVX_API MVX_INLINE unsigned int mvx_voxelize_row_mask(
+    mvx_grid *grid,
+    mvx_triangle_setup *s,
+    int x_begin, int x_end, int y, int z)
+{
+  mvx_triangle_row row;
+  unsigned int mask = 0;
+  int x = x_begin;
+
+  if (!mvx_triangle_row_init(s, grid, y, z, &row))
+  {
+    MVX_STATS_ADD(s->stats, rows_rejected, 1);
+    return 0;
+  }
+
+#if defined(MVX_STATS)
+  /* counters follow the scalar test order */
+#elif defined(MVX_USE_AVX2)
+  for (; x + MVX_SIMD_LANES - 1 <= x_end; x += MVX_SIMD_LANES)
+  {
+    mask |= mvx_triangle_row_overlap_x8(s, &row, grid, x) << (x % MVX_BITS_PER_WORD);
+  }
+#elif defined(MVX_USE_SSE2) || defined(MVX_USE_NEON)
+  for (; x + MVX_SIMD_LANES - 1 <= x_end; x += MVX_SIMD_LANES)
+  {
+    mask |= mvx_triangle_row_overlap_x4(s, &row, grid, x) << (x % MVX_BITS_PER_WORD);
+  }
+#endif
+
+  for (; x <= x_end; ++x)
+  {
+    if (mvx_triangle_row_overlap(s, &row, grid, x))
+    {
+      mask |= 1u << (x % MVX_BITS_PER_WORD);
+    }
+  }
+
+  return mask;
+}
+
+/* The slab of voxels around the triangle plane. The plane distance of the voxel
+ * centers is linear in the voxel index, so every row (y, z) only has to visit
+ * the x range where it stays within the box radius along the normal: a few
+ * voxels if x is the dominant normal axis, otherwise the cross section of a
+ * thin slab, and rows the plane does not reach are skipped without a test.
+ * The radius is widened by the rounding of the per voxel test (relative to the
+ * largest coordinate) and the point in box epsilon, and the range by one voxel,
+ * so the exact test still decides every voxel.
+ */
+typedef struct mvx_triangle_band
+{
+  mvx_v3i origin; /* first candidate voxel */
+  float d;        /* plane distance of the center of the origin voxel */
+  float d_x;      /* change of the plane distance per voxel along x, y and z */
+  float d_y;
+  float d_z;
+  float rad;      /* plane_rad plus the tolerance */
+
+} mvx_triangle_band;
+
+MVX_API MVX_INLINE void mvx_triangle_band_init(mvx_triangle_band *band, mvx_triangle_setup *s, mvx_grid *grid, mvx_v3i i_min, mvx_v3i i_max)
+{
+  mvx_v3 lo = mvx_grid_voxel_center(grid, i_min.x, i_min.y, i_min.z);
+  mvx_v3 hi = mvx_grid_voxel_center(grid, i_max.x, i_max.y, i_max.z);
+  mvx_v3 a = mvx_v3_abs(s->n);
+  mvx_v3 c = mvx_v3_max(mvx_v3_max(mvx_v3_abs(lo), mvx_v3_abs(hi)), mvx_v3_abs(s->v0));
+  float coord = mvx_maxf(c.x, mvx_maxf(c.y, c.z));
+
+  band->origin = i_min;
+  band->d = mvx_v3_dot(s->n, mvx_v3_sub(lo, s->v0));
+  band->d_x = s->n.x * grid->vxsize;
+  band->d_y = s->n.y * grid->vxsize;
+  band->d_z = s->n.z * grid->vxsize;
+  band->rad = s->plane_rad * 1.0001f + (a.x + a.y + a.z) * (coord * 1e-5f + 1e-6f);
+}
+
+/* The x range x_begin..x_end (inclusive, within x_min..x_max) of row (y, z) near the plane. Returns 0 if it is empty. */
+MVX_API MVX_INLINE int mvx_triangle_band_row(mvx_triangle_band *band, int y, int z, int x_max, int *x_begin, int *x_end)
+{
+  float d = band->d + (float)(y - band->origin.y) * band->d_y + (float)(z - band->origin.z) * band->d_z;
+  float span = (float)(x_max - band->origin.x);
+  float lo, hi;
+
+  *x_begin = band->origin.x;
+  *x_end = x_max;
+
+  if (band->d_x == 0.0f)
+  {
+    return d <= band->rad && d >= -band->rad;
+  }
+
+  /* voxel offsets from the origin where the distance leaves -rad..rad */
+  lo = (-band->rad - d) / band->d_x;
+  hi = (band->rad - d) / band->d_x;
+
+  if (lo > hi)
+  {
+    float t = lo;
+    lo = hi;
+    hi = t;
+  }
+
+  if (hi < -1.0f || lo > span + 1.0f)
+  {
+    return 0;
+  }
+
+  if (lo > 1.0f)
+  {
+    *x_begin += (int)lo - 1;
+  }
+  if (hi < span - 2.0f)
+  {
+    *x_end = band->origin.x + (int)hi + 2;
+  }
+
+  return 1;
+}
+
+/* The number of voxels the sweep visits (and tests) for a triangle inside the clip box: the plane band of every row */
+MVX_API MVX_INLINE unsigned long mvx_voxelize_triangle_candidates(
+    mvx_grid *grid,
+    mvx_v3 v0, mvx_v3 v1, mvx_v3 v2,
+    mvx_v3i clip_min, mvx_v3i clip_max)
+{
+  mvx_triangle_setup setup;
+  mvx_triangle_band band;
+  mvx_v3i i_min, i_max;
+  unsigned long result = 0;
+  int y, z;
+  float h = 0.5f * grid->vxsize;
+
+  if (!mvx_grid_triangle_range(grid, v0, v1, v2, &i_min, &i_max))
+  {
+    return 0;
+  }
+
+  i_min = mvx_v3i_max(i_min, clip_min);
+  i_max = mvx_v3i_min(i_max, clip_max);
+
+  if (i_min.x > i_max.x || i_min.y > i_max.y || i_min.z > i_max.z)
+  {
+    return 0;
+  }
+
+  mvx_triangle_setup_init(&setup, v0, v1, v2, mvx_v3_init(h, h, h));
+  mvx_triangle_band_init(&band, &setup, grid, i_min, i_max);
+
+  for (z = i_min.z; z <= i_max.z; ++z)
+  {
+    for (y = i_min.y; y <= i_max.y; ++y)
+    {
+      int x_begin, x_last;
+
+      if (mvx_triangle_band_row(&band, y, z, i_max.x, &x_begin, &x_last))
+      {
+        result += (unsigned long)(x_last - x_begin + 1);
+      }
+    }
+  }
+
+  return result;
+}
+
+/* Marks every voxel inside the clip box (inclusive) the triangle overlaps, stats may be 0 */
+MVX_API MVX_INLINE void mvx_voxelize_triangle(
+    mvx_grid *grid,
+    mvx_v3 v0, mvx_v3 v1, mvx_v3 v2,
+    mvx_v3i clip_min, mvx_v3i clip_max,
+    mvx_target *target,
+    mvx_stats *stats)
+{
+  mvx_triangle_setup setup;
+  mvx_triangle_band band;
+  mvx_v3i i_min, i_max;
+  int x, y, z, word;
+  float h = 0.5f * grid->vxsize;
+
+  if (!mvx_grid_triangle_range(grid, v0, v1, v2, &i_min, &i_max))
+  {
+    return;
+  }
+
+  i_min = mvx_v3i_max(i_min, clip_min);
+  i_max = mvx_v3i_min(i_max, clip_max);
+
+  if (i_min.x > i_max.x || i_min.y > i_max.y || i_min.z > i_max.z)
+  {
+    return;
+  }
+
+  MVX_STATS_ADD(stats, triangles, 1);
+
+  mvx_triangle_setup_init(&setup, v0, v1, v2, mvx_v3_init(h, h, h));
+  setup.stats = stats;
+  mvx_triangle_band_init(&band, &setup, grid, i_min, i_max);
+
+  /* scan the candidate voxels near the plane */
+  for (z = i_min.z; z <= i_max.z; ++z)
+  {
+    for (y = i_min.y; y <= i_max.y; ++y)
+    {
+      int x_begin, x_last;
+
+      if (!mvx_triangle_band_row(&band, y, z, i_max.x, &x_begin, &x_last))
+      {
+        MVX_STATS_ADD(stats, rows_rejected, 1);
+        continue;
+      }
+
+      MVX_STATS_ADD(stats, candidates, (unsigned long)(x_last - x_begin + 1));
+
+      for (word = x_begin / MVX_BITS_PER_WORD; word <= x_last / MVX_BITS_PER_WORD; ++word)
+      {
+        int x_end = word * MVX_BITS_PER_WORD + MVX_BITS_PER_WORD - 1;
+        unsigned int mask;
+
+        x = word * MVX_BITS_PER_WORD;
+
+        mask = mvx_voxelize_row_mask(
+            grid, &setup,
+            mvx_maxi(x, x_begin), mvx_mini(x_end, x_last), y, z);
+
+        if (mask)
+        {
+          mvx_target_write(target, grid, word, y, z, mask);
+        }
+      }
+    }
+  }
+}
+
+/* Edge function of the projected edge p -> q at sample s. Evaluated relative to the
+ * lexicographically smaller endpoint so that an edge shared by two triangles yields
+ * exactly negated values and every sample on it is counted by exactly one of them.
+ */
+MVX_API MVX_INLINE float mvx_edge_function(float pu, float pv, float qu, float qv, float su, float sv, int *include_zero)
+{
+  float e;
+
+  if (pu < qu || (pu == qu && pv < qv))
+  {
+    e = (qu - pu) * (sv - pv) - (qv - pv) * (su - pu);
+  }
+  else
+  {
+    e = -((pu - qu) * (sv - qv) - (pv - qv) * (su - qu));
+  }
+
+  /* tie breaking rule: flips with the edge direction */
+  *include_zero = (qv < pv) || (qv == pv && qu < pu);
+
+  return e;
+}
+
+/* Records where the triangle crosses the x-axis rows through the voxel centers.
+ * Every crossing toggles the first voxel whose center lies behind it.
+ */
+MVX_API MVX_INLINE void mvx_voxelize_triangle_crossings(
+    mvx_grid *grid,
+    mvx_v3 v0, mvx_v3 v1, mvx_v3 v2,
+    int z_begin, int z_end,
+    mvx_target *target)
+{
+  mvx_v3i i_min, i_max;
+  mvx_v3 t_min, t_max;
+  mvx_v3 n = mvx_v3_cross(mvx_v3_sub(v1, v0), mvx_v3_sub(v2, v0));
+  float d = mvx_v3_dot(n, v0);
+  int y, z;
+
+  /* triangle is parallel to the x-axis and never crosses a row */
+  if (n.x == 0.0f)
+  {
+    return;
+  }
+
+  /* project onto the yz plane with counter clockwise orientation */
+  if (n.x < 0.0f)
+  {
+    mvx_v3 tmp = v1;
+    v1 = v2;
+    v2 = tmp;
+  }
+
+  /* only the rows matter: crossings left of the grid still toggle its first voxel */
+  t_min = mvx_v3_init(grid->min_b.x, mvx_minf(v0.y, mvx_minf(v1.y, v2.y)), mvx_minf(v0.z, mvx_minf(v1.z, v2.z)));
+  t_max = mvx_v3_init(grid->min_b.x, mvx_maxf(v0.y, mvx_maxf(v1.y, v2.y)), mvx_maxf(v0.z, mvx_maxf(v1.z, v2.z)));
+
+  if (!mvx_grid_box_range(grid, t_min, t_max, &i_min, &i_max))
+  {
+    return;
+  }
+
+  i_min.z = mvx_maxi(i_min.z, z_begin);
+  i_max.z = mvx_mini(i_max.z, z_end - 1);
+
+  for (z = i_min.z; z <= i_max.z; ++z)
+  {
+    for (y = i_min.y; y <= i_max.y; ++y)
+    {
+      mvx_v3 s = mvx_grid_voxel_center(grid, 0, y, z);
+      int inc0, inc1, inc2;
+      float e0 = mvx_edge_function(v0.y, v0.z, v1.y, v1.z, s.y, s.z, &inc0);
+      float e1 = mvx_edge_function(v1.y, v1.z, v2.y, v2.z, s.y, s.z, &inc1);
+      float e2 = mvx_edge_function(v2.y, v2.z, v0.y, v0.z, s.y, s.z, &inc2);
+
+      if ((e0 > 0.0f || (e0 == 0.0f && inc0)) &&
+          (e1 > 0.0f || (e1 == 0.0f && inc1)) &&
+          (e2 > 0.0f || (e2 == 0.0f && inc2)))
+      {
+        float cross_x = (d - n.y * s.y - n.z * s.z) / n.x;
+        int x = mvx_ceilf((cross_x - grid->min_b.x) / grid->vxsize + (float)grid->margin.x - 0.5f);
+
+        if (x < grid->x)
+        {
+          mvx_target_toggle(target, grid, mvx_maxi(x, 0), y, z);
+        }
+      }
+    }
+  }
+}
+
+/* #############################################################################
+ * # Voxelization Modes
+ * #############################################################################
+ *
+ * MVX_MODE_CONSERVATIVE  every voxel the triangle touches (triangle/box SAT, default)
+ * MVX_MODE_26_SEPARATING the plane crosses the voxel (standard plane, radius
+ *                        h * (|n.x| + |n.y| + |n.z|)) and the projections overlap
+ *                        the voxel's faces. No 26-connected path of empty voxels
+ *                        passes through a closed surface. Half-open without
+ *                        tolerance, so a face on a voxel boundary sets one layer.
+ * MVX_MODE_6_SEPARATING  thin surface: the plane crosses the voxel's center
+ *                        segment along the dominant axis (radius h * max |n|) and
+ *                        the projections overlap the face diamonds. No 6-connected
+ *                        path passes through a closed surface.
+ * MVX_MODE_CENTER        voxels whose dominant axis center segment hits the
+ *                        triangle (watertight 2D rasterization, not separating)
+ *
+ * The plane test is done per voxel column along the dominant axis (see
+ * mvx_triangle_column), the separating modes add 2D edge functions of the
+ * projections onto yz, zx and xy. Degenerate triangles set no voxels. Every
+ * mode has a row kernel per dominant axis, chosen once per triangle, and like
+ * the conservative mode only visits the rows of the plane band (see
+ * mvx_triangle_band).
+ */
+#define MVX_MODE_CONSERVATIVE 0
+#define MVX_MODE_26_SEPARATING 1
+#define MVX_MODE_6_SEPARATING 2
+#define MVX_MODE_CENTER 3
+
+#define MVX_COLUMN_SNAP_EPSILON (1.0f / 64.0f)
+
+/* Where the triangle's plane crosses the voxel columns along the dominant axis of the normal,
+ * in voxel index space: a voxel of the column through (x, y, z) is inside the surface if its
+ * index k along the axis satisfies f - r <= k < f + r with f = base - (kx * qx + ky * qy + kz * qz)
+ * and q the voxel center relative to v0 (the term of the axis is 0). f only depends on the column,
+ * so neighbouring voxels of a column never both reject or both accept a crossing on their border.
+ * f is snapped onto the object's voxel range, like mvx_grid_triangle_range, so that faces on the
+ * mesh bounds land on the first and last voxel. Planes further outside (meshes crossing the bounds of
+ * an explicit grid) are left alone.
+ */
+typedef struct mvx_triangle_column
+{
+  int axis;        /* dominant axis (0 = x, 1 = y, 2 = z) */
+  float base;
+  float kx, ky, kz;
+  float r;         /* half thickness in voxels along the axis */
+  float lo, hi;    /* object voxel range along the axis */
+
+} mvx_triangle_column;
+
+/* standard selects the standard plane (26-separating) over the naive plane. Returns 0 for a degenerate triangle. */
+MVX_API MVX_INLINE int mvx_triangle_column_init(mvx_triangle_column *col, mvx_grid *grid, mvx_v3 v0, mvx_v3 n, int standard)
+{
+  mvx_v3 an = mvx_v3_abs(n);
+  float nw, scale;
+
+  col->axis = an.x >= an.y && an.x >= an.z ? 0 : (an.y >= an.z ? 1 : 2);
+  nw = col->axis == 0 ? n.x : (col->axis == 1 ? n.y : n.z);
+
+  if (nw == 0.0f)
+  {
+    return 0;
+  }
+
+  /* standard plane: h * (|n.x| + |n.y| + |n.z|) along n, naive plane: one voxel per column */
+  col->r = standard ? 0.5f * (an.x + an.y + an.z) / mvx_absf(nw) : 0.5f;
+
+  scale = 1.0f / (nw * grid->vxsize);
+  col->kx = col->axis == 0 ? 0.0f : n.x * scale;
+  col->ky = col->axis == 1 ? 0.0f : n.y * scale;
+  col->kz = col->axis == 2 ? 0.0f : n.z * scale;
+
+  if (col->axis == 0)
+  {
+    col->base = (v0.x - grid->min_b.x) / grid->vxsize + (float)grid->margin.x - 0.5f;
+    col->lo = (float)grid->margin.x;
+    col->hi = (float)(grid->margin.x + grid->need.x - 1);
+  }
+  else if (col->axis == 1)
+  {
+    col->base = (v0.y - grid->min_b.y) / grid->vxsize + (float)grid->margin.y - 0.5f;
+    col->lo = (float)grid->margin.y;
+    col->hi = (float)(grid->margin.y + grid->need.y - 1);
+  }
+  else
+  {
+    col->base = (v0.z - grid->min_b.z) / grid->vxsize + (float)grid->margin.z - 0.5f;
+    col->lo = (float)grid->margin.z;
+    col->hi = (float)(grid->margin.z + grid->need.z - 1);
+  }
+
+  return 1;
+}
+
+/* Snaps a plane crossing within half a voxel (plus rounding slack) outside the object range onto it */
+MVX_API MVX_INLINE float mvx_triangle_column_snap(mvx_triangle_column *col, float f)
+{
+  if (f < col->lo && f > col->lo - 0.5f - MVX_COLUMN_SNAP_EPSILON)
+  {
+    return col->lo;
+  }
+  if (f > col->hi && f < col->hi + 0.5f + MVX_COLUMN_SNAP_EPSILON)
+  {
+    return col->hi;
+  }
+  return f;
+}
+
+/* Bits of the voxels x_begin..x_end (one word chunk) of a row whose column crosses the plane, dominant axis x.
+ * f_row is the crossing of the row, all of its columns are the same one.
+ */
+MVX_API MVX_INLINE unsigned int mvx_triangle_column_mask_x(mvx_triangle_column *col, float f_row, int x_begin, int x_end)
+{
+  float f = mvx_triangle_column_snap(col, f_row);
+  float k_lo = f - col->r;
+  float k_hi = f + col->r;
+  unsigned int mask = 0;
+  int x;
+
+  for (x = x_begin; x <= x_end; ++x)
+  {
+    if ((float)x < k_lo || (float)x >= k_hi)
+    {
+      continue;
+    }
+
+    mask |= 1u << (x % MVX_BITS_PER_WORD);
+  }
+
+  return mask;
+}
+
+/* Bits of the voxels x_begin..x_end (one word chunk) of a row at index k_row along the dominant axis y or z
+ * whose column crossing f_row - kx * (x - v0.x) lies in the row. The crossing is monotonic in x, so only
+ * chunks whose crossings come near the object range pay for mvx_triangle_column_snap.
+ */
+MVX_API MVX_INLINE unsigned int mvx_triangle_column_mask(
+    mvx_triangle_column *col,
+    mvx_grid *grid,
+    float v0_x, float f_row, float k_row,
+    int x_begin, int x_end)
+{
+  float f_begin = f_row - col->kx * (grid->min_b.x + ((float)(x_begin - grid->margin.x) + 0.5f) * grid->vxsize - v0_x);
+  float f_end = f_row - col->kx * (grid->min_b.x + ((float)(x_end - grid->margin.x) + 0.5f) * grid->vxsize - v0_x);
+  float f_min = mvx_minf(f_begin, f_end);
+  float f_max = mvx_maxf(f_begin, f_end);
+  unsigned int mask = 0;
+  int x;
+
+  if ((f_max > col->lo - 0.5f - MVX_COLUMN_SNAP_EPSILON && f_min < col->lo) ||
+      (f_max > col->hi && f_min < col->hi + 0.5f + MVX_COLUMN_SNAP_EPSILON))
+  {
+    for (x = x_begin; x <= x_end; ++x)
+    {
+      float cx = grid->min_b.x + ((float)(x - grid->margin.x) + 0.5f) * grid->vxsize - v0_x;
+      float f = mvx_triangle_column_snap(col, f_row - col->kx * cx);
+
+      if (k_row < f - col->r || k_row >= f + col->r)
+      {
+        continue;
+      }
+
+      mask |= 1u << (x % MVX_BITS_PER_WORD);
+    }
+
+    return mask;
+  }
+
+  for (x = x_begin; x <= x_end; ++x)
+  {
+    float cx = grid->min_b.x + ((float)(x - grid->margin.x) + 0.5f) * grid->vxsize - v0_x;
+    float f = f_row - col->kx * cx;
+
+    if (k_row < f - col->r || k_row >= f + col->r)
+    {
+      continue;
+    }
+
+    mask |= 1u << (x % MVX_BITS_PER_WORD);
+  }
+
+  return mask;
+}
+
+/* Row kernel of a thin mode: sets the voxels of x_begin..x_last of row (y, z) the triangle (setup) covers */
+typedef void (*mvx_row_function)(mvx_grid *grid, void *setup, int x_begin, int x_last, int y, int z, mvx_target *target);
+
+typedef struct mvx_triangle_separating
+{
+  mvx_v3 v0;        /* world space v0, everything else is relative to it */
+  mvx_triangle_column column;
+  mvx_v3 tri_min;   /* triangle bounds */
+  mvx_v3 tri_max;
+  float h;          /* half voxel size */
+
+  /* edge functions a * u + b * v + c >= 0 of the projections (u, v) = (y, z), (z, x), (x, y),
+   * c already includes the radius of the projected voxel face (square or diamond)
+   */
+  float yz_a[3], yz_b[3], yz_c[3];
+  float zx_a[3], zx_b[3], zx_c[3];
+  float xy_a[3], xy_b[3], xy_c[3];
+
+} mvx_triangle_separating;
+
+/* Edge function i of a projected triangle p (relative to v0) with inward normals for the orientation
+ * (nw, normal component along the projection), offset by the radius of the voxel face square (or its
+ * inscribed diamond). A projection onto a segment (nw == 0) adds nothing to the column test and passes.
+ */
+MVX_API MVX_INLINE void mvx_triangle_separating_edge(
+    float pu[3], float pv[3], float nw, float h, int diamond, int i,
+    float *a, float *b, float *c)
+{
+  int j = (i + 1) % 3;
+  float eu = pu[j] - pu[i];
+  float ev = pv[j] - pv[i];
+  float sign = nw < 0.0f ? -1.0f : 1.0f;
+
+  if (nw == 0.0f)
+  {
+    *a = *b = *c = 0.0f;
+    return;
+  }
+
+  *a = -ev * sign;
+  *b = eu * sign;
+  *c = -(*a * pu[i] + *b * pv[i]) + h * (diamond ? mvx_maxf(mvx_absf(*a), mvx_absf(*b)) : mvx_absf(*a) + mvx_absf(*b));
+}
+
+/* Returns 0 for a degenerate triangle */
+MVX_API MVX_INLINE int mvx_triangle_separating_init(
+    mvx_triangle_separating *s,
+    mvx_grid *grid,
+    mvx_v3 v0, mvx_v3 v1, mvx_v3 v2,
+    int mode)
+{
+  mvx_v3 p1 = mvx_v3_sub(v1, v0);
+  mvx_v3 p2 = mvx_v3_sub(v2, v0);
+  mvx_v3 n = mvx_v3_cross(p1, p2);
+  float h = 0.5f * grid->vxsize;
+  float u[3], v[3];
+  int diamond = mode == MVX_MODE_6_SEPARATING;
+  int i;
+
+  if (!mvx_triangle_column_init(&s->column, grid, v0, n, !diamond))
+  {
+    return 0;
+  }
+
+  s->v0 = v0;
+  s->h = h;
+  s->tri_min = mvx_v3_min(mvx_v3_init(0.0f, 0.0f, 0.0f), mvx_v3_min(p1, p2));
+  s->tri_max = mvx_v3_max(mvx_v3_init(0.0f, 0.0f, 0.0f), mvx_v3_max(p1, p2));
+
+  u[0] = 0.0f;
+  v[0] = 0.0f;
+
+  /* yz */
+  u[1] = p1.y;
+  v[1] = p1.z;
+  u[2] = p2.y;
+  v[2] = p2.z;
+  for (i = 0; i < 3; ++i)
+  {
+    mvx_triangle_separating_edge(u, v, n.x, h, diamond, i, &s->yz_a[i], &s->yz_b[i], &s->yz_c[i]);
+  }
+
+  /* zx */
+  u[1] = p1.z;
+  v[1] = p1.x;
+  u[2] = p2.z;
+  v[2] = p2.x;
+  for (i = 0; i < 3; ++i)
+  {
+    mvx_triangle_separating_edge(u, v, n.y, h, diamond, i, &s->zx_a[i], &s->zx_b[i], &s->zx_c[i]);
+  }
+
+  /* xy */
+  u[1] = p1.x;
+  v[1] = p1.y;
+  u[2] = p2.x;
+  v[2] = p2.y;
+  for (i = 0; i < 3; ++i)
+  {
+    mvx_triangle_separating_edge(u, v, n.z, h, diamond, i, &s->xy_a[i], &s->xy_b[i], &s->xy_c[i]);
+  }
+
+  return 1;
+}
+
+/* Everything of a separating row (y, z) that does not depend on x, c is its voxel center relative to v0.
+ * Fills the edge functions k + slope * x of the zx and xy projections, returns 0 if the row misses the triangle.
+ */
+MVX_API MVX_INLINE int mvx_triangle_separating_row(mvx_triangle_separating *s, mvx_v3 c, float k[6], float slope[6])
+{
+  int i;
+
+  if (s->tri_max.y - c.y < -s->h || s->tri_min.y - c.y > s->h ||
+      s->tri_max.z - c.z < -s->h || s->tri_min.z - c.z > s->h)
+  {
+    return 0;
+  }
+
+  for (i = 0; i < 3; ++i)
+  {
+    if (s->yz_a[i] * c.y + s->yz_b[i] * c.z + s->yz_c[i] < 0.0f)
+    {
+      return 0;
+    }
+
+    k[i] = s->zx_a[i] * c.z + s->zx_c[i];
+    slope[i] = s->zx_b[i];
+    k[i + 3] = s->xy_b[i] * c.y + s->xy_c[i];
+    slope[i + 3] = s->xy_a[i];
+  }
+
+  return 1;
+}
+
+/* The projection tests of the voxels in plane (bits of the chunk x_begin..x_end whose column crosses the plane) */
+MVX_API MVX_INLINE unsigned int mvx_triangle_separating_mask(
+    mvx_grid *grid,
+    mvx_triangle_separating *s,
+    float k[6], float slope[6],
+    unsigned int plane,
+    int x_begin, int x_end)
+{
+  unsigned int mask = 0;
+  int i, x;
+
+  for (x = x_begin; x <= x_end; ++x)
+  {
+    float cx = grid->min_b.x + ((float)(x - grid->margin.x) + 0.5f) * grid->vxsize - s->v0.x;
+    unsigned int bit = 1u << (x % MVX_BITS_PER_WORD);
+
+    if (!(plane & bit) || s->tri_max.x - cx < -s->h || s->tri_min.x - cx > s->h)
+    {
+      continue;
+    }
+
+    for (i = 0; i < 6; ++i)
+    {
+      if (k[i] + slope[i] * cx < 0.0f)
+      {
+        break;
+      }
+    }
+
+    if (i == 6)
+    {
+      mask |= bit;
+    }
+  }
+
+  return mask;
+}
+
+/* Separating kernel for the dominant axis y or z, k_row is the row index along it */
+MVX_API MVX_INLINE void mvx_voxelize_row_separating_yz(
+    mvx_grid *grid,
+    mvx_triangle_separating *s,
+    float k_row,
+    int x_begin, int x_last, int y, int z,
+    mvx_target *target)
+{
+  mvx_triangle_column *col = &s->column;
+  mvx_v3 c = mvx_v3_sub(mvx_grid_voxel_center(grid, 0, y, z), s->v0);
+  float k[6], slope[6];
+  float f_row;
+  int word;
+
+  if (!mvx_triangle_separating_row(s, c, k, slope))
+  {
+    return;
+  }
+
+  f_row = col->base - (col->ky * c.y + col->kz * c.z);
+
+  for (word = x_begin / MVX_BITS_PER_WORD; word <= x_last / MVX_BITS_PER_WORD; ++word)
+  {
+    int x = mvx_maxi(word * MVX_BITS_PER_WORD, x_begin);
+    int x_end = mvx_mini(word * MVX_BITS_PER_WORD + MVX_BITS_PER_WORD - 1, x_last);
+    unsigned int plane = mvx_triangle_column_mask(col, grid, s->v0.x, f_row, k_row, x, x_end);
+    unsigned int mask = plane ? mvx_triangle_separating_mask(grid, s, k, slope, plane, x, x_end) : 0;
+
+    if (mask)
+    {
+      mvx_target_write(target, grid, word, y, z, mask);
+    }
+  }
+}
+
+/* Separating kernel for the dominant axis x */
+MVX_API MVX_INLINE void mvx_voxelize_row_separating_x(mvx_grid *grid, void *setup, int x_begin, int x_last, int y, int z, mvx_target *target)
+{
+  mvx_triangle_separating *s = (mvx_triangle_separating *)setup;
+  mvx_triangle_column *col = &s->column;
+  mvx_v3 c = mvx_v3_sub(mvx_grid_voxel_center(grid, 0, y, z), s->v0);
+  float k[6], slope[6];
+  float f_row;
+  int word;
+
+  if (!mvx_triangle_separating_row(s, c, k, slope))
+  {
+    return;
+  }
+
+  f_row = col->base - (col->ky * c.y + col->kz * c.z);
+
+  for (word = x_begin / MVX_BITS_PER_WORD; word <= x_last / MVX_BITS_PER_WORD; ++word)
+  {
+    int x = mvx_maxi(word * MVX_BITS_PER_WORD, x_begin);
+    int x_end = mvx_mini(word * MVX_BITS_PER_WORD + MVX_BITS_PER_WORD - 1, x_last);
+    unsigned int plane = mvx_triangle_column_mask_x(col, f_row, x, x_end);
+    unsigned int mask = plane ? mvx_triangle_separating_mask(grid, s, k, slope, plane, x, x_end) : 0;
+
+    if (mask)
+    {
+      mvx_target_write(target, grid, word, y, z, mask);
+    }
+  }
+}
+
+/* Separating kernel for the dominant axis y */
+MVX_API MVX_INLINE void mvx_voxelize_row_separating_y(mvx_grid *grid, void *setup, int x_begin, int x_last, int y, int z, mvx_target *target)
+{
+  mvx_voxelize_row_separating_yz(grid, (mvx_triangle_separating *)setup, (float)y, x_begin, x_last, y, z, target);
+}
+
+/* Separating kernel for the dominant axis z */
+MVX_API MVX_INLINE void mvx_voxelize_row_separating_z(mvx_grid *grid, void *setup, int x_begin, int x_last, int y, int z, mvx_target *target)
+{
+  mvx_voxelize_row_separating_yz(grid, (mvx_triangle_separating *)setup, (float)z, x_begin, x_last, y, z, target);
+}
+
+/* mvx_edge_function with the endpoint order resolved once per edge (same arithmetic) */
+typedef struct mvx_edge
+{
+  float pu, pv;     /* lexicographically smaller endpoint */
+  float du, dv;     /* other endpoint - pu, pv */
+  float sign;       /* -1 if the endpoints were swapped */
+  int include_zero;
+
+} mvx_edge;
+
+MVX_API MVX_INLINE void mvx_edge_init(mvx_edge *e, float pu, float pv, float qu, float qv)
+{
+  if (pu < qu || (pu == qu && pv < qv))
+  {
+    e->pu = pu;
+    e->pv = pv;
+    e->du = qu - pu;
+    e->dv = qv - pv;
+    e->sign = 1.0f;
+  }
+  else
+  {
+    e->pu = qu;
+    e->pv = qv;
+    e->du = pu - qu;
+    e->dv = pv - qv;
+    e->sign = -1.0f;
+  }
+
+  e->include_zero = (qv < pv) || (qv == pv && qu < pu);
+}
+
+/* Sample (su, sv) is on the inner side of the edge or on it and the edge owns it */
+MVX_API MVX_INLINE int mvx_edge_inside(mvx_edge *e, float su, float sv)
+{
+  float v = e->sign * (e->du * (sv - e->pv) - e->dv * (su - e->pu));
+  return v > 0.0f || (v == 0.0f && e->include_zero);
+}
+
+typedef struct mvx_triangle_center
+{
+  mvx_v3 v0;
+  mvx_triangle_column column;
+  mvx_edge edges[3];   /* edges of the projection along the column axis, counter clockwise */
+  mvx_v3 tri_min;      /* triangle bounds relative to v0 */
+  mvx_v3 tri_max;
+  float h;
+
+  /* conservative row rejection: yz projection against the voxel face (see mvx_triangle_separating) */
+  float yz_a[3], yz_b[3], yz_c[3];
+
+} mvx_triangle_center;
+
+/* Returns 0 for a degenerate triangle */
+MVX_API MVX_INLINE int mvx_triangle_center_init(
+    mvx_triangle_center *s,
+    mvx_grid *grid,
+    mvx_v3 v0, mvx_v3 v1, mvx_v3 v2)
+{
+  mvx_v3 p1 = mvx_v3_sub(v1, v0);
+  mvx_v3 p2 = mvx_v3_sub(v2, v0);
+  mvx_v3 n = mvx_v3_cross(p1, p2);
+  mvx_v3 v[3];
+  float pu[3], pv[3];
+  float nw;
+  int i;
+
+  if (!mvx_triangle_column_init(&s->column, grid, v0, n, 0))
+  {
+    return 0;
+  }
+
+  s->v0 = v0;
+  nw = s->column.axis == 0 ? n.x : (s->column.axis == 1 ? n.y : n.z);
+
+  /* counter clockwise orientation in the projection */
+  v[0] = v0;
+  v[1] = nw < 0.0f ? v2 : v1;
+  v[2] = nw < 0.0f ? v1 : v2;
+
+  for (i = 0; i < 3; ++i)
+  {
+    pu[i] = s->column.axis == 0 ? v[i].y : (s->column.axis == 1 ? v[i].z : v[i].x);
+    pv[i] = s->column.axis == 0 ? v[i].z : (s->column.axis == 1 ? v[i].x : v[i].y);
+  }
+
+  for (i = 0; i < 3; ++i)
+  {
+    mvx_edge_init(&s->edges[i], pu[i], pv[i], pu[(i + 1) % 3], pv[(i + 1) % 3]);
+  }
+
+  s->h = 0.5f * grid->vxsize;
+  s->tri_min = mvx_v3_min(mvx_v3_init(0.0f, 0.0f, 0.0f), mvx_v3_min(p1, p2));
+  s->tri_max = mvx_v3_max(mvx_v3_init(0.0f, 0.0f, 0.0f), mvx_v3_max(p1, p2));
+
+  pu[0] = 0.0f;
+  pv[0] = 0.0f;
+  pu[1] = p1.y;
+  pv[1] = p1.z;
+  pu[2] = p2.y;
+  pv[2] = p2.z;
+  for (i = 0; i < 3; ++i)
+  {
+    mvx_triangle_separating_edge(pu, pv, n.x, s->h, 0, i, &s->yz_a[i], &s->yz_b[i], &s->yz_c[i]);
+  }
+
+  return 1;
+}
+
+/* Rows (y, z) of a center kernel that cannot touch the triangle, qy and qz are relative to v0 */
+MVX_API MVX_INLINE int mvx_triangle_center_row(mvx_triangle_center *s, float qy, float qz)
+{
+  int i;
+
+  if (s->tri_max.y - qy < -s->h || s->tri_min.y - qy > s->h ||
+      s->tri_max.z - qz < -s->h || s->tri_min.z - qz > s->h)
+  {
+    return 0;
+  }
+
+  for (i = 0; i < 3; ++i)
+  {
+    if (s->yz_a[i] * qy + s->yz_b[i] * qz + s->yz_c[i] < 0.0f)
+    {
+      return 0;
+    }
+  }
+
+  return 1;
+}
+
+/* Center kernel for the dominant axis x: the sample (y, z) and the crossing are the same for the whole row */
+MVX_API MVX_INLINE void mvx_voxelize_row_center_x(mvx_grid *grid, void *setup, int x_begin, int x_last, int y, int z, mvx_target *target)
+{
+  mvx_triangle_center *s = (mvx_triangle_center *)setup;
+  mvx_triangle_column *col = &s->column;
+  mvx_v3 c = mvx_grid_voxel_center(grid, x_begin, y, z);
+  float qy = c.y - s->v0.y;
+  float qz = c.z - s->v0.z;
+  int word;
+
+  if (!mvx_triangle_center_row(s, qy, qz) ||
+      !mvx_edge_inside(&s->edges[0], c.y, c.z) ||
+      !mvx_edge_inside(&s->edges[1], c.y, c.z) ||
+      !mvx_edge_inside(&s->edges[2], c.y, c.z))
+  {
+    return;
+  }
+
+  for (word = x_begin / MVX_BITS_PER_WORD; word <= x_last / MVX_BITS_PER_WORD; ++word)
+  {
+    int x = mvx_maxi(word * MVX_BITS_PER_WORD, x_begin);
+    int x_end = mvx_mini(word * MVX_BITS_PER_WORD + MVX_BITS_PER_WORD - 1, x_last);
+    unsigned int mask = mvx_triangle_column_mask_x(col, col->base - (col->ky * qy + col->kz * qz), x, x_end);
+
+    if (mask)
+    {
+      mvx_target_write(target, grid, word, y, z, mask);
+    }
+  }
+}
+
+/* Center kernel for the dominant axis y, the samples are (z, x) */
+MVX_API MVX_INLINE void mvx_voxelize_row_center_y(mvx_grid *grid, void *setup, int x_begin, int x_last, int y, int z, mvx_target *target)
+{
+  mvx_triangle_center *s = (mvx_triangle_center *)setup;
+  mvx_triangle_column *col = &s->column;
+  mvx_v3 c = mvx_grid_voxel_center(grid, x_begin, y, z);
+  float qy = c.y - s->v0.y;
+  float qz = c.z - s->v0.z;
+  float f_row = col->base - (col->ky * qy + col->kz * qz);
+  int word, x;
+
+  if (!mvx_triangle_center_row(s, qy, qz))
+  {
+    return;
+  }
+
+  for (word = x_begin / MVX_BITS_PER_WORD; word <= x_last / MVX_BITS_PER_WORD; ++word)
+  {
+    int x_end = mvx_mini(word * MVX_BITS_PER_WORD + MVX_BITS_PER_WORD - 1, x_last);
+    unsigned int plane, mask = 0;
+
+    x = mvx_maxi(word * MVX_BITS_PER_WORD, x_begin);
+    plane = mvx_triangle_column_mask(col, grid, s->v0.x, f_row, (float)y, x, x_end);
+
+    for (; plane && x <= x_end; ++x)
+    {
+      unsigned int bit = 1u << (x % MVX_BITS_PER_WORD);
+      float cx = grid->min_b.x + ((float)(x - grid->margin.x) + 0.5f) * grid->vxsize;
+
+      if ((plane & bit) &&
+          mvx_edge_inside(&s->edges[0], c.z, cx) &&
+          mvx_edge_inside(&s->edges[1], c.z, cx) &&
+          mvx_edge_inside(&s->edges[2], c.z, cx))
+      {
+        mask |= bit;
+      }
+    }
+
+    if (mask)
+    {
+      mvx_target_write(target, grid, word, y, z, mask);
+    }
+  }
+}
+
+/* Center kernel for the dominant axis z, the samples are (x, y) */
+MVX_API MVX_INLINE void mvx_voxelize_row_center_z(mvx_grid *grid, void *setup, int x_begin, int x_last, int y, int z, mvx_target *target)
+{
+  mvx_triangle_center *s = (mvx_triangle_center *)setup;
+  mvx_triangle_column *col = &s->column;
+  mvx_v3 c = mvx_grid_voxel_center(grid, x_begin, y, z);
+  float qy = c.y - s->v0.y;
+  float qz = c.z - s->v0.z;
+  float f_row = col->base - (col->ky * qy + col->kz * qz);
+  int word, x;
+
+  if (!mvx_triangle_center_row(s, qy, qz))
+  {
+    return;
+  }
+
+  for (word = x_begin / MVX_BITS_PER_WORD; word <= x_last / MVX_BITS_PER_WORD; ++word)
+  {
+    int x_end = mvx_mini(word * MVX_BITS_PER_WORD + MVX_BITS_PER_WORD - 1, x_last);
+    unsigned int plane, mask = 0;
+
+    x = mvx_maxi(word * MVX_BITS_PER_WORD, x_begin);
+    plane = mvx_triangle_column_mask(col, grid, s->v0.x, f_row, (float)z, x, x_end);
+
+    for (; plane && x <= x_end; ++x)
+    {
+      unsigned int bit = 1u << (x % MVX_BITS_PER_WORD);
+      float cx = grid->min_b.x + ((float)(x - grid->margin.x) + 0.5f) * grid->vxsize;
+
+      if ((plane & bit) &&
+          mvx_edge_inside(&s->edges[0], cx, c.y) &&
+          mvx_edge_inside(&s->edges[1], cx, c.y) &&
+          mvx_edge_inside(&s->edges[2], cx, c.y))
+      {
+        mask |= bit;
+      }
+    }
+
+    if (mask)
+    {
+      mvx_target_write(target, grid, word, y, z, mask);
+    }
+  }
+}
+
+/* mvx_voxelize_triangle for the given MVX_MODE_* */
+MVX_API MVX_INLINE void mvx_voxelize_triangle_mode(
+    mvx_grid *grid,
+    mvx_v3 v0, mvx_v3 v1, mvx_v3 v2,
+    mvx_v3i clip_min, mvx_v3i clip_max,
+    int mode,
+    mvx_target *target,
+    mvx_stats *stats)
+{
+  mvx_triangle_separating separating;
+  mvx_triangle_center center;
+  mvx_triangle_setup setup;
+  mvx_triangle_band band;
+  mvx_row_function row;
+  void *data;
+  mvx_v3i i_min, i_max;
+  mvx_v3 an;
+  int axis, y, z;
+  float h = 0.5f * grid->vxsize;
+
+  if (mode == MVX_MODE_CONSERVATIVE)
+  {
+    mvx_voxelize_triangle(grid, v0, v1, v2, clip_min, clip_max, target, stats);
+    return;
+  }
+
+  if (!mvx_grid_triangle_range(grid, v0, v1, v2, &i_min, &i_max))
+  {
+    return;
+  }
+
+  i_min = mvx_v3i_max(i_min, clip_min);
+  i_max = mvx_v3i_min(i_max, clip_max);
+
+  if (i_min.x > i_max.x || i_min.y > i_max.y || i_min.z > i_max.z)
+  {
+    return;
+  }
+
+  MVX_STATS_ADD(stats, triangles, 1);
+
+  /* the kernel is chosen once per triangle, by mode and dominant axis */
+  if (mode == MVX_MODE_CENTER)
+  {
+    if (!mvx_triangle_center_init(&center, grid, v0, v1, v2))
+    {
+      return;
+    }
+
+    axis = center.column.axis;
+    data = &center;
+    row = axis == 0 ? mvx_voxelize_row_center_x : (axis == 1 ? mvx_voxelize_row_center_y : mvx_voxelize_row_center_z);
+  }
+  else
+  {
+    if (!mvx_triangle_separating_init(&separating, grid, v0, v1, v2, mode))
+    {
+      return;
+    }
+
+    axis = separating.column.axis;
+    data = &separating;
+    row = axis == 0 ? mvx_voxelize_row_separating_x : (axis == 1 ? mvx_voxelize_row_separating_y : mvx_voxelize_row_separating_z);
+  }
+
+  /* The thin modes only set voxels the conservative test would visit, except for crossings
+   * mvx_triangle_column_snap moves by up to half a voxel along the dominant axis: widen the band by a voxel.
+   */
+  mvx_triangle_setup_init(&setup, v0, v1, v2, mvx_v3_init(h, h, h));
+  mvx_triangle_band_init(&band, &setup, grid, i_min, i_max);
+  an = mvx_v3_abs(setup.n);
+  band.rad += grid->vxsize * mvx_maxf(an.x, mvx_maxf(an.y, an.z));
+
+  for (z = i_min.z; z <= i_max.z; ++z)
+  {
+    for (y = i_min.y; y <= i_max.y; ++y)
+    {
+      int x_begin, x_last;
+
+      if (!mvx_triangle_band_row(&band, y, z, i_max.x, &x_begin, &x_last))
+      {
+        MVX_STATS_ADD(stats, rows_rejected, 1);
+        continue;
+      }
+
+      MVX_STATS_ADD(stats, candidates, (unsigned long)(x_last - x_begin + 1));
+
+      row(grid, data, x_begin, x_last, y, z, target);
+    }
+  }
+}
+
+/* #############################################################################
+ * # Mesh Input
+ * #############################################################################
+ *
+ * A mesh is a view of caller memory: positions are three floats at any byte
+ * stride (e.g. interleaved with normals and uvs), triangles are index
+ * triplets of one MVX_INDEX_* type or consecutive vertices (MVX_INDEX_NONE).
+ * Nothing is copied. Sweeps fetch triangles in batches of MVX_MESH_BATCH with
+ * one loop per index type, so the type is not dispatched per triangle.
+ */
+#define MVX_INDEX_NONE 0 /* no indices, triangle t is made of the vertices 3t, 3t + 1, 3t + 2 */
+#define MVX_INDEX_U16 1  /* unsigned short */
+#define MVX_INDEX_U32 2  /* unsigned int */
+#define MVX_INDEX_I32 3  /* int, negative indices are invalid */
+
+#define MVX_MESH_BATCH 64
+
+typedef struct mvx_mesh
+{
+  unsigned char *vertices;      /* Position (x, y, z floats) of the first vertex. */
+  unsigned long vertex_stride;  /* Bytes from one position to the next, 3 * sizeof(float) when packed. */
+  unsigned long vertex_count;   /* The number of vertices. */
+  void *indices;                /* Index triplets of index_type, unused with MVX_INDEX_NONE. */
+  int index_type;               /* MVX_INDEX_* */
+  unsigned long triangle_count; /* The number of triangles. */
+
+} mvx_mesh;
+
+/* Packed positions (vertices_size floats) and int indices (indices_size ints) */
+MVX_API MVX_INLINE mvx_mesh mvx_mesh_init(float *vertices, unsigned long vertices_size, int *indices, unsigned long indices_size)
+{
+  mvx_mesh result;
+  result.vertices = (unsigned char *)vertices;
+  result.vertex_stride = 3 * sizeof(float);
+  result.vertex_count = vertices_size / 3;
+  result.indices = indices;
+  result.index_type = MVX_INDEX_I32;
+  result.triangle_count = indices_size / 3;
+  return result;
+}
+
+/* Positions at vertex_stride bytes, index_count indices of index_type (ignored with MVX_INDEX_NONE) */
+MVX_API MVX_INLINE mvx_mesh mvx_mesh_init_strided(
+    void *vertices, unsigned long vertex_stride, unsigned long vertex_count,
+    void *indices, int index_type, unsigned long index_count)
+{
+  mvx_mesh result;
+  result.vertices = (unsigned char *)vertices;
+  result.vertex_stride = vertex_stride;
+  result.vertex_count = vertex_count;
+  result.indices = index_type == MVX_INDEX_NONE ? 0 : indices;
+  result.index_type = index_type;
+  result.triangle_count = (index_type == MVX_INDEX_NONE ? vertex_count : index_count) / 3;
+  return result;
+}
+
+MVX_API MVX_INLINE unsigned long mvx_mesh_triangle_count(mvx_mesh *mesh)
+{
+  return mesh->triangle_count;
+}
+
+MVX_API MVX_INLINE mvx_v3 mvx_mesh_position(mvx_mesh *mesh, unsigned long v)
+{
+  float *p = (float *)(void *)(mesh->vertices + v * mesh->vertex_stride);
+  return mvx_v3_init(p[0], p[1], p[2]);
+}
+
+/* Vertex indices of triangle t, negative int indices wrap to out of range values */
+MVX_API MVX_INLINE void mvx_mesh_triangle_indices(mvx_mesh *mesh, unsigned long t, unsigned long *a, unsigned long *b, unsigned long *c)
+{
+  if (mesh->index_type == MVX_INDEX_U16)
+  {
+    unsigned short *p = (unsigned short *)mesh->indices + 3 * t;
+    *a = p[0], *b = p[1], *c = p[2];
+  }
+  else if (mesh->index_type == MVX_INDEX_U32)
+  {
+    unsigned int *p = (unsigned int *)mesh->indices + 3 * t;
+    *a = p[0], *b = p[1], *c = p[2];
+  }
+  else if (mesh->index_type == MVX_INDEX_I32)
+  {
+    int *p = (int *)mesh->indices + 3 * t;
+    *a = (unsigned long)p[0], *b = (unsigned long)p[1], *c = (unsigned long)p[2];
+  }
+  else
+  {
+    *a = 3 * t, *b = 3 * t + 1, *c = 3 * t + 2;
+  }
+}
+
+/* Fetches triangle t. Returns 0 if any of its indices is out of range. */
+MVX_API MVX_INLINE int mvx_mesh_triangle(
+    mvx_mesh *mesh, unsigned long t,
+    mvx_v3 *v0, mvx_v3 *v1, mvx_v3 *v2)
+{
+  unsigned long a, b, c;
+
+  mvx_mesh_triangle_indices(mesh, t, &a, &b, &c);
+
+  if (a >= mesh->vertex_count || b >= mesh->vertex_count || c >= mesh->vertex_count)
+  {
+    return 0;
+  }
+
+  *v0 = mvx_mesh_position(mesh, a);
+  *v1 = mvx_mesh_position(mesh, b);
+  *v2 = mvx_mesh_position(mesh, c);
+
+  return 1;
+}
+
+MVX_API MVX_INLINE int mvx_mesh_valid(mvx_mesh *mesh)
+{
+  return mesh->vertices && (mesh->indices || mesh->index_type == MVX_INDEX_NONE) &&
+         mesh->index_type >= MVX_INDEX_NONE && mesh->index_type <= MVX_INDEX_I32 &&
+         mesh->vertex_stride >= 3 * sizeof(float) && mesh->vertex_stride % sizeof(float) == 0 &&
+         mesh->vertex_count > 0 && mesh->triangle_count > 0;
+}
+
+/* Bounds of all vertices of the mesh */
+MVX_API MVX_INLINE void mvx_mesh_bounds(mvx_mesh *mesh, mvx_v3 *min_out, mvx_v3 *max_out)
+{
+  unsigned long v;
+
+  *min_out = *max_out = mvx_mesh_position(mesh, 0);
+
+  for (v = 1; v < mesh->vertex_count; ++v)
+  {
+    mvx_v3 current_v = mvx_mesh_position(mesh, v);
+    *min_out = mvx_v3_min(*min_out, current_v);
+    *max_out = mvx_v3_max(*max_out, current_v);
+  }
+}
+
+/* Triangles of one fetch, invalid triangles are already dropped */
+typedef struct mvx_mesh_batch
+{
+  unsigned long triangles[MVX_MESH_BATCH]; /* Mesh index of every fetched triangle. */
+  mvx_v3 v[3 * MVX_MESH_BATCH];            /* Its three positions. */
+  int count;
+
+} mvx_mesh_batch;
+
+MVX_API MVX_INLINE void mvx_mesh_batch_push(mvx_mesh *mesh, mvx_mesh_batch *batch, unsigned long t, unsigned long a, unsigned long b, unsigned long c)
+{
+  mvx_v3 *v = batch->v + 3 * batch->count;
+
+  if (a >= mesh->vertex_count || b >= mesh->vertex_count || c >= mesh->vertex_count)
+  {
+    return;
+  }
+
+  v[0] = mvx_mesh_position(mesh, a);
+  v[1] = mvx_mesh_position(mesh, b);
+  v[2] = mvx_mesh_position(mesh, c);
+  batch->triangles[batch->count++] = t;
+}
+
+/* Size of the batch starting at i of the range ending at end */
+MVX_API MVX_INLINE unsigned long mvx_mesh_batch_count(unsigned long i, unsigned long end)
+{
+  return end - i < MVX_MESH_BATCH ? end - i : MVX_MESH_BATCH;
+}
+
+/* Fetches the triangles ids[first..first + count - 1] (first..first + count - 1 if ids is 0),
+ * count must not exceed MVX_MESH_BATCH.
+ */
+MVX_API MVX_INLINE void mvx_mesh_fetch(mvx_mesh *mesh, unsigned int *ids, unsigned long first, unsigned long count, mvx_mesh_batch *batch)
+{
+  unsigned long end = first + count;
+  unsigned long i, t;
+
+  batch->count = 0;
+
+  if (mesh->index_type == MVX_INDEX_U16)
+  {
+    unsigned short *p = (unsigned short *)mesh->indices;
+
+    for (i = first; i < end; ++i)
+    {
+      t = ids ? ids[i] : i;
+      mvx_mesh_batch_push(mesh, batch, t, p[3 * t + 0], p[3 * t + 1], p[3 * t + 2]);
+    }
+  }
+  else if (mesh->index_type == MVX_INDEX_U32)
+  {
+    unsigned int *p = (unsigned int *)mesh->indices;
+
+    for (i = first; i < end; ++i)
+    {
+      t = ids ? ids[i] : i;
+      mvx_mesh_batch_push(mesh, batch, t, p[3 * t + 0], p[3 * t + 1], p[3 * t + 2]);
+    }
+  }
+  else if (mesh->index_type == MVX_INDEX_I32)
+  {
+    int *p = (int *)mesh->indices;
+
+    for (i = first; i < end; ++i)
+    {
+      t = ids ? ids[i] : i;
+      mvx_mesh_batch_push(mesh, batch, t, (unsigned long)p[3 * t + 0], (unsigned long)p[3 * t + 1], (unsigned long)p[3 * t + 2]);
+    }
+  }
+  else
+  {
+    for (i = first; i < end; ++i)
+    {
+      t = ids ? ids[i] : i;
+      mvx_mesh_batch_push(mesh, batch, t, 3 * t, 3 * t + 1, 3 * t + 2);
+    }
+  }
+}
+
+/* #############################################################################
+ * # Triangle Binning
+ * #############################################################################
+ *
+ * Triangles are assigned to every brick (brick_size^3 voxels) their candidate
+ * range touches. Voxelizing brick by brick keeps the writes of all triangles
+ * of a brick inside a few cache lines. The lists are built with a counting
+ * sort in arena memory:
+ *
+ *   triangles of brick b = triangles[offsets[b]] .. triangles[offsets[b + 1] - 1]
+ *   b = bx + by * count.x + bz * count.x * count.y
+ */
+typedef struct mvx_bins
+{
+  int brick_size;          /* Edge length of a brick in voxels. */
+  mvx_v3i count;           /* Number of bricks along each axis. */
+  unsigned long *offsets;  /* count.x * count.y * count.z + 1 entries. */
+  unsigned int *triangles; /* Triangle indices of all bricks. */
+
+} mvx_bins;
+
+MVX_API MVX_INLINE long mvx_bins_brick_count(mvx_grid *grid, int brick_size)
+{
+  return (long)((grid->x + brick_size - 1) / brick_size) *
+         (long)((grid->y + brick_size - 1) / brick_size) *
+         (long)((grid->z + brick_size - 1) / brick_size);
+}
+
+/* Brick range (inclusive) touched by a triangle. Returns 0 if the triangle is outside. */
+MVX_API MVX_INLINE int mvx_bins_triangle_range(mvx_grid *grid, mvx_v3 v0, mvx_v3 v1, mvx_v3 v2, int brick_size, mvx_v3i *b_min, mvx_v3i *b_max)
+{
+  mvx_v3i i_min, i_max;
+
+  if (!mvx_grid_triangle_range(grid, v0, v1, v2, &i_min, &i_max))
+  {
+    return 0;
+  }
+
+  *b_min = mvx_v3i_init(i_min.x / brick_size, i_min.y / brick_size, i_min.z / brick_size);
+  *b_max = mvx_v3i_init(i_max.x / brick_size, i_max.y / brick_size, i_max.z / brick_size);
+
+  return 1;
+}
+
+/* Sum of the bricks touched by every triangle */
+MVX_API MVX_INLINE unsigned long mvx_bins_entry_count(mvx_grid *grid, mvx_mesh *mesh, int brick_size)
+{
+  unsigned long tricount = mvx_mesh_triangle_count(mesh);
+  unsigned long entries = 0;
+  unsigned long t;
+  mvx_mesh_batch batch;
+  int k;
+
+  for (t = 0; t < tricount; t += MVX_MESH_BATCH)
+  {
+    mvx_mesh_fetch(mesh, 0, t, mvx_mesh_batch_count(t, tricount), &batch);
+
+    for (k = 0; k < batch.count; ++k)
+    {
+      mvx_v3 *v = batch.v + 3 * k;
+      mvx_v3i b_min, b_max;
+
+      if (mvx_bins_triangle_range(grid, v[0], v[1], v[2], brick_size, &b_min, &b_max))
+      {
+        entries += (unsigned long)(b_max.x - b_min.x + 1) * (unsigned long)(b_max.y - b_min.y + 1) * (unsigned long)(b_max.z - b_min.z + 1);
+      }
+    }
+  }
+
+  return entries;
+}
+
+/* Exact number of arena bytes mvx_bins_build needs */
+MVX_API MVX_INLINE unsigned long mvx_bins_memory_size(mvx_grid *grid, mvx_mesh *mesh, int brick_size)
+{
+  return mvx_arena_aligned_size((unsigned long)(mvx_bins_brick_count(grid, brick_size) + 1) * (unsigned long)sizeof(unsigned long)) +
+         mvx_arena_aligned_size(mvx_bins_entry_count(grid, mesh, brick_size) * (unsigned long)sizeof(unsigned int));
+}
+
+/* Builds the per brick triangle lists. Returns 0 if the arena is too small. */
+MVX_API MVX_INLINE int mvx_bins_build(mvx_bins *bins, mvx_grid *grid, mvx_mesh *mesh, int brick_size, mvx_arena *arena)
+{
+  unsigned long tricount = mvx_mesh_triangle_count(mesh);
+  long bricks = mvx_bins_brick_count(grid, brick_size);
+  long b;
+  unsigned long t;
+  unsigned long total = 0;
+  mvx_mesh_batch batch;
+  int k, x, y, z;
+
+  /* triangle ids are stored as 32 bit */
+  if (brick_size <= 0 || (tricount >> 16) >> 16)
+  {
+    return 0;
+  }
+
+  bins->brick_size = brick_size;
+  bins->count = mvx_v3i_init(
+      (grid->x + brick_size - 1) / brick_size,
+      (grid->y + brick_size - 1) / brick_size,
+      (grid->z + brick_size - 1) / brick_size);
+
+  bins->offsets = (unsigned long *)mvx_arena_push(arena, (unsigned long)(bricks + 1) * (unsigned long)sizeof(unsigned long));
+
+  if (!bins->offsets)
+  {
+    return 0;
+  }
+
+  for (b = 0; b <= bricks; ++b)
+  {
+    bins->offsets[b] = 0;
+  }
+
+  /* count */
+  for (t = 0; t < tricount; t += MVX_MESH_BATCH)
+  {
+    mvx_mesh_fetch(mesh, 0, t, mvx_mesh_batch_count(t, tricount), &batch);
+
+    for (k = 0; k < batch.count; ++k)
+    {
+      mvx_v3 *v = batch.v + 3 * k;
+      mvx_v3i b_min, b_max;
+
+      if (!mvx_bins_triangle_range(grid, v[0], v[1], v[2], brick_size, &b_min, &b_max))
+      {
+        continue;
+      }
+
+      for (z = b_min.z; z <= b_max.z; ++z)
+      {
+        for (y = b_min.y; y <= b_max.y; ++y)
+        {
+          for (x = b_min.x; x <= b_max.x; ++x)
+          {
+            bins->offsets[x + y * bins->count.x + (long)z * bins->count.x * bins->count.y]++;
+          }
+        }
+      }
+    }
+  }
+
+  /* exclusive prefix sum */
+  for (b = 0; b < bricks; ++b)
+  {
+    unsigned long c = bins->offsets[b];
+    bins->offsets[b] = total;
+    total += c;
+  }
+  bins->offsets[bricks] = total;
+
+  bins->triangles = (unsigned int *)mvx_arena_push(arena, total * (unsigned long)sizeof(unsigned int));
+
+  if (!bins->triangles && total > 0)
+  {
+    return 0;
+  }
+
+  /* fill, afterwards offsets[b] points to the end of brick b */
+  for (t = 0; t < tricount; t += MVX_MESH_BATCH)
+  {
+    mvx_mesh_fetch(mesh, 0, t, mvx_mesh_batch_count(t, tricount), &batch);
+
+    for (k = 0; k < batch.count; ++k)
+    {
+      mvx_v3 *v = batch.v + 3 * k;
+      mvx_v3i b_min, b_max;
+
+      if (!mvx_bins_triangle_range(grid, v[0], v[1], v[2], brick_size, &b_min, &b_max))
+      {
+        continue;
+      }
+
+      for (z = b_min.z; z <= b_max.z; ++z)
+      {
+        for (y = b_min.y; y <= b_max.y; ++y)
+        {
+          for (x = b_min.x; x <= b_max.x; ++x)
+          {
+            bins->triangles[bins->offsets[x + y * bins->count.x + (long)z * bins->count.x * bins->count.y]++] = (unsigned int)batch.triangles[k];
+          }
+        }
+      }
+    }
+  }
+
+  /* shift back to the starts */
+  for (b = bricks; b > 0; --b)
+  {
+    bins->offsets[b] = bins->offsets[b - 1];
+  }
+  bins->offsets[0] = 0;
+
+  return 1;
+}
+
+/* #############################################################################
+ * # Voxelization Jobs
+ * #############################################################################
+ *
+ * A job voxelizes the slices z_begin..z_end - 1 of the grid and only writes
+ * to those slices. The single threaded entry points run one job over the
+ * whole grid, the parallel ones split the grid into slabs of slices and hand
+ * them to a caller supplied dispatcher. Since every voxel only depends on the
+ * triangles and its own position the results are bit-identical.
+ */
+
+/* Called by the dispatcher for every job_index in 0..job_count - 1 */
+typedef void (*mvx_job_function)(void *job_data, int job_index);
+
+/* Has to call job(job_data, i) for every i in 0..job_count - 1 (in any order, on any thread)
+ * and must only return after all of them finished.
+ */
+typedef void (*mvx_dispatch_function)(void *user_data, mvx_job_function job, void *job_data, int job_count);
+
+typedef struct mvx_voxelize_job
+{
+  mvx_mesh mesh;
+  mvx_grid grid;
+  mvx_target target;
+  mvx_bins *bins; /* optional: sweep brick by brick, slabs are whole brick layers */
+  unsigned int *triangles;      /* optional: only visit these triangles (ignored with bins) */
+  unsigned long triangle_count;
+  int solid;      /* fill the interior (parity crossings along x) */
+  int mode;       /* MVX_MODE_* of the surface sweep */
+  int job_count;  /* number of slabs the grid is split into */
+  mvx_stats *stats; /* optional: counters and phase times of this job (MVX_STATS), one per thread */
+
+} mvx_voxelize_job;
+
+/* Interior of the slices z_begin..z_end - 1: parity crossings along x, then one linear fill pass per row */
+MVX_API MVX_INLINE void mvx_voxelize_job_parity(mvx_voxelize_job *job, int z_begin, int z_end)
+{
+  unsigned long tricount = job->triangles ? job->triangle_count : mvx_mesh_triangle_count(&job->mesh);
+  unsigned long i;
+  mvx_mesh_batch batch;
+  int b;
+
+  for (i = 0; i < tricount; i += MVX_MESH_BATCH)
+  {
+    mvx_mesh_fetch(&job->mesh, job->triangles, i, mvx_mesh_batch_count(i, tricount), &batch);
+
+    for (b = 0; b < batch.count; ++b)
+    {
+      mvx_v3 *v = batch.v + 3 * b;
+      mvx_voxelize_triangle_crossings(&job->grid, v[0], v[1], v[2], z_begin, z_end, &job->target);
+    }
+  }
+
+  mvx_target_fill_parity(&job->target, &job->grid, z_begin, z_end);
+}
+
+MVX_API MVX_INLINE void mvx_voxelize_job_slab(mvx_voxelize_job *job, int z_begin, int z_end)
+{
+  unsigned long tricount = job->triangles ? job->triangle_count : mvx_mesh_triangle_count(&job->mesh);
+  unsigned long i;
+  mvx_v3i clip_min = mvx_v3i_init(0, 0, z_begin);
+  mvx_v3i clip_max = mvx_v3i_init(job->grid.x - 1, job->grid.y - 1, z_end - 1);
+  mvx_mesh_batch batch;
+  int k;
+
+  /* clear voxels */
+  MVX_STATS_PHASE_BEGIN(job->stats);
+  mvx_target_clear(&job->target, &job->grid, z_begin, z_end);
+  MVX_STATS_PHASE_END(job->stats, clear_time);
+
+  MVX_STATS_PHASE_BEGIN(job->stats);
+
+  if (job->solid)
+  {
+    mvx_voxelize_job_parity(job, z_begin, z_end);
+  }
+
+  /* triangle sweep */
+  if (job->bins)
+  {
+    mvx_bins *bins = job->bins;
+    int size = bins->brick_size;
+    int bx, by, bz;
+
+    for (bz = z_begin / size; bz * size < z_end; ++bz)
+    {
+      for (by = 0; by < bins->count.y; ++by)
+      {
+        for (bx = 0; bx < bins->count.x; ++bx)
+        {
+          long b = bx + by * bins->count.x + (long)bz * bins->count.x * bins->count.y;
+
+          clip_min = mvx_v3i_init(bx * size, by * size, mvx_maxi(bz * size, z_begin));
+          clip_max = mvx_v3i_init(bx * size + size - 1, by * size + size - 1, mvx_mini(bz * size + size, z_end) - 1);
+
+          for (i = bins->offsets[b]; i < bins->offsets[b + 1]; i += MVX_MESH_BATCH)
+          {
+            mvx_mesh_fetch(&job->mesh, bins->triangles, i, mvx_mesh_batch_count(i, bins->offsets[b + 1]), &batch);
+
+            for (k = 0; k < batch.count; ++k)
+            {
+              mvx_v3 *v = batch.v + 3 * k;
+              mvx_target_triangle(&job->target, batch.triangles[k], v[0], v[1], v[2]);
+              mvx_voxelize_triangle_mode(&job->grid, v[0], v[1], v[2], clip_min, clip_max, job->mode, &job->target, job->stats);
+            }
+          }
+        }
+      }
+    }
+  }
+  else
+  {
+    for (i = 0; i < tricount; i += MVX_MESH_BATCH)
+    {
+      mvx_mesh_fetch(&job->mesh, job->triangles, i, mvx_mesh_batch_count(i, tricount), &batch);
+
+      for (k = 0; k < batch.count; ++k)
+      {
+        mvx_v3 *v = batch.v + 3 * k;
+        mvx_target_triangle(&job->target, batch.triangles[k], v[0], v[1], v[2]);
+        mvx_voxelize_triangle_mode(&job->grid, v[0], v[1], v[2], clip_min, clip_max, job->mode, &job->target, job->stats);
+      }
+    }
+  }
+
+  MVX_STATS_PHASE_END(job->stats, sweep_time);
+}
+
+MVX_API MVX_INLINE void mvx_voxelize_job_run(void *job_data, int job_index)
+{
+  mvx_voxelize_job *job = (mvx_voxelize_job *)job_data;
+  int z_begin = (int)((long)job->grid.z * job_index / job->job_count);
+  int z_end = (int)((long)job->grid.z * (job_index + 1) / job->job_count);
+
+  /* binned jobs own whole brick layers */
+  if (job->bins)
+  {
+    int layers = job->bins->count.z;
+    int size = job->bins->brick_size;
+
+    z_begin = (int)((long)layers * job_index / job->job_count) * size;
+    z_end = mvx_mini((int)((long)layers * (job_index + 1) / job->job_count) * size, job->grid.z);
+  }
+
+  if (z_begin < z_end)
+  {
+    mvx_voxelize_job_slab(job, z_begin, z_end);
+  }
+}
+
+/* Job over a mesh view and a caller defined grid mapping, grid may be 0 if there is none */
+MVX_API MVX_INLINE int mvx_voxelize_job_init_mesh_grid(
+    mvx_voxelize_job *job,
+    mvx_mesh *mesh,
+    mvx_grid *grid,
+    int solid,
+    mvx_target target)
+{
+  job->mesh = *mesh;
+  job->target = target;
+  job->bins = 0;
+  job->triangles = 0;
+  job->triangle_count = 0;
+  job->solid = solid;
+  job->mode = MVX_MODE_CONSERVATIVE;
+  job->job_count = 1;
+  job->stats = 0;
+
+  if (!grid || !mvx_mesh_valid(&job->mesh) || (solid && !mvx_target_solid_kind(target.kind)))
+  {
+    return 0;
+  }
+
+  job->grid = *grid;
+
+  return 1;
+}
+
+/* Job over a caller defined grid mapping (see mvx_grid_init), grid may be 0 if there is none */
+MVX_API MVX_INLINE int mvx_voxelize_job_init_grid(
+    mvx_voxelize_job *job,
+    float *vertices, unsigned long vertices_size,
+    int *indices, unsigned long indices_size,
+    mvx_grid *grid,
+    int solid,
+    mvx_target target)
+{
+  mvx_mesh mesh = mvx_mesh_init(vertices, vertices_size, indices, indices_size);
+
+  return mvx_voxelize_job_init_mesh_grid(job, &mesh, grid, solid, target);
+}
+
+/* Job over a mesh view (see mvx_mesh_init_strided) and the grid fitted to its bounds */
+MVX_API MVX_INLINE int mvx_voxelize_job_init_mesh(
+    mvx_voxelize_job *job,
+    mvx_mesh *mesh,
+    int grid_x, int grid_y, int grid_z,
+    int grid_pad_x, int grid_pad_y, int grid_pad_z,
+    int solid,
+    mvx_target target)
+{
+  mvx_grid grid;
+  mvx_v3 min_b, max_b;
+  int fitted = 0;
+
+  if (mesh && mvx_mesh_valid(mesh))
+  {
+    mvx_mesh_bounds(mesh, &min_b, &max_b);
+    fitted = mvx_grid_fit_bounds(&grid, min_b, max_b, grid_x, grid_y, grid_z, grid_pad_x, grid_pad_y, grid_pad_z);
+  }
+
+  return fitted && mvx_voxelize_job_init_mesh_grid(job, mesh, &grid, solid, target);
+}
+
+/* Job over the grid fitted to the mesh bounds */
+MVX_API MVX_INLINE int mvx_voxelize_job_init(
+    mvx_voxelize_job *job,
+    float *vertices, unsigned long vertices_size,
+    int *indices, unsigned long indices_size,
+    int grid_x, int grid_y, int grid_z,
+    int grid_pad_x, int grid_pad_y, int grid_pad_z,
+    int solid,
+    mvx_target target)
+{
+  mvx_grid grid;
+  int fitted = mvx_grid_fit(&grid, vertices, vertices_size, grid_x, grid_y, grid_z, grid_pad_x, grid_pad_y, grid_pad_z);
+
+  return mvx_voxelize_job_init_grid(job, vertices, vertices_size, indices, indices_size, fitted ? &grid : 0, solid, target);
+}
+
+/* mvx_voxelize_mesh_target that adds the counters and phase times (bounds pass included) of the sweep to stats */
+MVX_API MVX_INLINE int mvx_voxelize_mesh_stats_target(
+    float *vertices, unsigned long vertices_size,
+    int *indices, unsigned long indices_size,
+    int grid_x, int grid_y, int grid_z,
+    int grid_pad_x, int grid_pad_y, int grid_pad_z,
+    int solid,
+    mvx_target target,
+    mvx_stats *stats)
+{
+  mvx_voxelize_job job;
+  mvx_grid grid;
+  int fitted;
+
+  MVX_STATS_PHASE_BEGIN(stats);
+  fitted = mvx_grid_fit(&grid, vertices, vertices_size, grid_x, grid_y, grid_z, grid_pad_x, grid_pad_y, grid_pad_z);
+  MVX_STATS_PHASE_END(stats, bounds_time);
+
+  if (!mvx_voxelize_job_init_grid(&job, vertices, vertices_size, indices, indices_size, fitted ? &grid : 0, solid, target))
+  {
+    return 0;
+  }
+
+  job.stats = stats;
+  mvx_voxelize_job_slab(&job, 0, grid_z);
+
+  return 1;
+}
+
+MVX_API MVX_INLINE int mvx_voxelize_mesh_target(
+    float *vertices, unsigned long vertices_size,
+    int *indices, unsigned long indices_size,
+    int grid_x, int grid_y, int grid_z,
+    int grid_pad_x, int grid_pad_y, int grid_pad_z,
+    int solid,
+    mvx_target target)
+{
+  return mvx_voxelize_mesh_stats_target(
+      vertices, vertices_size, indices, indices_size,
+      grid_x, grid_y, grid_z, grid_pad_x, grid_pad_y, grid_pad_z,
+      solid, target, 0);
+}
+
+/* Sweeps the mesh over a caller defined grid mapping: no bounds pass, triangles outside of the grid are culled */
+MVX_API MVX_INLINE int mvx_voxelize_mesh_grid_target(
+    float *vertices, unsigned long vertices_size,
+    int *indices, unsigned long indices_size,
+    mvx_grid *grid,
+    int solid,
+    int mode,
+    mvx_target target)
+{
+  mvx_voxelize_job job;
+
+  if (mode < MVX_MODE_CONSERVATIVE || mode > MVX_MODE_CENTER)
+  {
+    return 0;
+  }
+
+  if (!mvx_voxelize_job_init_grid(&job, vertices, vertices_size, indices, indices_size, grid, solid, target))
+  {
+    return 0;
+  }
+
+  job.mode = mode;
+  mvx_voxelize_job_slab(&job, 0, job.grid.z);
+
+  return 1;
+}
+
+MVX_API MVX_INLINE int mvx_voxelize_mesh_mode_target(
+    float *vertices, unsigned long vertices_size,
+    int *indices, unsigned long indices_size,
+    int grid_x, int grid_y, int grid_z,
+    int grid_pad_x, int grid_pad_y, int grid_pad_z,
+    int mode,
+    mvx_target target)
+{
+  mvx_voxelize_job job;
+
+  if (mode < MVX_MODE_CONSERVATIVE || mode > MVX_MODE_CENTER)
+  {
+    return 0;
+  }
+
+  if (!mvx_voxelize_job_init(&job, vertices, vertices_size, indices, indices_size, grid_x, grid_y, grid_z, grid_pad_x, grid_pad_y, grid_pad_z, 0, target))
+  {
+    return 0;
+  }
+
+  job.mode = mode;
+  mvx_voxelize_job_slab(&job, 0, grid_z);
+
+  return 1;
+}
+
+MVX_API MVX_INLINE int mvx_voxelize_mesh_parallel_target(
+    float *vertices, unsigned long vertices_size,
+    int *indices, unsigned long indices_size,
+    int grid_x, int grid_y, int grid_z,
+    int grid_pad_x, int grid_pad_y, int grid_pad_z,
+    int solid,
+    mvx_dispatch_function dispatch, void *dispatch_user_data, int job_count,
+    mvx_target target)
+{
+  mvx_voxelize_job job;
+
+  if (!dispatch || job_count <= 0)
+  {
+    return 0;
+  }
+
+  if (!mvx_voxelize_job_init(&job, vertices, vertices_size, indices, indices_size, grid_x, grid_y, grid_z, grid_pad_x, grid_pad_y, grid_pad_z, solid, target))
+  {
+    return 0;
+  }
+
+  /* a slab has at least one slice */
+  job.job_count = mvx_mini(job_count, grid_z);
+
+  dispatch(dispatch_user_data, mvx_voxelize_job_run, &job, job.job_count);
+
+  return 1;
+}
+
+MVX_API MVX_INLINE int mvx_voxelize_mesh_binned_target(
+    float *vertices, unsigned long vertices_size,
+    int *indices, unsigned long indices_size,
+    int grid_x, int grid_y, int grid_z,
+    int grid_pad_x, int grid_pad_y, int grid_pad_z,
+    int brick_size,
+    void *memory, unsigned long memory_size,
+    mvx_dispatch_function dispatch, void *dispatch_user_data,
+    mvx_target target)
+{
+  mvx_voxelize_job job;
+  mvx_bins bins;
+  mvx_arena arena;
+
+  if (brick_size <= 0)
+  {
+    return 0;
+  }
+
+  if (!mvx_voxelize_job_init(&job, vertices, vertices_size, indices, indices_size, grid_x, grid_y, grid_z, grid_pad_x, grid_pad_y, grid_pad_z, 0, target))
+  {
+    return 0;
+  }
+
+  mvx_arena_init(&arena, memory, memory_size);
+
+  if (!mvx_bins_build(&bins, &job.grid, &job.mesh, brick_size, &arena))
+  {
+    return 0;
+  }
+
+  job.bins = &bins;
+
+  if (dispatch)
+  {
+    /* one job per brick layer */
+    job.job_count = bins.count.z;
+    dispatch(dispatch_user_data, mvx_voxelize_job_run, &job, job.job_count);
+  }
+  else
+  {
+    mvx_voxelize_job_slab(&job, 0, grid_z);
+  }
+
+  return 1;
+}
+
+/* Arena bytes mvx_voxelize_mesh_binned needs for this mesh and grid (0 on invalid input) */
+MVX_API MVX_INLINE unsigned long mvx_voxelize_mesh_binned_memory_size(
+    float *vertices, unsigned long vertices_size,
+    int *indices, unsigned long indices_size,
+    int grid_x, int grid_y, int grid_z,
+    int grid_pad_x, int grid_pad_y, int grid_pad_z,
+    int brick_size)
+{
+  mvx_voxelize_job job;
+  mvx_target target;
+
+  target = mvx_target_init(MVX_TARGET_BYTES);
+
+  if (brick_size <= 0 || !mvx_voxelize_job_init(&job, vertices, vertices_size, indices, indices_size, grid_x, grid_y, grid_z, grid_pad_x, grid_pad_y, grid_pad_z, 0, target))
+  {
+    return 0;
+  }
+
+  return mvx_bins_memory_size(&job.grid, &job.mesh, brick_size);
+}
+
+/* Worst case arena bytes of mvx_voxelize_mesh_sparse: the index plus one brick for every
+ * brick touched by a triangle (bounded by the number of bricks of the grid).
+ */
+MVX_API MVX_INLINE unsigned long mvx_voxelize_mesh_sparse_memory_size(
+    float *vertices, unsigned long vertices_size,
+    int *indices, unsigned long indices_size,
+    int grid_x, int grid_y, int grid_z,
+    int grid_pad_x, int grid_pad_y, int grid_pad_z)
+{
+  mvx_voxelize_job job;
+  unsigned long bricks;
+  unsigned long index;
+
+  if (!mvx_voxelize_job_init(&job, vertices, vertices_size, indices, indices_size, grid_x, grid_y, grid_z, grid_pad_x, grid_pad_y, grid_pad_z, 0, mvx_target_init(MVX_TARGET_BRICKMAP)))
+  {
+    return 0;
+  }
+
+  index = (unsigned long)mvx_brickmap_index_count(grid_x, grid_y, grid_z);
+  bricks = mvx_bins_entry_count(&job.grid, &job.mesh, MVX_BRICK_SIZE);
+
+  if (bricks > index)
+  {
+    bricks = index;
+  }
+
+  return mvx_arena_aligned_size(index * (unsigned long)sizeof(unsigned int)) + bricks * MVX_BRICK_WORDS * (unsigned long)sizeof(unsigned int);
+}
+
+/* Receives the finished slices z_begin..z_begin + z_count - 1 of a streamed grid, laid out like the
+ * dense output (unsigned char or unsigned int words for the bit-packed variant). The buffer is reused
+ * for the next slab. Return 0 to stop the voxelization.
+ */
+typedef int (*mvx_slab_function)(void *user_data, void *voxels, int z_begin, int z_count);
+
+/* Bytes of a slab buffer of slab_depth slices */
+MVX_API MVX_INLINE unsigned long mvx_streaming_slab_size(int grid_x, int grid_y, int slab_depth, int kind)
+{
+  if (kind == MVX_TARGET_BITS)
+  {
+    return (unsigned long)mvx_bits_row_words(grid_x) * (unsigned long)grid_y * (unsigned long)slab_depth * (unsigned long)sizeof(unsigned int);
+  }
+
+  return (unsigned long)grid_x * (unsigned long)grid_y * (unsigned long)slab_depth;
+}
+
+/* Arena bytes of the streaming voxelizer: the per slab triangle lists and one slab buffer */
+MVX_API MVX_INLINE unsigned long mvx_voxelize_mesh_streaming_target_memory_size(
+    float *vertices, unsigned long vertices_size,
+    int *indices, unsigned long indices_size,
+    int grid_x, int grid_y, int grid_z,
+    int grid_pad_x, int grid_pad_y, int grid_pad_z,
+    int slab_depth, int kind)
+{
+  mvx_voxelize_job job;
+  unsigned long tricount, t;
+  unsigned long entries = 0;
+  mvx_mesh_batch batch;
+  int slabs, k;
+
+  if (slab_depth <= 0 || !mvx_voxelize_job_init(&job, vertices, vertices_size, indices, indices_size, grid_x, grid_y, grid_z, grid_pad_x, grid_pad_y, grid_pad_z, 0, mvx_target_init(kind)))
+  {
+    return 0;
+  }
+
+  slabs = (grid_z + slab_depth - 1) / slab_depth;
+  tricount = mvx_mesh_triangle_count(&job.mesh);
+
+  for (t = 0; t < tricount; t += MVX_MESH_BATCH)
+  {
+    mvx_mesh_fetch(&job.mesh, 0, t, mvx_mesh_batch_count(t, tricount), &batch);
+
+    for (k = 0; k < batch.count; ++k)
+    {
+      mvx_v3 *v = batch.v + 3 * k;
+      mvx_v3i s_min, s_max;
+
+      if (mvx_bins_triangle_range(&job.grid, v[0], v[1], v[2], slab_depth, &s_min, &s_max))
+      {
+        entries += (unsigned long)(s_max.z - s_min.z + 1);
+      }
+    }
+  }
+
+  return mvx_arena_aligned_size((unsigned long)(slabs + 1) * (unsigned long)sizeof(unsigned long)) +
+         mvx_arena_aligned_size(entries * (unsigned long)sizeof(unsigned int)) +
+         mvx_arena_aligned_size(mvx_streaming_slab_size(grid_x, grid_y, slab_depth, kind));
+}
+
+/* Voxelizes slab_depth slices at a time into one slab buffer and passes every finished slab to
+ * the callback. Triangles are bucketed by the slabs their z range touches first (counting sort),
+ * so memory is bounded by the slab size and the triangle lists, not by the grid volume.
+ */
+MVX_API MVX_INLINE int mvx_voxelize_mesh_streaming_target(
+    float *vertices, unsigned long vertices_size,
+    int *indices, unsigned long indices_size,
+    int grid_x, int grid_y, int grid_z,
+    int grid_pad_x, int grid_pad_y, int grid_pad_z,
+    int solid, int slab_depth,
+    void *memory, unsigned long memory_size,
+    mvx_slab_function callback, void *callback_user_data,
+    int kind)
+{
+  mvx_voxelize_job job;
+  mvx_arena arena;
+  unsigned long *offsets;
+  unsigned int *triangles;
+  void *slab;
+  unsigned long tricount, t;
+  unsigned long total = 0;
+  mvx_mesh_batch batch;
+  int slabs, i, k, z;
+
+  if (!callback || slab_depth <= 0 || (kind != MVX_TARGET_BYTES && kind != MVX_TARGET_BITS))
+  {
+    return 0;
+  }
+
+  if (!mvx_voxelize_job_init(&job, vertices, vertices_size, indices, indices_size, grid_x, grid_y, grid_z, grid_pad_x, grid_pad_y, grid_pad_z, solid, mvx_target_init(kind)))
+  {
+    return 0;
+  }
+
+  tricount = mvx_mesh_triangle_count(&job.mesh);
+
+  /* triangle ids are stored as 32 bit */
+  if ((tricount >> 16) >> 16)
+  {
+    return 0;
+  }
+
+  slab_depth = mvx_mini(slab_depth, grid_z);
+  slabs = (grid_z + slab_depth - 1) / slab_depth;
+
+  mvx_arena_init(&arena, memory, memory_size);
+  offsets = (unsigned long *)mvx_arena_push(&arena, (unsigned long)(slabs + 1) * (unsigned long)sizeof(unsigned long));
+
+  if (!offsets)
+  {
+    return 0;
+  }
+
+  for (i = 0; i <= slabs; ++i)
+  {
+    offsets[i] = 0;
+  }
+
+  /* count */
+  for (t = 0; t < tricount; t += MVX_MESH_BATCH)
+  {
+    mvx_mesh_fetch(&job.mesh, 0, t, mvx_mesh_batch_count(t, tricount), &batch);
+
+    for (k = 0; k < batch.count; ++k)
+    {
+      mvx_v3 *v = batch.v + 3 * k;
+      mvx_v3i s_min, s_max;
+
+      if (mvx_bins_triangle_range(&job.grid, v[0], v[1], v[2], slab_depth, &s_min, &s_max))
+      {
+        for (i = s_min.z; i <= s_max.z; ++i)
+        {
+          offsets[i]++;
+        }
+      }
+    }
+  }
+
+  /* exclusive prefix sum */
+  for (i = 0; i < slabs; ++i)
+  {
+    unsigned long c = offsets[i];
+    offsets[i] = total;
+    total += c;
+  }
+  offsets[slabs] = total;
+
+  triangles = (unsigned int *)mvx_arena_push(&arena, total * (unsigned long)sizeof(unsigned int));
+  slab = mvx_arena_push(&arena, mvx_streaming_slab_size(grid_x, grid_y, slab_depth, kind));
+
+  if ((!triangles && total > 0) || !slab)
+  {
+    return 0;
+  }
+
+  /* fill, afterwards offsets[i] points to the end of slab i */
+  for (t = 0; t < tricount; t += MVX_MESH_BATCH)
+  {
+    mvx_mesh_fetch(&job.mesh, 0, t, mvx_mesh_batch_count(t, tricount), &batch);
+
+    for (k = 0; k < batch.count; ++k)
+    {
+      mvx_v3 *v = batch.v + 3 * k;
+      mvx_v3i s_min, s_max;
+
+      if (mvx_bins_triangle_range(&job.grid, v[0], v[1], v[2], slab_depth, &s_min, &s_max))
+      {
+        for (i = s_min.z; i <= s_max.z; ++i)
+        {
+          triangles[offsets[i]++] = (unsigned int)batch.triangles[k];
+        }
+      }
+    }
+  }
+
+  /* shift back to the starts */
+  for (i = slabs; i > 0; --i)
+  {
+    offsets[i] = offsets[i - 1];
+  }
+  offsets[0] = 0;
+
+  if (kind == MVX_TARGET_BITS)
+  {
+    job.target.bits = (unsigned int *)slab;
+  }
+  else
+  {
+    job.target.bytes = (unsigned char *)slab;
+  }
+
+  for (i = 0, z = 0; i < slabs; ++i, z += slab_depth)
+  {
+    int z_end = mvx_mini(z + slab_depth, grid_z);
+
+    job.target.z_origin = z;
+    job.triangles = triangles + offsets[i];
+    job.triangle_count = offsets[i + 1] - offsets[i];
+
+    mvx_voxelize_job_slab(&job, z, z_end);
+
+    if (!callback(callback_user_data, slab, z, z_end - z))
+    {
+      return 0;
+    }
+  }
+
+  return 1;
+}
+
+/* Aspect-ratio preserving, centered voxelizer with padding */
+MVX_API MVX_INLINE int mvx_voxelize_mesh(
+    float *vertices,              /* The array of vertex positions (x, y, z) for the mesh. */
+    unsigned long vertices_size,  /* The number of floats in the vertices array. This should be 3 times the number of vertices. */
+    int *indices,                 /* The array of triangle indices. Each triplet of indices forms a triangle. */
+    unsigned long indices_size,   /* The number of integers in the indices array. This should be 3 times the number of triangles. */
+    int grid_x,                   /* The total number of voxels along the x-axis of the grid. */
+    int grid_y,                   /* The total number of voxels along the y-axis of the grid. */
+    int grid_z,                   /* The total number of voxels along the z-axis of the grid. */
+    int grid_pad_x,               /* The number of empty voxels to pad on both the left and right sides of the grid. */
+    int grid_pad_y,               /* The number of empty voxels to pad on both the bottom and top sides of the grid. */
+    int grid_pad_z,               /* The number of empty voxels to pad on both the front and back sides of the grid. */
+    unsigned char *output_voxels) /* The output array of unsigned characters where the voxelized mesh will be stored. A value of 1 means the voxel is occupied. */
+{
+  mvx_target target;
+
+  if (!output_voxels)
+  {
+    return 0;
+  }
+
+  target = mvx_target_init(MVX_TARGET_BYTES);
+  target.bytes = output_voxels;
+
+  return mvx_voxelize_mesh_target(
+      vertices, vertices_size, indices, indices_size,
+      grid_x, grid_y, grid_z, grid_pad_x, grid_pad_y, grid_pad_z,
+      0, target);
+}
+
+/* Same as mvx_voxelize_mesh but stores one bit per voxel (8x less memory) */
+MVX_API MVX_INLINE int mvx_voxelize_mesh_bits(
+    float *vertices,             /* The array of vertex positions (x, y, z) for the mesh. */
+    unsigned long vertices_size, /* The number of floats in the vertices array. This should be 3 times the number of vertices. */
+    int *indices,                /* The array of triangle indices. Each triplet of indices forms a triangle. */
+    unsigned long indices_size,  /* The number of integers in the indices array. This should be 3 times the number of triangles. */
+    int grid_x,                  /* The total number of voxels along the x-axis of the grid. */
+    int grid_y,                  /* The total number of voxels along the y-axis of the grid. */
+    int grid_z,                  /* The total number of voxels along the z-axis of the grid. */
+    int grid_pad_x,              /* The number of empty voxels to pad on both the left and right sides of the grid. */
+    int grid_pad_y,              /* The number of empty voxels to pad on both the bottom and top sides of the grid. */
+    int grid_pad_z,              /* The number of empty voxels to pad on both the front and back sides of the grid. */
+    unsigned int *output_bits)   /* The output bitmask of mvx_bits_size(grid_x, grid_y, grid_z) words. A set bit means the voxel is occupied. */
+{
+  mvx_target target;
+
+  if (!output_bits)
+  {
+    return 0;
+  }
+
+  target = mvx_target_init(MVX_TARGET_BITS);
+  target.bits = output_bits;
+
+  return mvx_voxelize_mesh_target(
+      vertices, vertices_size, indices, indices_size,
+      grid_x, grid_y, grid_z, grid_pad_x, grid_pad_y, grid_pad_z,
+      0, target);
+}
+
+/* Same as mvx_voxelize_mesh but also fills the interior of the mesh.
+ * The mesh has to be watertight (closed), otherwise the interior can leak along x.
+ */
+MVX_API MVX_INLINE int mvx_voxelize_mesh_solid(
+    float *vertices, unsigned long vertices_size,
+    int *indices, unsigned long indices_size,
+    int grid_x, int grid_y, int grid_z,
+    int grid_pad_x, int grid_pad_y, int grid_pad_z,
+    unsigned char *output_voxels)
+{
+  mvx_target target;
+
+  if (!output_voxels)
+  {
+    return 0;
+  }
+
+  target = mvx_target_init(MVX_TARGET_BYTES);
+  target.bytes = output_voxels;
+
+  return mvx_voxelize_mesh_target(
+      vertices, vertices_size, indices, indices_size,
+      grid_x, grid_y, grid_z, grid_pad_x, grid_pad_y, grid_pad_z,
+      1, target);
+}
+
+/* Bit-packed variant of mvx_voxelize_mesh_solid */
+MVX_API MVX_INLINE int mvx_voxelize_mesh_solid_bits(
+    float *vertices, unsigned long vertices_size,
+    int *indices, unsigned long indices_size,
+    int grid_x, int grid_y, int grid_z,
+    int grid_pad_x, int grid_pad_y, int grid_pad_z,
+    unsigned int *output_bits)
+{
+  mvx_target target;
+
+  if (!output_bits)
+  {
+    return 0;
+  }
+
+  target = mvx_target_init(MVX_TARGET_BITS);
+  target.bits = output_bits;
+
+  return mvx_voxelize_mesh_target(
+      vertices, vertices_size, indices, indices_size,
+      grid_x, grid_y, grid_z, grid_pad_x, grid_pad_y, grid_pad_z,
+      1, target);
+}
+
+/* Same as mvx_voxelize_mesh_target over a mesh view: strided positions, u16/u32/int or no indices */
+MVX_API MVX_INLINE int mvx_voxelize_mesh_input_target(
+    mvx_mesh *mesh,
+    int grid_x, int grid_y, int grid_z,
+    int grid_pad_x, int grid_pad_y, int grid_pad_z,
+    int solid,
+    mvx_target target)
+{
+  mvx_voxelize_job job;
+
+  if (!mvx_voxelize_job_init_mesh(&job, mesh, grid_x, grid_y, grid_z, grid_pad_x, grid_pad_y, grid_pad_z, solid, target))
+  {
+    return 0;
+  }
+
+  mvx_voxelize_job_slab(&job, 0, grid_z);
+
+  return 1;
+}
+
+/* Same as mvx_voxelize_mesh (solid = 0) or mvx_voxelize_mesh_solid over a mesh view, e.g.
+ *   mvx_mesh mesh = mvx_mesh_init_strided(vertices, sizeof(vertex), vertex_count, indices, MVX_INDEX_U16, index_count);
+ */
+MVX_API MVX_INLINE int mvx_voxelize_mesh_input(
+    mvx_mesh *mesh,
+    int grid_x, int grid_y, int grid_z,
+    int grid_pad_x, int grid_pad_y, int grid_pad_z,
+    int solid,
+    unsigned char *output_voxels)
+{
+  mvx_target target;
+
+  if (!output_voxels)
+  {
+    return 0;
+  }
+
+  target = mvx_target_init(MVX_TARGET_BYTES);
+  target.bytes = output_voxels;
+
+  return mvx_voxelize_mesh_input_target(mesh, grid_x, grid_y, grid_z, grid_pad_x, grid_pad_y, grid_pad_z, solid, target);
+}
+
+/* Bit-packed variant of mvx_voxelize_mesh_input */
+MVX_API MVX_INLINE int mvx_voxelize_mesh_input_bits(
+    mvx_mesh *mesh,
+    int grid_x, int grid_y, int grid_z,
+    int grid_pad_x, int grid_pad_y, int grid_pad_z,
+    int solid,
+    unsigned int *output_bits)
+{
+  mvx_target target;
+
+  if (!output_bits)
+  {
+    return 0;
+  }
+
+  target = mvx_target_init(MVX_TARGET_BITS);
+  target.bits = output_bits;
+
+  return mvx_voxelize_mesh_input_target(mesh, grid_x, grid_y, grid_z, grid_pad_x, grid_pad_y, grid_pad_z, solid, target);
+}
+
+/* Same as mvx_voxelize_mesh (or mvx_voxelize_mesh_solid) but also writes the attribute channels of
+ * every surface voxel in the same sweep. Pass 0 for the channels you don't need, see mvx_attributes.
+ */
+MVX_API MVX_INLINE int mvx_voxelize_mesh_attributes(
+    float *vertices, unsigned long vertices_size,
+    int *indices, unsigned long indices_size,
+    int grid_x, int grid_y, int grid_z,
+    int grid_pad_x, int grid_pad_y, int grid_pad_z,
+    int solid,                          /* 1 to also fill the interior (occupancy only). */
+    unsigned int *triangle_materials,   /* Material id per triangle, required for output_materials. */
+    unsigned char *output_voxels,       /* grid_x * grid_y * grid_z occupancy bytes. */
+    unsigned int *output_triangles,     /* Optional: first triangle per voxel or MVX_ATTRIBUTE_NONE. */
+    unsigned int *output_materials,     /* Optional: its material or MVX_ATTRIBUTE_NONE. */
+    float *output_normals)              /* Optional: 3 floats per voxel, summed area weighted normals. */
+{
+  mvx_attributes attributes;
+  mvx_target target;
+
+  if (!output_voxels || (output_materials && !triangle_materials))
+  {
+    return 0;
+  }
+
+  attributes.triangles = output_triangles;
+  attributes.materials = output_materials;
+  attributes.normals = output_normals;
+  attributes.triangle_materials = triangle_materials;
+
+  target = mvx_target_init(MVX_TARGET_ATTRIBUTES);
+  target.bytes = output_voxels;
+  target.attributes = &attributes;
+
+  return mvx_voxelize_mesh_target(
+      vertices, vertices_size, indices, indices_size,
+      grid_x, grid_y, grid_z, grid_pad_x, grid_pad_y, grid_pad_z,
+      solid, target);
+}
+
+/* Upper bound of the memory mvx_voxelize_mesh_rle needs: one record per triangle, row and word chunk */
+MVX_API MVX_INLINE unsigned long mvx_voxelize_mesh_rle_memory_size(
+    float *vertices, unsigned long vertices_size,
+    int *indices, unsigned long indices_size,
+    int grid_x, int grid_y, int grid_z,
+    int grid_pad_x, int grid_pad_y, int grid_pad_z)
+{
+  mvx_voxelize_job job;
+  mvx_target target;
+  unsigned long tricount, t;
+  unsigned long records = 0;
+  mvx_mesh_batch batch;
+  int k;
+
+  target = mvx_target_init(MVX_TARGET_SPANS);
+
+  if (!mvx_voxelize_job_init(&job, vertices, vertices_size, indices, indices_size, grid_x, grid_y, grid_z, grid_pad_x, grid_pad_y, grid_pad_z, 0, target))
+  {
+    return 0;
+  }
+
+  tricount = mvx_mesh_triangle_count(&job.mesh);
+
+  for (t = 0; t < tricount; t += MVX_MESH_BATCH)
+  {
+    mvx_mesh_fetch(&job.mesh, 0, t, mvx_mesh_batch_count(t, tricount), &batch);
+
+    for (k = 0; k < batch.count; ++k)
+    {
+      mvx_v3 *v = batch.v + 3 * k;
+      mvx_v3i i_min, i_max;
+
+      if (mvx_grid_triangle_range(&job.grid, v[0], v[1], v[2], &i_min, &i_max))
+      {
+        records += (unsigned long)(i_max.x / MVX_BITS_PER_WORD - i_min.x / MVX_BITS_PER_WORD + 1) *
+                   (unsigned long)(i_max.y - i_min.y + 1) * (unsigned long)(i_max.z - i_min.z + 1);
+      }
+    }
+  }
+
+  return mvx_rle_memory_size(grid_y, grid_z, records);
+}
+
+/* Same as mvx_voxelize_mesh but stores run-length encoded rows, see Run-Length Encoded Rows */
+MVX_API MVX_INLINE int mvx_voxelize_mesh_rle(
+    float *vertices, unsigned long vertices_size,
+    int *indices, unsigned long indices_size,
+    int grid_x, int grid_y, int grid_z,
+    int grid_pad_x, int grid_pad_y, int grid_pad_z,
+    void *memory, unsigned long memory_size, /* Holds the spans, see mvx_voxelize_mesh_rle_memory_size. */
+    mvx_rle *output_rle)
+{
+  mvx_voxelize_job job;
+  mvx_target target;
+  mvx_arena arena;
+
+  if (!output_rle || grid_y <= 0 || grid_z <= 0)
+  {
+    return 0;
+  }
+
+  target = mvx_target_init(MVX_TARGET_SPANS);
+  target.rle = output_rle;
+
+  if (!mvx_voxelize_job_init(&job, vertices, vertices_size, indices, indices_size, grid_x, grid_y, grid_z, grid_pad_x, grid_pad_y, grid_pad_z, 0, target))
+  {
+    return 0;
+  }
+
+  /* whatever remains after the row offsets holds records and spans */
+  mvx_arena_init(&arena, memory, memory_size);
+
+  if (!mvx_rle_init(output_rle, grid_x, grid_y, grid_z, mvx_rle_capacity(grid_y, grid_z, memory_size), &arena))
+  {
+    return 0;
+  }
+
+  mvx_voxelize_job_slab(&job, 0, grid_z);
+
+  return mvx_rle_finish(output_rle);
+}
+
+/* Same as mvx_voxelize_mesh but writes the voxels in another order, see Voxel Layouts.
+ * output_voxels needs mvx_layout_size(layout, grid_x, grid_y, grid_z) bytes.
+ */
+MVX_API MVX_INLINE int mvx_voxelize_mesh_layout(
+    float *vertices, unsigned long vertices_size,
+    int *indices, unsigned long indices_size,
+    int grid_x, int grid_y, int grid_z,
+    int grid_pad_x, int grid_pad_y, int grid_pad_z,
+    int solid,                    /* 1 to also fill the interior. */
+    int layout,                   /* MVX_LAYOUT_LINEAR, MVX_LAYOUT_MORTON, MVX_LAYOUT_TILED4 or MVX_LAYOUT_TILED8. */
+    unsigned char *output_voxels)
+{
+  mvx_target target;
+
+  if (!output_voxels || !mvx_layout_valid(layout, grid_x, grid_y, grid_z))
+  {
+    return 0;
+  }
+
+  target = mvx_target_init(MVX_TARGET_LAYOUT);
+  target.bytes = output_voxels;
+  target.layout = layout;
+
+  return mvx_voxelize_mesh_target(
+      vertices, vertices_size, indices, indices_size,
+      grid_x, grid_y, grid_z, grid_pad_x, grid_pad_y, grid_pad_z,
+      solid, target);
+}
+
+/* Same as mvx_voxelize_mesh with selectable semantics, mode is one of MVX_MODE_* (see Voxelization Modes).
+ * The thin modes set fewer voxels than MVX_MODE_CONSERVATIVE (mvx_voxelize_mesh) and are cheaper to test.
+ */
+MVX_API MVX_INLINE int mvx_voxelize_mesh_mode(
+    float *vertices, unsigned long vertices_size,
+    int *indices, unsigned long indices_size,
+    int grid_x, int grid_y, int grid_z,
+    int grid_pad_x, int grid_pad_y, int grid_pad_z,
+    int mode,                     /* MVX_MODE_CONSERVATIVE, MVX_MODE_26_SEPARATING, MVX_MODE_6_SEPARATING or MVX_MODE_CENTER. */
+    unsigned char *output_voxels)
+{
+  mvx_target target;
+
+  if (!output_voxels)
+  {
+    return 0;
+  }
+
+  target = mvx_target_init(MVX_TARGET_BYTES);
+  target.bytes = output_voxels;
+
+  return mvx_voxelize_mesh_mode_target(
+      vertices, vertices_size, indices, indices_size,
+      grid_x, grid_y, grid_z, grid_pad_x, grid_pad_y, grid_pad_z,
+      mode, target);
+}
+
+/* Bit-packed variant of mvx_voxelize_mesh_mode (see mvx_bits_row_words) */
+MVX_API MVX_INLINE int mvx_voxelize_mesh_mode_bits(
+    float *vertices, unsigned long vertices_size,
+    int *indices, unsigned long indices_size,
+    int grid_x, int grid_y, int grid_z,
+    int grid_pad_x, int grid_pad_y, int grid_pad_z,
+    int mode,
+    unsigned int *output_bits)
+{
+  mvx_target target;
+
+  if (!output_bits)
+  {
+    return 0;
+  }
+
+  target = mvx_target_init(MVX_TARGET_BITS);
+  target.bits = output_bits;
+
+  return mvx_voxelize_mesh_mode_target(
+      vertices, vertices_size, indices, indices_size,
+      grid_x, grid_y, grid_z, grid_pad_x, grid_pad_y, grid_pad_z,
+      mode, target);
+}
+
+/* Same as mvx_voxelize_mesh but with an explicit world to grid mapping instead of fitting the grid
+ * to the mesh bounds: voxel (x, y, z) covers origin + [x, x + 1) * voxel_size (same for y and z).
+ * Skips the bounds pass and culls triangles outside of the grid, so meshes voxelized with the same
+ * origin and voxel_size share one voxel lattice (e.g. the chunks of a world).
+ */
+MVX_API MVX_INLINE int mvx_voxelize_mesh_grid(
+    float *vertices, unsigned long vertices_size,
+    int *indices, unsigned long indices_size,
+    float origin_x, float origin_y, float origin_z, /* World position of the corner of voxel (0, 0, 0). */
+    float voxel_size,                               /* World size of a voxel. */
+    int grid_x, int grid_y, int grid_z,
+    unsigned char *output_voxels)
+{
+  mvx_grid grid;
+  mvx_target target;
+
+  if (!output_voxels || !mvx_grid_init(&grid, mvx_v3_init(origin_x, origin_y, origin_z), voxel_size, grid_x, grid_y, grid_z))
+  {
+    return 0;
+  }
+
+  target = mvx_target_init(MVX_TARGET_BYTES);
+  target.bytes = output_voxels;
+
+  return mvx_voxelize_mesh_grid_target(vertices, vertices_size, indices, indices_size, &grid, 0, MVX_MODE_CONSERVATIVE, target);
+}
+
+/* Bit-packed variant of mvx_voxelize_mesh_grid (see mvx_bits_row_words) */
+MVX_API MVX_INLINE int mvx_voxelize_mesh_grid_bits(
+    float *vertices, unsigned long vertices_size,
+    int *indices, unsigned long indices_size,
+    float origin_x, float origin_y, float origin_z,
+    float voxel_size,
+    int grid_x, int grid_y, int grid_z,
+    unsigned int *output_bits)
+{
+  mvx_grid grid;
+  mvx_target target;
+
+  if (!output_bits || !mvx_grid_init(&grid, mvx_v3_init(origin_x, origin_y, origin_z), voxel_size, grid_x, grid_y, grid_z))
+  {
+    return 0;
+  }
+
+  target = mvx_target_init(MVX_TARGET_BITS);
+  target.bits = output_bits;
+
+  return mvx_voxelize_mesh_grid_target(vertices, vertices_size, indices, indices_size, &grid, 0, MVX_MODE_CONSERVATIVE, target);
+}
+
+/* Same as mvx_voxelize_mesh but splits the grid into job_count slabs along z that are
+ * executed by the caller supplied dispatcher (e.g. on a thread pool). Every job only writes
+ * to its own slab, so no synchronization is needed on output_voxels.
+ * The result is bit-identical to mvx_voxelize_mesh.
+ */
+MVX_API MVX_INLINE int mvx_voxelize_mesh_parallel(
+    float *vertices, unsigned long vertices_size,
+    int *indices, unsigned long indices_size,
+    int grid_x, int grid_y, int grid_z,
+    int grid_pad_x, int grid_pad_y, int grid_pad_z,
+    mvx_dispatch_function dispatch, /* Runs the jobs, see mvx_dispatch_function. */
+    void *dispatch_user_data,       /* Passed to dispatch (e.g. your thread pool). */
+    int job_count,                  /* Number of slabs, e.g. a small multiple of the thread count. */
+    unsigned char *output_voxels)
+{
+  mvx_target target;
+
+  if (!output_voxels)
+  {
+    return 0;
+  }
+
+  target = mvx_target_init(MVX_TARGET_BYTES);
+  target.bytes = output_voxels;
+
+  return mvx_voxelize_mesh_parallel_target(
+      vertices, vertices_size, indices, indices_size,
+      grid_x, grid_y, grid_z, grid_pad_x, grid_pad_y, grid_pad_z,
+      0, dispatch, dispatch_user_data, job_count, target);
+}
+
+/* Bit-packed variant of mvx_voxelize_mesh_parallel */
+MVX_API MVX_INLINE int mvx_voxelize_mesh_parallel_bits(
+    float *vertices, unsigned long vertices_size,
+    int *indices, unsigned long indices_size,
+    int grid_x, int grid_y, int grid_z,
+    int grid_pad_x, int grid_pad_y, int grid_pad_z,
+    mvx_dispatch_function dispatch, void *dispatch_user_data, int job_count,
+    unsigned int *output_bits)
+{
+  mvx_target target;
+
+  if (!output_bits)
+  {
+    return 0;
+  }
+
+  target = mvx_target_init(MVX_TARGET_BITS);
+  target.bits = output_bits;
+
+  return mvx_voxelize_mesh_parallel_target(
+      vertices, vertices_size, indices, indices_size,
+      grid_x, grid_y, grid_z, grid_pad_x, grid_pad_y, grid_pad_z,
+      0, dispatch, dispatch_user_data, job_count, target);
+}
+
+/* Same as mvx_voxelize_mesh but first bins the triangles into bricks of brick_size^3 voxels
+ * (e.g. 8 or 16) and then voxelizes brick by brick so the writes stay in cache.
+ * The bins are built in the caller supplied memory, see mvx_voxelize_mesh_binned_memory_size.
+ * If dispatch is not 0 every layer of bricks along z is one job (see mvx_voxelize_mesh_parallel).
+ */
+MVX_API MVX_INLINE int mvx_voxelize_mesh_binned(
+    float *vertices, unsigned long vertices_size,
+    int *indices, unsigned long indices_size,
+    int grid_x, int grid_y, int grid_z,
+    int grid_pad_x, int grid_pad_y, int grid_pad_z,
+    int brick_size,                             /* Edge length of a brick in voxels. */
+    void *memory, unsigned long memory_size,    /* Scratch memory for the triangle bins. */
+    mvx_dispatch_function dispatch,             /* Optional: runs the brick layers in parallel. */
+    void *dispatch_user_data,
+    unsigned char *output_voxels)
+{
+  mvx_target target;
+
+  if (!output_voxels)
+  {
+    return 0;
+  }
+
+  target = mvx_target_init(MVX_TARGET_BYTES);
+  target.bytes = output_voxels;
+
+  return mvx_voxelize_mesh_binned_target(
+      vertices, vertices_size, indices, indices_size,
+      grid_x, grid_y, grid_z, grid_pad_x, grid_pad_y, grid_pad_z,
+      brick_size, memory, memory_size, dispatch, dispatch_user_data, target);
+}
+
+/* Bit-packed variant of mvx_voxelize_mesh_binned */
+MVX_API MVX_INLINE int mvx_voxelize_mesh_binned_bits(
+    float *vertices, unsigned long vertices_size,
+    int *indices, unsigned long indices_size,
+    int grid_x, int grid_y, int grid_z,
+    int grid_pad_x, int grid_pad_y, int grid_pad_z,
+    int brick_size,
+    void *memory, unsigned long memory_size,
+    mvx_dispatch_function dispatch, void *dispatch_user_data,
+    unsigned int *output_bits)
+{
+  mvx_target target;
+
+  if (!output_bits)
+  {
+    return 0;
+  }
+
+  target = mvx_target_init(MVX_TARGET_BITS);
+  target.bits = output_bits;
+
+  return mvx_voxelize_mesh_binned_target(
+      vertices, vertices_size, indices, indices_size,
+      grid_x, grid_y, grid_z, grid_pad_x, grid_pad_y, grid_pad_z,
+      brick_size, memory, memory_size, dispatch, dispatch_user_data, target);
+}
+
+/* mvx_voxelize_mesh_sparse in an arena: the index and the used bricks stay allocated, arena->used is behind them */
+MVX_API MVX_INLINE int mvx_voxelize_mesh_sparse_arena(
+    float *vertices, unsigned long vertices_size,
+    int *indices, unsigned long indices_size,
+    int grid_x, int grid_y, int grid_z,
+    int grid_pad_x, int grid_pad_y, int grid_pad_z,
+    mvx_arena *arena,
+    mvx_brickmap *output_brickmap)
+{
+  mvx_voxelize_job job;
+
+  if (!arena || !output_brickmap)
+  {
+    return 0;
+  }
+
+  if (!mvx_voxelize_job_init(&job, vertices, vertices_size, indices, indices_size, grid_x, grid_y, grid_z, grid_pad_x, grid_pad_y, grid_pad_z, 0, mvx_target_init(MVX_TARGET_BRICKMAP)))
+  {
+    return 0;
+  }
+
+  if (!mvx_brickmap_init(output_brickmap, grid_x, grid_y, grid_z, arena))
+  {
+    return 0;
+  }
+
+  job.target.brickmap = output_brickmap;
+
+  mvx_voxelize_job_slab(&job, 0, grid_z);
+
+  mvx_brickmap_commit(output_brickmap, arena);
+
+  return !output_brickmap->overflow;
+}
+
+/* Same as mvx_voxelize_mesh but writes a sparse brick map (see mvx_brickmap) instead of a dense grid.
+ * The index and the bricks are allocated from the caller supplied memory, see mvx_voxelize_mesh_sparse_memory_size.
+ * Returns 0 if the memory is too small.
+ */
+MVX_API MVX_INLINE int mvx_voxelize_mesh_sparse(
+    float *vertices, unsigned long vertices_size,
+    int *indices, unsigned long indices_size,
+    int grid_x, int grid_y, int grid_z,
+    int grid_pad_x, int grid_pad_y, int grid_pad_z,
+    void *memory, unsigned long memory_size, /* Memory for the index and the bricks. */
+    mvx_brickmap *output_brickmap)           /* Points into memory afterwards. */
+{
+  mvx_arena arena;
+
+  mvx_arena_init(&arena, memory, memory_size);
+
+  return mvx_voxelize_mesh_sparse_arena(
+      vertices, vertices_size, indices, indices_size,
+      grid_x, grid_y, grid_z, grid_pad_x, grid_pad_y, grid_pad_z,
+      &arena, output_brickmap);
+}
+
+/* Same as mvx_voxelize_mesh but produces the grid slab_depth slices at a time and hands every
+ * finished slab to callback instead of writing one grid_x * grid_y * grid_z array. memory holds
+ * the per slab triangle lists and the slab buffer, see mvx_voxelize_mesh_streaming_memory_size.
+ * Returns 0 if the memory is too small or the callback stopped the voxelization.
+ */
+MVX_API MVX_INLINE int mvx_voxelize_mesh_streaming(
+    float *vertices, unsigned long vertices_size,
+    int *indices, unsigned long indices_size,
+    int grid_x, int grid_y, int grid_z,
+    int grid_pad_x, int grid_pad_y, int grid_pad_z,
+    int slab_depth,                          /* Number of slices per slab. */
+    void *memory, unsigned long memory_size, /* Memory for the triangle lists and one slab. */
+    mvx_slab_function callback,              /* Receives unsigned char voxels, one byte per voxel. */
+    void *callback_user_data)
+{
+  return mvx_voxelize_mesh_streaming_target(
+      vertices, vertices_size, indices, indices_size,
+      grid_x, grid_y, grid_z, grid_pad_x, grid_pad_y, grid_pad_z,
+      0, slab_depth, memory, memory_size, callback, callback_user_data, MVX_TARGET_BYTES);
+}
+
+/* Bit-packed variant of mvx_voxelize_mesh_streaming, the callback receives unsigned int words (see mvx_bits_row_words) */
+MVX_API MVX_INLINE int mvx_voxelize_mesh_streaming_bits(
+    float *vertices, unsigned long vertices_size,
+    int *indices, unsigned long indices_size,
+    int grid_x, int grid_y, int grid_z,
+    int grid_pad_x, int grid_pad_y, int grid_pad_z,
+    int slab_depth,
+    void *memory, unsigned long memory_size,
+    mvx_slab_function callback,
+    void *callback_user_data)
+{
+  return mvx_voxelize_mesh_streaming_target(
+      vertices, vertices_size, indices, indices_size,
+      grid_x, grid_y, grid_z, grid_pad_x, grid_pad_y, grid_pad_z,
+      0, slab_depth, memory, memory_size, callback, callback_user_data, MVX_TARGET_BITS);
+}
+
+/* Arena bytes mvx_voxelize_mesh_streaming needs (0 on invalid input) */
+MVX_API MVX_INLINE unsigned long mvx_voxelize_mesh_streaming_memory_size(
+    float *vertices, unsigned long vertices_size,
+    int *indices, unsigned long indices_size,
+    int grid_x, int grid_y, int grid_z,
+    int grid_pad_x, int grid_pad_y, int grid_pad_z,
+    int slab_depth)
+{
+  return mvx_voxelize_mesh_streaming_target_memory_size(
+      vertices, vertices_size, indices, indices_size,
+      grid_x, grid_y, grid_z, grid_pad_x, grid_pad_y, grid_pad_z,
+      slab_depth, MVX_TARGET_BYTES);
+}
+
+/* Arena bytes mvx_voxelize_mesh_streaming_bits needs (0 on invalid input) */
+MVX_API MVX_INLINE unsigned long mvx_voxelize_mesh_streaming_bits_memory_size(
+    float *vertices, unsigned long vertices_size,
+    int *indices, unsigned long indices_size,
+    int grid_x, int grid_y, int grid_z,
+    int grid_pad_x, int grid_pad_y, int grid_pad_z,
+    int slab_depth)
+{
+  return mvx_voxelize_mesh_streaming_target_memory_size(
+      vertices, vertices_size, indices, indices_size,
+      grid_x, grid_y, grid_z, grid_pad_x, grid_pad_y, grid_pad_z,
+      slab_depth, MVX_TARGET_BITS);
+}
+
+/* #############################################################################
+ * # Signed Distance Field
+ * #############################################################################
+ *
+ * Narrow band SDF sampled at the voxel centers. Every triangle only visits the
+ * voxels within "band" voxels of its bounds and keeps the minimum exact
+ * point-triangle distance, so the cost scales with the surface instead of the
+ * volume. The sign comes from the parity crossings of the solid voxelization
+ * (negative inside), so the mesh has to be watertight.
+ *
+ * Distances are in voxels. Voxels farther than band from the surface hold
+ * +band outside and -band inside.
+ */
+#define MVX_SDF_FLOAT 0
+#define MVX_SDF_INT16 1
+#define MVX_SDF_INT16_SCALE 256.0f /* int16 output is 8.8 fixed point voxels, band <= 127 */
+#define MVX_SDF_ROW 32             /* voxels per distance batch */
+
+/* Per triangle constants of the point-triangle distance */
+typedef struct mvx_sdf_setup
+{
+  mvx_v3 a[3];     /* edge origins v0, v1, v2 */
+  mvx_v3 e[3];     /* edges a[i] -> a[(i + 1) % 3] */
+  mvx_v3 c[3];     /* in-plane edge normals cross(n, e[i]), pointing inwards */
+  float inv_ee[3]; /* 1 / |e[i]|^2, 0 for a degenerated edge */
+  mvx_v3 n;
+  float inv_nn;    /* 1 / |n|^2, 0 for a degenerated triangle (edges only) */
+
+} mvx_sdf_setup;
+
+/* The parts of the per edge dot products that are constant along an x-axis row */
+typedef struct mvx_sdf_row
+{
+  float qy[3];  /* (p - a[i]).y */
+  float qz[3];  /* (p - a[i]).z */
+  float ce[3];  /* dot(c[i], p - a[i]) without x */
+  float ee[3];  /* dot(e[i], p - a[i]) without x */
+  float plane;  /* dot(n, p - a[0]) without x */
+
+} mvx_sdf_row;
+
+MVX_API MVX_INLINE void mvx_sdf_setup_init(mvx_sdf_setup *s, mvx_v3 v0, mvx_v3 v1, mvx_v3 v2)
+{
+  float nn;
+  int i;
+
+  s->a[0] = v0;
+  s->a[1] = v1;
+  s->a[2] = v2;
+  s->n = mvx_v3_cross(mvx_v3_sub(v1, v0), mvx_v3_sub(v2, v0));
+
+  nn = mvx_v3_dot(s->n, s->n);
+  s->inv_nn = nn > 0.0f ? 1.0f / nn : 0.0f;
+
+  for (i = 0; i < 3; ++i)
+  {
+    float ee;
+
+    s->e[i] = mvx_v3_sub(s->a[(i + 1) % 3], s->a[i]);
+    s->c[i] = mvx_v3_cross(s->n, s->e[i]);
+
+    ee = mvx_v3_dot(s->e[i], s->e[i]);
+    s->inv_ee[i] = ee > 0.0f ? 1.0f / ee : 0.0f;
+  }
+}
+
+MVX_API MVX_INLINE void mvx_sdf_row_init(mvx_sdf_setup *s, float py, float pz, mvx_sdf_row *row)
+{
+  int i;
+
+  for (i = 0; i < 3; ++i)
+  {
+    row->qy[i] = py - s->a[i].y;
+    row->qz[i] = pz - s->a[i].z;
+    row->ce[i] = s->c[i].y * row->qy[i] + s->c[i].z * row->qz[i];
+    row->ee[i] = s->e[i].y * row->qy[i] + s->e[i].z * row->qz[i];
+  }
+
+  row->plane = s->n.y * row->qy[0] + s->n.z * row->qz[0];
+}
+
+/* Squared distance of the point (px, row) to the triangle.
+ * Inside the prism over the triangle it is the plane distance, outside the nearest edge.
+ */
+MVX_API MVX_INLINE float mvx_sdf_distance2(mvx_sdf_setup *s, mvx_sdf_row *row, float px)
+{
+  float d2 = 1e30f;
+  int inside = s->inv_nn > 0.0f;
+  int i;
+
+  for (i = 0; i < 3; ++i)
+  {
+    float qx = px - s->a[i].x;
+    float t = mvx_clampf((s->e[i].x * qx + row->ee[i]) * s->inv_ee[i], 0.0f, 1.0f);
+    float dx = qx - t * s->e[i].x;
+    float dy = row->qy[i] - t * s->e[i].y;
+    float dz = row->qz[i] - t * s->e[i].z;
+
+    if (s->c[i].x * qx + row->ce[i] < 0.0f)
+    {
+      inside = 0;
+    }
+
+    d2 = mvx_minf(d2, dx * dx + dy * dy + dz * dz);
+  }
+
+  if (inside)
+  {
+    float pd = s->n.x * (px - s->a[0].x) + row->plane;
+    d2 = pd * pd * s->inv_nn;
+  }
+
+  return d2;
+}
+
+#if defined(MVX_USE_AVX2)
+
+/* mvx_sdf_distance2 for the voxels x..x+7 of a row */
+MVX_API MVX_INLINE void mvx_sdf_distance2_x8(mvx_sdf_setup *s, mvx_sdf_row *row, mvx_grid *grid, int x, float *out)
+{
+  __m256 zero = _mm256_setzero_ps();
+  __m256 one = _mm256_set1_ps(1.0f);
+  __m256 px = _mm256_add_ps(_mm256_set1_ps((float)(x - grid->margin.x)), _mm256_set_ps(7.0f, 6.0f, 5.0f, 4.0f, 3.0f, 2.0f, 1.0f, 0.0f));
+  __m256 d2 = _mm256_set1_ps(1e30f);
+  __m256 outside = zero;
+  int i;
+
+  px = _mm256_add_ps(_mm256_set1_ps(grid->min_b.x), _mm256_mul_ps(_mm256_add_ps(px, _mm256_set1_ps(0.5f)), _mm256_set1_ps(grid->vxsize)));
+
+  for (i = 0; i < 3; ++i)
+  {
+    __m256 ex = _mm256_set1_ps(s->e[i].x);
+    __m256 qx = _mm256_sub_ps(px, _mm256_set1_ps(s->a[i].x));
+    __m256 t = _mm256_mul_ps(_mm256_add_ps(_mm256_mul_ps(ex, qx), _mm256_set1_ps(row->ee[i])), _mm256_set1_ps(s->inv_ee[i]));
+    __m256 dx, dy, dz;
+
+    t = _mm256_min_ps(_mm256_max_ps(t, zero), one);
+    dx = _mm256_sub_ps(qx, _mm256_mul_ps(t, ex));
+    dy = _mm256_sub_ps(_mm256_set1_ps(row->qy[i]), _mm256_mul_ps(t, _mm256_set1_ps(s->e[i].y)));
+    dz = _mm256_sub_ps(_mm256_set1_ps(row->qz[i]), _mm256_mul_ps(t, _mm256_set1_ps(s->e[i].z)));
+
+    outside = _mm256_or_ps(outside, _mm256_cmp_ps(_mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(s->c[i].x), qx), _mm256_set1_ps(row->ce[i])), zero, _CMP_LT_OQ));
+    d2 = _mm256_min_ps(d2, _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(dx, dx), _mm256_mul_ps(dy, dy)), _mm256_mul_ps(dz, dz)));
+  }
+
+  if (s->inv_nn > 0.0f)
+  {
+    __m256 pd = _mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(s->n.x), _mm256_sub_ps(px, _mm256_set1_ps(s->a[0].x))), _mm256_set1_ps(row->plane));
+    d2 = _mm256_blendv_ps(_mm256_mul_ps(_mm256_mul_ps(pd, pd), _mm256_set1_ps(s->inv_nn)), d2, outside);
+  }
+
+  _mm256_storeu_ps(out, d2);
+}
+
+#elif defined(MVX_USE_SSE2)
+
+/* mvx_sdf_distance2 for the voxels x..x+3 of a row */
+MVX_API MVX_INLINE void mvx_sdf_distance2_x4(mvx_sdf_setup *s, mvx_sdf_row *row, mvx_grid *grid, int x, float *out)
+{
+  __m128 zero = _mm_setzero_ps();
+  __m128 one = _mm_set1_ps(1.0f);
+  __m128 px = _mm_add_ps(_mm_set1_ps((float)(x - grid->margin.x)), _mm_set_ps(3.0f, 2.0f, 1.0f, 0.0f));
+  __m128 d2 = _mm_set1_ps(1e30f);
+  __m128 outside = zero;
+  int i;
+
+  px = _mm_add_ps(_mm_set1_ps(grid->min_b.x), _mm_mul_ps(_mm_add_ps(px, _mm_set1_ps(0.5f)), _mm_set1_ps(grid->vxsize)));
+
+  for (i = 0; i < 3; ++i)
+  {
+    __m128 ex = _mm_set1_ps(s->e[i].x);
+    __m128 qx = _mm_sub_ps(px, _mm_set1_ps(s->a[i].x));
+    __m128 t = _mm_mul_ps(_mm_add_ps(_mm_mul_ps(ex, qx), _mm_set1_ps(row->ee[i])), _mm_set1_ps(s->inv_ee[i]));
+    __m128 dx, dy, dz;
+
+    t = _mm_min_ps(_mm_max_ps(t, zero), one);
+    dx = _mm_sub_ps(qx, _mm_mul_ps(t, ex));
+    dy = _mm_sub_ps(_mm_set1_ps(row->qy[i]), _mm_mul_ps(t, _mm_set1_ps(s->e[i].y)));
+    dz = _mm_sub_ps(_mm_set1_ps(row->qz[i]), _mm_mul_ps(t, _mm_set1_ps(s->e[i].z)));
+
+    outside = _mm_or_ps(outside, _mm_cmplt_ps(_mm_add_ps(_mm_mul_ps(_mm_set1_ps(s->c[i].x), qx), _mm_set1_ps(row->ce[i])), zero));
+    d2 = _mm_min_ps(d2, _mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy)), _mm_mul_ps(dz, dz)));
+  }
+
+  if (s->inv_nn > 0.0f)
+  {
+    __m128 pd = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(s->n.x), _mm_sub_ps(px, _mm_set1_ps(s->a[0].x))), _mm_set1_ps(row->plane));
+    __m128 plane = _mm_mul_ps(_mm_mul_ps(pd, pd), _mm_set1_ps(s->inv_nn));
+    d2 = _mm_or_ps(_mm_and_ps(outside, d2), _mm_andnot_ps(outside, plane));
+  }
+
+  _mm_storeu_ps(out, d2);
+}
+
+#elif defined(MVX_USE_NEON)
+
+/* mvx_sdf_distance2 for the voxels x..x+3 of a row */
+MVX_API MVX_INLINE void mvx_sdf_distance2_x4(mvx_sdf_setup *s, mvx_sdf_row *row, mvx_grid *grid, int x, float *out)
+{
+  float lane_offsets[4] = {0.0f, 1.0f, 2.0f, 3.0f};
+  float32x4_t zero = vdupq_n_f32(0.0f);
+  float32x4_t one = vdupq_n_f32(1.0f);
+  float32x4_t px = vaddq_f32(vdupq_n_f32((float)(x - grid->margin.x)), vld1q_f32(lane_offsets));
+  float32x4_t d2 = vdupq_n_f32(1e30f);
+  uint32x4_t outside = vdupq_n_u32(0);
+  int i;
+
+  px = vaddq_f32(vdupq_n_f32(grid->min_b.x), vmulq_f32(vaddq_f32(px, vdupq_n_f32(0.5f)), vdupq_n_f32(grid->vxsize)));
+
+  for (i = 0; i < 3; ++i)
+  {
+    float32x4_t ex = vdupq_n_f32(s->e[i].x);
+    float32x4_t qx = vsubq_f32(px, vdupq_n_f32(s->a[i].x));
+    float32x4_t t = vmulq_f32(vaddq_f32(vmulq_f32(ex, qx), vdupq_n_f32(row->ee[i])), vdupq_n_f32(s->inv_ee[i]));
+    float32x4_t dx, dy, dz;
+
+    t = vminq_f32(vmaxq_f32(t, zero), one);
+    dx = vsubq_f32(qx, vmulq_f32(t, ex));
+    dy = vsubq_f32(vdupq_n_f32(row->qy[i]), vmulq_f32(t, vdupq_n_f32(s->e[i].y)));
+    dz = vsubq_f32(vdupq_n_f32(row->qz[i]), vmulq_f32(t, vdupq_n_f32(s->e[i].z)));
+
+    outside = vorrq_u32(outside, vcltq_f32(vaddq_f32(vmulq_f32(vdupq_n_f32(s->c[i].x), qx), vdupq_n_f32(row->ce[i])), zero));
+    d2 = vminq_f32(d2, vaddq_f32(vaddq_f32(vmulq_f32(dx, dx), vmulq_f32(dy, dy)), vmulq_f32(dz, dz)));
+  }
+
+  if (s->inv_nn > 0.0f)
+  {
+    float32x4_t pd = vaddq_f32(vmulq_f32(vdupq_n_f32(s->n.x), vsubq_f32(px, vdupq_n_f32(s->a[0].x))), vdupq_n_f32(row->plane));
+    d2 = vbslq_f32(outside, d2, vmulq_f32(vmulq_f32(pd, pd), vdupq_n_f32(s->inv_nn)));
+  }
+
+  vst1q_f32(out, d2);
+}
+
+#endif
+
+typedef struct mvx_sdf
+{
+  int kind;           /* MVX_SDF_FLOAT or MVX_SDF_INT16 */
+  float *distances;   /* float: squared world distances during the sweep, voxels afterwards */
+  short *quantized;   /* int16: MVX_SDF_INT16_SCALE units per voxel */
+  int band;           /* in voxels */
+
+} mvx_sdf;
+
+/* Squared distances of the voxels x_begin..x_end (inclusive) of row (y, z) into d2 */
+MVX_API MVX_INLINE void mvx_sdf_row_distances(mvx_sdf_setup *s, mvx_sdf_row *row, mvx_grid *grid, int x_begin, int x_end, float *d2)
+{
+  int x = x_begin;
+
+#if defined(MVX_USE_AVX2)
+  for (; x + MVX_SIMD_LANES - 1 <= x_end; x += MVX_SIMD_LANES)
+  {
+    mvx_sdf_distance2_x8(s, row, grid, x, d2 + (x - x_begin));
+  }
+#elif defined(MVX_USE_SSE2) || defined(MVX_USE_NEON)
+  for (; x + MVX_SIMD_LANES - 1 <= x_end; x += MVX_SIMD_LANES)
+  {
+    mvx_sdf_distance2_x4(s, row, grid, x, d2 + (x - x_begin));
+  }
+#endif
+
+  for (; x <= x_end; ++x)
+  {
+    float px = grid->min_b.x + ((float)(x - grid->margin.x) + 0.5f) * grid->vxsize;
+    d2[x - x_begin] = mvx_sdf_distance2(s, row, px);
+  }
+}
+
+/* Keeps the minimum distance of every voxel of the slices z_begin..z_end - 1 within the band of the triangle */
+MVX_API MVX_INLINE void mvx_sdf_triangle(
+    mvx_grid *grid,
+    mvx_sdf *sdf,
+    mvx_v3 v0, mvx_v3 v1, mvx_v3 v2,
+    int z_begin, int z_end)
+{
+  float d2[MVX_SDF_ROW];
+  float limit = (float)sdf->band * grid->vxsize;
+  float limit2 = limit * limit;
+  float scale = MVX_SDF_INT16_SCALE / grid->vxsize;
+  mvx_v3 t_min = mvx_v3_min(v0, mvx_v3_min(v1, v2));
+  mvx_v3 t_max = mvx_v3_max(v0, mvx_v3_max(v1, v2));
+  mvx_sdf_setup setup;
+  mvx_sdf_row row;
+  int y_begin, y_end, z_first, z_last;
+  int x, y, z, k;
+
+  /* the band reaches into the grid margins, so no object range clamp here */
+  if (!mvx_grid_center_range(t_min.y - limit, t_max.y + limit, grid->min_b.y, grid->vxsize, grid->margin.y, grid->y, &y_begin, &y_end) ||
+      !mvx_grid_center_range(t_min.z - limit, t_max.z + limit, grid->min_b.z, grid->vxsize, grid->margin.z, grid->z, &z_first, &z_last))
+  {
+    return;
+  }
+
+  z_first = mvx_maxi(z_first, z_begin);
+  z_last = mvx_mini(z_last, z_end - 1);
+
+  mvx_sdf_setup_init(&setup, v0, v1, v2);
+
+  for (z = z_first; z <= z_last; ++z)
+  {
+    for (y = y_begin; y <= y_end; ++y)
+    {
+      mvx_v3 c = mvx_grid_voxel_center(grid, 0, y, z);
+      float dy = mvx_maxf(0.0f, mvx_maxf(t_min.y - c.y, c.y - t_max.y));
+      float dz = mvx_maxf(0.0f, mvx_maxf(t_min.z - c.z, c.z - t_max.z));
+      float rest = limit2 - dy * dy - dz * dz;
+      int x_begin, x_end;
+      long id;
+
+      /* the row misses the band around the bounds */
+      if (rest < 0.0f)
+      {
+        continue;
+      }
+
+      /* only the part of the row within the band around the bounds */
+      rest = mvx_sqrtf(rest);
+
+      if (!mvx_grid_center_range(t_min.x - rest, t_max.x + rest, grid->min_b.x, grid->vxsize, grid->margin.x, grid->x, &x_begin, &x_end))
+      {
+        continue;
+      }
+
+      mvx_sdf_row_init(&setup, c.y, c.z, &row);
+
+      for (x = x_begin; x <= x_end; x += MVX_SDF_ROW)
+      {
+        int count = mvx_mini(MVX_SDF_ROW, x_end - x + 1);
+
+        mvx_sdf_row_distances(&setup, &row, grid, x, x + count - 1, d2);
+
+        id = (long)x + (long)y * grid->x + (long)z * grid->x * grid->y;
+
+        if (sdf->kind == MVX_SDF_INT16)
+        {
+          for (k = 0; k < count; ++k)
+          {
+            if (d2[k] < limit2)
+            {
+              short q = (short)(mvx_sqrtf(d2[k]) * scale + 0.5f);
+
+              if (q < sdf->quantized[id + k])
+              {
+                sdf->quantized[id + k] = q;
+              }
+            }
+          }
+        }
+        else
+        {
+          for (k = 0; k < count; ++k)
+          {
+            sdf->distances[id + k] = mvx_minf(sdf->distances[id + k], d2[k]);
+          }
+        }
+      }
+    }
+  }
+}
+
+typedef struct mvx_sdf_job
+{
+  mvx_voxelize_job job; /* solid job with a bits target for the inside parity */
+  mvx_sdf sdf;
+
+} mvx_sdf_job;
+
+MVX_API MVX_INLINE void mvx_sdf_job_slab(mvx_sdf_job *sdf_job, int z_begin, int z_end)
+{
+  mvx_voxelize_job *job = &sdf_job->job;
+  mvx_sdf *sdf = &sdf_job->sdf;
+  mvx_grid *grid = &job->grid;
+  unsigned long tricount = mvx_mesh_triangle_count(&job->mesh);
+  unsigned long t;
+  float limit = (float)sdf->band * grid->vxsize;
+  float inv_vxsize = 1.0f / grid->vxsize;
+  short q_limit = (short)((float)sdf->band * MVX_SDF_INT16_SCALE);
+  long slice = (long)grid->x * (long)grid->y;
+  long q;
+  int k, x, y, z;
+  mvx_mesh_batch batch;
+
+  /* sign */
+  mvx_target_clear(&job->target, grid, z_begin, z_end);
+  mvx_voxelize_job_parity(job, z_begin, z_end);
+
+  /* magnitude */
+  for (q = slice * z_begin; q < slice * z_end; ++q)
+  {
+    if (sdf->kind == MVX_SDF_INT16)
+    {
+      sdf->quantized[q] = q_limit;
+    }
+    else
+    {
+      sdf->distances[q] = limit * limit;
+    }
+  }
+
+  for (t = 0; t < tricount; t += MVX_MESH_BATCH)
+  {
+    mvx_mesh_fetch(&job->mesh, 0, t, mvx_mesh_batch_count(t, tricount), &batch);
+
+    for (k = 0; k < batch.count; ++k)
+    {
+      mvx_v3 *v = batch.v + 3 * k;
+      mvx_sdf_triangle(grid, sdf, v[0], v[1], v[2], z_begin, z_end);
+    }
+  }
+
+  /* resolve */
+  for (z = z_begin; z < z_end; ++z)
+  {
+    for (y = 0; y < grid->y; ++y)
+    {
+      unsigned int *bits = job->target.bits + ((long)y + (long)z * grid->y) * mvx_bits_row_words(grid->x);
+
+      q = (long)y * grid->x + (long)z * slice;
+
+      for (x = 0; x < grid->x; ++x, ++q)
+      {
+        int inside = (int)((bits[x / MVX_BITS_PER_WORD] >> (x % MVX_BITS_PER_WORD)) & 1u);
+
+        if (sdf->kind == MVX_SDF_INT16)
+        {
+          sdf->quantized[q] = inside ? (short)-sdf->quantized[q] : sdf->quantized[q];
+        }
+        else
+        {
+          float d = mvx_minf(mvx_sqrtf(sdf->distances[q]) * inv_vxsize, (float)sdf->band);
+          sdf->distances[q] = inside ? -d : d;
+        }
+      }
+    }
+  }
+}
+
+MVX_API MVX_INLINE void mvx_sdf_job_run(void *job_data, int job_index)
+{
+  mvx_sdf_job *sdf_job = (mvx_sdf_job *)job_data;
+  int z = sdf_job->job.grid.z;
+  int z_begin = (int)((long)z * job_index / sdf_job->job.job_count);
+  int z_end = (int)((long)z * (job_index + 1) / sdf_job->job.job_count);
+
+  if (z_begin < z_end)
+  {
+    mvx_sdf_job_slab(sdf_job, z_begin, z_end);
+  }
+}
+
+/* Scratch memory of mvx_voxelize_mesh_sdf (the inside parity bits) */
+MVX_API MVX_INLINE unsigned long mvx_voxelize_mesh_sdf_memory_size(int grid_x, int grid_y, int grid_z)
+{
+  if (grid_x <= 0 || grid_y <= 0 || grid_z <= 0)
+  {
+    return 0;
+  }
+
+  return mvx_arena_aligned_size((unsigned long)mvx_bits_size(grid_x, grid_y, grid_z) * (unsigned long)sizeof(unsigned int));
+}
+
+MVX_API MVX_INLINE int mvx_voxelize_mesh_sdf_target(
+    float *vertices, unsigned long vertices_size,
+    int *indices, unsigned long indices_size,
+    int grid_x, int grid_y, int grid_z,
+    int grid_pad_x, int grid_pad_y, int grid_pad_z,
+    void *memory, unsigned long memory_size,
+    mvx_dispatch_function dispatch, void *dispatch_user_data, int job_count,
+    mvx_sdf sdf)
+{
+  mvx_sdf_job sdf_job;
+  mvx_target target;
+  mvx_arena arena;
+
+  if (sdf.band <= 0 || (sdf.kind == MVX_SDF_INT16 && (float)sdf.band * MVX_SDF_INT16_SCALE > 32767.0f))
+  {
+    return 0;
+  }
+
+  mvx_arena_init(&arena, memory, memory_size);
+
+  target = mvx_target_init(MVX_TARGET_BITS);
+  target.bits = (unsigned int *)mvx_arena_push(&arena, mvx_voxelize_mesh_sdf_memory_size(grid_x, grid_y, grid_z));
+
+  if (!target.bits)
+  {
+    return 0;
+  }
+
+  if (!mvx_voxelize_job_init(&sdf_job.job, vertices, vertices_size, indices, indices_size, grid_x, grid_y, grid_z, grid_pad_x, grid_pad_y, grid_pad_z, 1, target))
+  {
+    return 0;
+  }
+
+  sdf_job.sdf = sdf;
+
+  if (dispatch && job_count > 0)
+  {
+    sdf_job.job.job_count = mvx_mini(job_count, grid_z);
+    dispatch(dispatch_user_data, mvx_sdf_job_run, &sdf_job, sdf_job.job.job_count);
+  }
+  else
+  {
+    mvx_sdf_job_slab(&sdf_job, 0, grid_z);
+  }
+
+  return 1;
+}
+
+/* Narrow band signed distance field in voxels (negative inside), see Signed Distance Field */
+MVX_API MVX_INLINE int mvx_voxelize_mesh_sdf(
+    float *vertices, unsigned long vertices_size,
+    int *indices, unsigned long indices_size,
+    int grid_x, int grid_y, int grid_z,
+    int grid_pad_x, int grid_pad_y, int grid_pad_z,
+    int band,                                 /* Width of the band in voxels, farther voxels hold +-band. */
+    void *memory, unsigned long memory_size,  /* Scratch memory, see mvx_voxelize_mesh_sdf_memory_size. */
+    mvx_dispatch_function dispatch,           /* Optional: runs job_count slabs in parallel. */
+    void *dispatch_user_data,
+    int job_count,
+    float *output_distances)                  /* grid_x * grid_y * grid_z floats. */
+{
+  mvx_sdf sdf;
+
+  if (!output_distances)
+  {
+    return 0;
+  }
+
+  sdf.kind = MVX_SDF_FLOAT;
+  sdf.distances = output_distances;
+  sdf.quantized = 0;
+  sdf.band = band;
+
+  return mvx_voxelize_mesh_sdf_target(
+      vertices, vertices_size, indices, indices_size,
+      grid_x, grid_y, grid_z, grid_pad_x, grid_pad_y, grid_pad_z,
+      memory, memory_size, dispatch, dispatch_user_data, job_count, sdf);
+}
+
+/* mvx_voxelize_mesh_sdf with 16 bit fixed point output (MVX_SDF_INT16_SCALE units per voxel, band <= 127) */
+MVX_API MVX_INLINE int mvx_voxelize_mesh_sdf_int16(
+    float *vertices, unsigned long vertices_size,
+    int *indices, unsigned long indices_size,
+    int grid_x, int grid_y, int grid_z,
+    int grid_pad_x, int grid_pad_y, int grid_pad_z,
+    int band,
+    void *memory, unsigned long memory_size,
+    mvx_dispatch_function dispatch,
+    void *dispatch_user_data,
+    int job_count,
+    short *output_distances)
+{
+  mvx_sdf sdf;
+
+  if (!output_distances)
+  {
+    return 0;
+  }
+
+  sdf.kind = MVX_SDF_INT16;
+  sdf.distances = 0;
+  sdf.quantized = output_distances;
+  sdf.band = band;
+
+  return mvx_voxelize_mesh_sdf_target(
+      vertices, vertices_size, indices, indices_size,
+      grid_x, grid_y, grid_z, grid_pad_x, grid_pad_y, grid_pad_z,
+      memory, memory_size, dispatch, dispatch_user_data, job_count, sdf);
+}
+
+/* #############################################################################
+ * # Euclidean Distance Transform
+ * #############################################################################
+ *
+ * Exact distance (in voxels) from every voxel center to the nearest occupied
+ * voxel of a byte grid, e.g. the output of mvx_voxelize_mesh. Separable: one
+ * pass of 1D lower envelopes of parabolas per axis (Felzenszwalb & Huttenlocher),
+ * O(n) per row. The rows of a pass are independent and split into jobs.
+ *
+ * A grid without any occupied voxel ends up at mvx_sqrtf(MVX_EDT_FAR) everywhere.
+ */
+#define MVX_EDT_FAR 1e20f /* squared distance of empty voxels before the first pass */
+
+typedef struct mvx_edt_job
+{
+  unsigned char *voxels;
+  float *distances;       /* squared distances between the passes */
+  int x, y, z;
+  int axis;               /* axis of the current pass */
+  int job_count;
+  unsigned char *scratch; /* one row of mvx_edt_row_size bytes per job */
+  unsigned long row_size;
+
+} mvx_edt_job;
+
+/* Scratch bytes of a row of n voxels: f, d, v and z (n + 1) */
+MVX_API MVX_INLINE unsigned long mvx_edt_row_size(int n)
+{
+  return 2 * mvx_arena_aligned_size((unsigned long)n * (unsigned long)sizeof(float)) +
+         mvx_arena_aligned_size((unsigned long)n * (unsigned long)sizeof(int)) +
+         mvx_arena_aligned_size((unsigned long)(n + 1) * (unsigned long)sizeof(float));
+}
+
+/* Squared distance transform of the n samples f into d, v and z are the envelope */
+MVX_API MVX_INLINE void mvx_edt_row(float *f, float *d, int *v, float *z, int n)
+{
+  int k = 0;
+  int q;
+
+  v[0] = 0;
+  z[0] = -1e30f;
+  z[1] = 1e30f;
+
+  /* lower envelope of the parabolas rooted at (q, f[q]) */
+  for (q = 1; q < n; ++q)
+  {
+    float fq = f[q] + (float)q * (float)q;
+    float s = (fq - (f[v[k]] + (float)v[k] * (float)v[k])) / (float)(2 * (q - v[k]));
+
+    while (s <= z[k])
+    {
+      --k;
+      s = (fq - (f[v[k]] + (float)v[k] * (float)v[k])) / (float)(2 * (q - v[k]));
+    }
+
+    ++k;
+    v[k] = q;
+    z[k] = s;
+    z[k + 1] = 1e30f;
+  }
+
+  for (q = 0, k = 0; q < n; ++q)
+  {
+    float dq;
+
+    while (z[k + 1] < (float)q)
+    {
+      ++k;
+    }
+
+    dq = (float)(q - v[k]);
+    d[q] = dq * dq + f[v[k]];
+  }
+}
+
+/* Runs a share of the rows of the current pass */
+MVX_API MVX_INLINE void mvx_edt_job_run(void *job_data, int job_index)
+{
+  mvx_edt_job *job = (mvx_edt_job *)job_data;
+  long slice = (long)job->x * (long)job->y;
+  long stride, lines, line, line_begin, line_end;
+  unsigned char *scratch = job->scratch + job->row_size * (unsigned long)job_index;
+  unsigned long floats;
+  float *f, *d, *z;
+  int *v;
+  int n, i;
+
+  if (job->axis == 0)
+  {
+    n = job->x;
+    stride = 1;
+    lines = (long)job->y * job->z;
+  }
+  else if (job->axis == 1)
+  {
+    n = job->y;
+    stride = job->x;
+    lines = (long)job->x * job->z;
+  }
+  else
+  {
+    n = job->z;
+    stride = slice;
+    lines = slice;
+  }
+
+  floats = mvx_arena_aligned_size((unsigned long)n * (unsigned long)sizeof(float));
+  f = (float *)scratch;
+  d = (float *)(scratch + floats);
+  v = (int *)(scratch + 2 * floats);
+  z = (float *)(scratch + 2 * floats + mvx_arena_aligned_size((unsigned long)n * (unsigned long)sizeof(int)));
+
+  line_begin = lines * job_index / job->job_count;
+  line_end = lines * (job_index + 1) / job->job_count;
+
+  for (line = line_begin; line < line_end; ++line)
+  {
+    /* x rows are contiguous, y rows are enumerated by (x, z), z rows by (x, y) */
+    long base = job->axis == 0 ? line * job->x : (job->axis == 1 ? line % job->x + line / job->x * slice : line);
+
+    if (job->axis == 0)
+    {
+      for (i = 0; i < n; ++i)
+      {
+        f[i] = job->voxels[base + i] ? 0.0f : MVX_EDT_FAR;
+      }
+    }
+    else
+    {
+      for (i = 0; i < n; ++i)
+      {
+        f[i] = job->distances[base + i * stride];
+      }
+    }
+
+    mvx_edt_row(f, d, v, z, n);
+
+    if (job->axis == 2)
+    {
+      for (i = 0; i < n; ++i)
+      {
+        job->distances[base + i * stride] = mvx_sqrtf(d[i]);
+      }
+    }
+    else
+    {
+      for (i = 0; i < n; ++i)
+      {
+        job->distances[base + i * stride] = d[i];
+      }
+    }
+  }
+}
+
+/* Scratch memory of mvx_edt for job_count parallel jobs (1 without dispatch) */
+MVX_API MVX_INLINE unsigned long mvx_edt_memory_size(int grid_x, int grid_y, int grid_z, int job_count)
+{
+  if (grid_x <= 0 || grid_y <= 0 || grid_z <= 0 || job_count <= 0)
+  {
+    return 0;
+  }
+
+  return (unsigned long)job_count * mvx_edt_row_size(mvx_maxi(grid_x, mvx_maxi(grid_y, grid_z)));
+}
+
+/* Distance in voxels from every voxel to the nearest occupied one (0 for occupied voxels) */
+MVX_API MVX_INLINE int mvx_edt(
+    unsigned char *voxels,                   /* grid_x * grid_y * grid_z occupancy bytes, e.g. from mvx_voxelize_mesh. */
+    int grid_x, int grid_y, int grid_z,
+    void *memory, unsigned long memory_size, /* Scratch memory, see mvx_edt_memory_size. */
+    mvx_dispatch_function dispatch,          /* Optional: runs the rows of each pass as job_count parallel jobs. */
+    void *dispatch_user_data,
+    int job_count,
+    float *output_distances)                 /* grid_x * grid_y * grid_z floats. */
+{
+  mvx_edt_job job;
+  mvx_arena arena;
+
+  if (!voxels || !output_distances || grid_x <= 0 || grid_y <= 0 || grid_z <= 0)
+  {
+    return 0;
+  }
+
+  job.job_count = dispatch ? job_count : 1;
+
+  if (job.job_count <= 0)
+  {
+    return 0;
+  }
+
+  mvx_arena_init(&arena, memory, memory_size);
+
+  job.row_size = mvx_edt_row_size(mvx_maxi(grid_x, mvx_maxi(grid_y, grid_z)));
+  job.scratch = (unsigned char *)mvx_arena_push(&arena, (unsigned long)job.job_count * job.row_size);
+
+  if (!job.scratch)
+  {
+    return 0;
+  }
+
+  job.voxels = voxels;
+  job.distances = output_distances;
+  job.x = grid_x;
+  job.y = grid_y;
+  job.z = grid_z;
+
+  /* every pass reads the result of the previous one */
+  for (job.axis = 0; job.axis < 3; ++job.axis)
+  {
+    if (dispatch)
+    {
+      dispatch(dispatch_user_data, mvx_edt_job_run, &job, job.job_count);
+    }
+    else
+    {
+      mvx_edt_job_run(&job, 0);
+    }
+  }
+
+  return 1;
+}
+
+/* #############################################################################
+ * # Instanced Voxelization
+ * #############################################################################
+ *
+ * Voxelizes many affine transformed copies of one mesh into a caller defined
+ * grid (see mvx_grid_init). The local bounds of the mesh are computed once,
+ * instances whose transformed bounds miss the grid are skipped and the
+ * triangles of the others are transformed on the fly and clipped to the
+ * voxel range of their instance, so the vertex buffer is never copied.
+ * Overlapping instances union.
+ */
+
+/* Floats per instance transform: row-major 3x4 affine matrix, the rows are
+ * (m00 m01 m02 tx), (m10 m11 m12 ty), (m20 m21 m22 tz) and p' = M * p + t.
+ */
+#define MVX_TRANSFORM_FLOATS 12
+
+MVX_API MVX_INLINE mvx_v3 mvx_transform_point(float *m, mvx_v3 p)
+{
+  return mvx_v3_init(
+      m[0] * p.x + m[1] * p.y + m[2] * p.z + m[3],
+      m[4] * p.x + m[5] * p.y + m[6] * p.z + m[7],
+      m[8] * p.x + m[9] * p.y + m[10] * p.z + m[11]);
+}
+
+/* World bounds of the transformed box: transformed center plus the extent through |M| */
+MVX_API MVX_INLINE void mvx_transform_box(float *m, mvx_v3 min_b, mvx_v3 max_b, mvx_v3 *min_out, mvx_v3 *max_out)
+{
+  mvx_v3 c = mvx_transform_point(m, mvx_v3_scale(mvx_v3_add(min_b, max_b), 0.5f));
+  mvx_v3 e = mvx_v3_scale(mvx_v3_sub(max_b, min_b), 0.5f);
+  mvx_v3 we = mvx_v3_init(
+      mvx_absf(m[0]) * e.x + mvx_absf(m[1]) * e.y + mvx_absf(m[2]) * e.z,
+      mvx_absf(m[4]) * e.x + mvx_absf(m[5]) * e.y + mvx_absf(m[6]) * e.z,
+      mvx_absf(m[8]) * e.x + mvx_absf(m[9]) * e.y + mvx_absf(m[10]) * e.z);
+
+  *min_out = mvx_v3_sub(c, we);
+  *max_out = mvx_v3_add(c, we);
+}
+
+/* Clears the target and sweeps every visible instance with the given MVX_MODE_*, stats may be 0 */
+MVX_API MVX_INLINE int mvx_voxelize_instances_target(
+    float *vertices, unsigned long vertices_size,
+    int *indices, unsigned long indices_size,
+    float *transforms, unsigned long instance_count,
+    mvx_grid *grid,
+    int mode,
+    mvx_target target,
+    mvx_stats *stats)
+{
+  mvx_mesh mesh = mvx_mesh_init(vertices, vertices_size, indices, indices_size);
+  unsigned long tricount = mvx_mesh_triangle_count(&mesh);
+  unsigned long i, t;
+  mvx_v3 local_min, local_max, pad;
+  mvx_mesh_batch batch;
+  int k;
+
+  if (!grid || !mvx_mesh_valid(&mesh) || (!transforms && instance_count) || mode < MVX_MODE_CONSERVATIVE || mode > MVX_MODE_CENTER)
+  {
+    return 0;
+  }
+
+  MVX_STATS_PHASE_BEGIN(stats);
+  mvx_target_clear(&target, grid, 0, grid->z);
+  MVX_STATS_PHASE_END(stats, clear_time);
+
+  /* per mesh: bounds once for all instances */
+  MVX_STATS_PHASE_BEGIN(stats);
+  mvx_mesh_bounds(&mesh, &local_min, &local_max);
+  pad = mvx_v3_init(grid->vxsize, grid->vxsize, grid->vxsize);
+  MVX_STATS_PHASE_END(stats, bounds_time);
+
+  MVX_STATS_PHASE_BEGIN(stats);
+
+  for (i = 0; i < instance_count; ++i)
+  {
+    float *m = transforms + MVX_TRANSFORM_FLOATS * i;
+    mvx_v3 world_min, world_max;
+    mvx_v3i clip_min, clip_max;
+
+    mvx_transform_box(m, local_min, local_max, &world_min, &world_max);
+
+    /* one voxel of slack, so rounding never clips a triangle against its own instance bounds */
+    world_min = mvx_v3_sub(world_min, pad);
+    world_max = mvx_v3_add(world_max, pad);
+
+    if (!mvx_grid_box_range(grid, world_min, world_max, &clip_min, &clip_max))
+    {
+      continue;
+    }
+
+    for (t = 0; t < tricount; t += MVX_MESH_BATCH)
+    {
+      mvx_mesh_fetch(&mesh, 0, t, mvx_mesh_batch_count(t, tricount), &batch);
+
+      for (k = 0; k < batch.count; ++k)
+      {
+        mvx_v3 v0 = mvx_transform_point(m, batch.v[3 * k + 0]);
+        mvx_v3 v1 = mvx_transform_point(m, batch.v[3 * k + 1]);
+        mvx_v3 v2 = mvx_transform_point(m, batch.v[3 * k + 2]);
+        mvx_target_triangle(&target, batch.triangles[k], v0, v1, v2);
+        mvx_voxelize_triangle_mode(grid, v0, v1, v2, clip_min, clip_max, mode, &target, stats);
+      }
+    }
+  }
+
+  MVX_STATS_PHASE_END(stats, sweep_time);
+
+  return 1;
+}
+
+/* Voxelizes instance_count transformed copies of one mesh into the grid of grid_x * grid_y * grid_z
+ * voxels of size voxel_size whose first voxel starts at origin (no fitting, no padding). Instances
+ * outside of the grid are skipped, partially visible ones are clipped.
+ */
+MVX_API MVX_INLINE int mvx_voxelize_instances(
+    float *vertices, unsigned long vertices_size,
+    int *indices, unsigned long indices_size,
+    float *transforms,             /* MVX_TRANSFORM_FLOATS floats per instance (row-major 3x4 local to world). */
+    unsigned long instance_count,
+    float origin_x, float origin_y, float origin_z,
+    float voxel_size,
+    int grid_x, int grid_y, int grid_z,
+    unsigned char *output_voxels)
+{
+  mvx_grid grid;
+  mvx_target target;
+
+  if (!output_voxels || !mvx_grid_init(&grid, mvx_v3_init(origin_x, origin_y, origin_z), voxel_size, grid_x, grid_y, grid_z))
+  {
+    return 0;
+  }
+
+  target = mvx_target_init(MVX_TARGET_BYTES);
+  target.bytes = output_voxels;
+
+  return mvx_voxelize_instances_target(
+      vertices, vertices_size, indices, indices_size,
+      transforms, instance_count, &grid, MVX_MODE_CONSERVATIVE, target, 0);
+}
+
+/* Bit-packed variant of mvx_voxelize_instances (see mvx_bits_row_words) */
+MVX_API MVX_INLINE int mvx_voxelize_instances_bits(
+    float *vertices, unsigned long vertices_size,
+    int *indices, unsigned long indices_size,
+    float *transforms,
+    unsigned long instance_count,
+    float origin_x, float origin_y, float origin_z,
+    float voxel_size,
+    int grid_x, int grid_y, int grid_z,
+    unsigned int *output_bits)
+{
+  mvx_grid grid;
+  mvx_target target;
+
+  if (!output_bits || !mvx_grid_init(&grid, mvx_v3_init(origin_x, origin_y, origin_z), voxel_size, grid_x, grid_y, grid_z))
+  {
+    return 0;
+  }
+
+  target = mvx_target_init(MVX_TARGET_BITS);
+  target.bits = output_bits;
+
+  return mvx_voxelize_instances_target(
+      vertices, vertices_size, indices, indices_size,
+      transforms, instance_count, &grid, MVX_MODE_CONSERVATIVE, target, 0);
+}
+
+/* #############################################################################
+ * # Incremental Voxelization
+ * #############################################################################
+ *
+ * Keeps per voxel triangle counts (see mvx_counts) so that edits only sweep
+ * the changed triangles: the old position is removed, the new one added.
+ * The grid mapping is fixed by mvx_incremental_init, geometry that moves out
+ * of it is clipped.
+ */
+typedef struct mvx_incremental
+{
+  mvx_grid grid;     /* Fixed mapping of the initial mesh. */
+  int mode;          /* MVX_MODE_* of every sweep. */
+  mvx_counts counts;
+
+} mvx_incremental;
+
+MVX_API MVX_INLINE void mvx_incremental_sweep(mvx_incremental *inc, mvx_v3 v0, mvx_v3 v1, mvx_v3 v2, int delta)
+{
+  mvx_target target = mvx_target_init(MVX_TARGET_COUNTS);
+  mvx_v3i clip_min = mvx_v3i_init(0, 0, 0);
+  mvx_v3i clip_max = mvx_v3i_init(inc->grid.x - 1, inc->grid.y - 1, inc->grid.z - 1);
+
+  target.counts = &inc->counts;
+  inc->counts.delta = delta;
+
+  mvx_voxelize_triangle_mode(&inc->grid, v0, v1, v2, clip_min, clip_max, inc->mode, &target, 0);
+}
+
+MVX_API MVX_INLINE void mvx_incremental_add_triangle(mvx_incremental *inc, mvx_v3 v0, mvx_v3 v1, mvx_v3 v2)
+{
+  mvx_incremental_sweep(inc, v0, v1, v2, 1);
+}
+
+/* v0, v1, v2 have to be exactly the positions the triangle was added with */
+MVX_API MVX_INLINE void mvx_incremental_remove_triangle(mvx_incremental *inc, mvx_v3 v0, mvx_v3 v1, mvx_v3 v2)
+{
+  mvx_incremental_sweep(inc, v0, v1, v2, -1);
+}
+
+/* Voxelizes the mesh like mvx_voxelize_mesh_mode and records the triangle count of every voxel.
+ * counts and output_voxels need grid_x * grid_y * grid_z entries and stay in use for the updates.
+ * Returns 0 on invalid input or if a voxel is covered by more than 65535 triangles.
+ */
+MVX_API MVX_INLINE int mvx_incremental_init(
+    mvx_incremental *inc,
+    float *vertices, unsigned long vertices_size,
+    int *indices, unsigned long indices_size,
+    int grid_x, int grid_y, int grid_z,
+    int grid_pad_x, int grid_pad_y, int grid_pad_z,
+    int mode,                     /* MVX_MODE_* */
+    unsigned short *counts,       /* Per voxel triangle counts. */
+    unsigned char *output_voxels) /* 1 where the count is not 0. */
+{
+  mvx_voxelize_job job;
+  long q, volume;
+
+  if (!inc || !counts || !output_voxels || mode < MVX_MODE_CONSERVATIVE || mode > MVX_MODE_CENTER)
+  {
+    return 0;
+  }
+
+  if (!mvx_voxelize_job_init(&job, vertices, vertices_size, indices, indices_size, grid_x, grid_y, grid_z, grid_pad_x, grid_pad_y, grid_pad_z, 0, mvx_target_init(MVX_TARGET_COUNTS)))
+  {
+    return 0;
+  }
+
+  inc->grid = job.grid;
+  inc->mode = mode;
+  inc->counts.counts = counts;
+  inc->counts.voxels = output_voxels;
+  inc->counts.delta = 1;
+  inc->counts.overflow = 0;
+
+  volume = (long)grid_x * (long)grid_y * (long)grid_z;
+  for (q = 0; q < volume; ++q)
+  {
+    counts[q] = 0;
+    output_voxels[q] = 0;
+  }
+
+  job.mode = mode;
+  job.target.counts = &inc->counts;
+  mvx_voxelize_job_slab(&job, 0, grid_z);
+
+  return !inc->counts.overflow;
+}
+
+/* Moves the changed triangles from their positions in old_vertices to the ones in new_vertices.
+ * Only the voxels of those triangles are touched. Both vertex arrays use the same indices.
+ * Returns 0 if a changed triangle is out of range or a count overflowed.
+ */
+MVX_API MVX_INLINE int mvx_incremental_update(
+    mvx_incremental *inc,
+    float *old_vertices,              /* Vertex positions the triangles were voxelized with. */
+    float *new_vertices,              /* Vertex positions after the edit. */
+    unsigned long vertices_size,
+    int *indices, unsigned long indices_size,
+    unsigned int *changed_triangles,  /* Indices of the triangles that moved. */
+    unsigned long changed_count)
+{
+  mvx_mesh old_mesh = mvx_mesh_init(old_vertices, vertices_size, indices, indices_size);
+  mvx_mesh new_mesh = mvx_mesh_init(new_vertices, vertices_size, indices, indices_size);
+  unsigned long tricount = mvx_mesh_triangle_count(&new_mesh);
+  unsigned long i;
+  int result = 1;
+
+  if (!inc || !mvx_mesh_valid(&old_mesh) || !mvx_mesh_valid(&new_mesh) || (!changed_triangles && changed_count))
+  {
+    return 0;
+  }
+
+  for (i = 0; i < changed_count; ++i)
+  {
+    unsigned long t = changed_triangles[i];
+    mvx_v3 v0, v1, v2;
+
+    if (t >= tricount)
+    {
+      result = 0;
+      continue;
+    }
+
+    if (mvx_mesh_triangle(&old_mesh, t, &v0, &v1, &v2))
+    {
+      mvx_incremental_remove_triangle(inc, v0, v1, v2);
+    }
+
+    if (mvx_mesh_triangle(&new_mesh, t, &v0, &v1, &v2))
+    {
+      mvx_incremental_add_triangle(inc, v0, v1, v2);
+    }
+  }
+
+  return result && !inc->counts.overflow;
+}
+
+/* #############################################################################
+ * # Sparse Voxel DAG
+ * #############################################################################
+ *
+ * Sparse voxel octree with identical subtrees merged (SVDAG), stored as a
+ * pool of unsigned int words. The root covers size^3 voxels (size is the
+ * power of two that contains the grid, at least 8). A node at depth d covers
+ * (size >> d)^3 voxels, children are numbered c = x | y << 1 | z << 2.
+ *
+ *   inner node: word 0 = child mask (bit c set if child c is not empty),
+ *               followed by one word per set bit (ascending c) with the
+ *               word index of the child node.
+ *   leaf node:  nodes covering 4^3 voxels, two words with one bit per voxel
+ *               at bit (x + 4 * y + 16 * z).
+ *
+ * Nodes are built bottom-up in Morton order from the sparse brick map and
+ * deduplicated by content, so node indices of identical subtrees are equal.
+ */
+typedef struct mvx_svdag
+{
+  unsigned int *nodes;     /* The node pool (caller memory). */
+  unsigned long capacity;  /* Capacity of the pool in words. */
+  unsigned long used;      /* Used words. */
+  unsigned int root;       /* Word index of the root node. */
+  int size;                /* Edge length of the cube covered by the root. */
+
+} mvx_svdag;
+
+/* LSD radix sort of keys (and values) over the lowest key_bits bits. tmp_keys and tmp_values need count entries. */
+MVX_API MVX_INLINE void mvx_radix_sort(
+    unsigned int *keys, unsigned int *values,
+    unsigned int *tmp_keys, unsigned int *tmp_values,
+    unsigned long count, int key_bits)
+{
+  unsigned long histogram[256];
+  int shift;
+
+  for (shift = 0; shift < key_bits; shift += 8)
+  {
+    unsigned long i;
+    unsigned long total = 0;
+
+    for (i = 0; i < 256; ++i)
+    {
+      histogram[i] = 0;
+    }
+    for (i = 0; i < count; ++i)
+    {
+      histogram[(keys[i] >> shift) & 0xFFu]++;
+    }
+    for (i = 0; i < 256; ++i)
+    {
+      unsigned long c = histogram[i];
+      histogram[i] = total;
+      total += c;
+    }
+    for (i = 0; i < count; ++i)
+    {
+      unsigned long dst = histogram[(keys[i] >> shift) & 0xFFu]++;
+      tmp_keys[dst] = keys[i];
+      tmp_values[dst] = values[i];
+    }
+
+    /* copy back so the result always ends up in keys/values */
+    for (i = 0; i < count; ++i)
+    {
+      keys[i] = tmp_keys[i];
+      values[i] = tmp_values[i];
+    }
+  }
+}
+
+typedef struct mvx_svdag_builder
+{
+  mvx_svdag *dag;
+  unsigned int *table;     /* open addressing hash table of node indices + 1 (0 = empty) */
+  unsigned long table_mask;
+
+} mvx_svdag_builder;
+
+/* Hash table slots used by the deduplication for a pool of capacity words */
+MVX_API MVX_INLINE unsigned long mvx_svdag_table_size(unsigned long capacity)
+{
+  unsigned long slots = 16;
+
+  /* every node has at least two words, keep the load factor at or below 1/2 */
+  while (slots < capacity)
+  {
+    slots <<= 1;
+  }
+
+  return slots;
+}
+
+/* Adds the node (count words) or returns the index of an identical one. Returns 0xFFFFFFFF if the pool is full. */
+MVX_API MVX_INLINE unsigned int mvx_svdag_add(mvx_svdag_builder *b, unsigned int *node, unsigned long count)
+{
+  mvx_svdag *dag = b->dag;
+  unsigned int hash = 2166136261u;
+  unsigned long slot, i;
+
+  for (i = 0; i < count; ++i)
+  {
+    hash = (hash ^ node[i]) * 16777619u;
+  }
+
+  for (slot = hash & b->table_mask;; slot = (slot + 1) & b->table_mask)
+  {
+    unsigned int entry = b->table[slot];
+
+    if (!entry)
+    {
+      break;
+    }
+
+    /* an identical word sequence can be shared, whatever node it was written for */
+    if (entry - 1 + count <= dag->used)
+    {
+      unsigned int *other = dag->nodes + (entry - 1);
+
+      for (i = 0; i < count && other[i] == node[i]; ++i)
+      {
+      }
+
+      if (i == count)
+      {
+        return entry - 1;
+      }
+    }
+  }
+
+  if (count > dag->capacity - dag->used || dag->used >= 0xFFFFFFFEul)
+  {
+    return 0xFFFFFFFFu;
+  }
+
+  for (i = 0; i < count; ++i)
+  {
+    dag->nodes[dag->used + i] = node[i];
+  }
+
+  b->table[slot] = (unsigned int)dag->used + 1;
+  dag->used += count;
+
+  return b->table[slot] - 1;
+}
+
+/* Builds the node of an 8^3 brick (an inner node with up to eight 4^3 leaves) */
+MVX_API MVX_INLINE unsigned int mvx_svdag_add_brick(mvx_svdag_builder *b, unsigned int *brick)
+{
+  unsigned int node[9];
+  unsigned long count = 1;
+  unsigned int c;
+
+  node[0] = 0;
+
+  for (c = 0; c < 8; ++c)
+  {
+    unsigned int leaf[2];
+    unsigned int ox = (c & 1u) * 4, oy = ((c >> 1) & 1u) * 4, oz = ((c >> 2) & 1u) * 4;
+    unsigned int j, k;
+
+    leaf[0] = leaf[1] = 0;
+
+    for (k = 0; k < 4; ++k)
+    {
+      for (j = 0; j < 4; ++j)
+      {
+        unsigned int row = (oy + j) + MVX_BRICK_SIZE * (oz + k);
+        unsigned int bits = (brick[row / 4] >> ((row % 4) * 8 + ox)) & 0xFu;
+        unsigned int bit = 4 * j + 16 * k;
+
+        leaf[bit / 32] |= bits << (bit % 32);
+      }
+    }
+
+    if (leaf[0] | leaf[1])
+    {
+      unsigned int id = mvx_svdag_add(b, leaf, 2);
+
+      if (id == 0xFFFFFFFFu)
+      {
+        return id;
+      }
+
+      node[0] |= 1u << c;
+      node[count++] = id;
+    }
+  }
+
+  return mvx_svdag_add(b, node, count);
+}
+
+/* Reads voxel (x, y, z) of the DAG */
+MVX_API MVX_INLINE int mvx_svdag_get(mvx_svdag *dag, int x, int y, int z)
+{
+  unsigned int node = dag->root;
+  int size = dag->size;
+
+  if (x < 0 || y < 0 || z < 0 || x >= size || y >= size || z >= size)
+  {
+    return 0;
+  }
+
+  while (size > 4)
+  {
+    unsigned int c, mask;
+    int half = size / 2;
+
+    c = (unsigned int)((x >= half) | ((y >= half) << 1) | ((z >= half) << 2));
+    mask = dag->nodes[node];
+
+    if (!(mask & (1u << c)))
+    {
+      return 0;
+    }
+
+    /* skip the pointers of the set children below c */
+    {
+      unsigned int below = mask & ((1u << c) - 1u);
+      unsigned int slot = 0;
+
+      for (; below; below &= below - 1u)
+      {
+        ++slot;
+      }
+
+      node = dag->nodes[node + 1 + slot];
+    }
+
+    x %= half;
+    y %= half;
+    z %= half;
+    size = half;
+  }
+
+  {
+    int bit = x + 4 * y + 16 * z;
+    return (int)((dag->nodes[node + (unsigned int)(bit / 32)] >> (bit % 32)) & 1u);
+  }
+}
+
+/* Edge length of the cube an SVDAG of the grid covers */
+MVX_API MVX_INLINE int mvx_svdag_size(int grid_x, int grid_y, int grid_z)
+{
+  int size = MVX_BRICK_SIZE;
+  int max = mvx_maxi(grid_x, mvx_maxi(grid_y, grid_z));
+
+  while (size < max)
+  {
+    size <<= 1;
+  }
+
+  return size;
+}
+
+/* Worst case scratch bytes of mvx_voxelize_mesh_svdag for a node pool of capacity words */
+MVX_API MVX_INLINE unsigned long mvx_voxelize_mesh_svdag_memory_size(
+    float *vertices, unsigned long vertices_size,
+    int *indices, unsigned long indices_size,
+    int grid_x, int grid_y, int grid_z,
+    int grid_pad_x, int grid_pad_y, int grid_pad_z,
+    unsigned long capacity)
+{
+  unsigned long bricks;
+  unsigned long sparse = mvx_voxelize_mesh_sparse_memory_size(
+      vertices, vertices_size, indices, indices_size,
+      grid_x, grid_y, grid_z, grid_pad_x, grid_pad_y, grid_pad_z);
+
+  if (!sparse)
+  {
+    return 0;
+  }
+
+  bricks = (unsigned long)mvx_brickmap_index_count(grid_x, grid_y, grid_z);
+
+  /* brick map + 4 sort arrays + hash table */
+  return sparse +
+         4 * mvx_arena_aligned_size(bricks * (unsigned long)sizeof(unsigned int)) +
+         mvx_arena_aligned_size(mvx_svdag_table_size(capacity) * (unsigned long)sizeof(unsigned int));
+}
+
+/* Voxelizes the mesh into a sparse voxel DAG without a dense grid (via the sparse brick map).
+ * memory is scratch memory, see mvx_voxelize_mesh_svdag_memory_size. The nodes are written
+ * to output_nodes. Returns 0 if one of them is too small.
+ */
+MVX_API MVX_INLINE int mvx_voxelize_mesh_svdag(
+    float *vertices, unsigned long vertices_size,
+    int *indices, unsigned long indices_size,
+    int grid_x, int grid_y, int grid_z,
+    int grid_pad_x, int grid_pad_y, int grid_pad_z,
+    void *memory, unsigned long memory_size,    /* Scratch memory. */
+    unsigned int *output_nodes,                 /* The node pool. */
+    unsigned long output_capacity,              /* Capacity of the node pool in words. */
+    mvx_svdag *output_dag)
+{
+  mvx_brickmap map;
+  mvx_arena arena;
+  mvx_svdag_builder builder;
+  unsigned int *keys, *values, *tmp_keys, *tmp_values;
+  unsigned long count = 0;
+  unsigned long i;
+  int bx, by, bz;
+  int span, key_bits = 0;
+
+  if (!output_nodes || !output_dag || !memory)
+  {
+    return 0;
+  }
+
+  /* the sort arrays and the hash table follow the brick map in the same arena */
+  mvx_arena_init(&arena, memory, memory_size);
+
+  if (!mvx_voxelize_mesh_sparse_arena(
+          vertices, vertices_size, indices, indices_size,
+          grid_x, grid_y, grid_z, grid_pad_x, grid_pad_y, grid_pad_z,
+          &arena, &map))
+  {
+    return 0;
+  }
+
+  keys = (unsigned int *)mvx_arena_push(&arena, map.brick_count * (unsigned long)sizeof(unsigned int));
+  values = (unsigned int *)mvx_arena_push(&arena, map.brick_count * (unsigned long)sizeof(unsigned int));
+  tmp_keys = (unsigned int *)mvx_arena_push(&arena, map.brick_count * (unsigned long)sizeof(unsigned int));
+  tmp_values = (unsigned int *)mvx_arena_push(&arena, map.brick_count * (unsigned long)sizeof(unsigned int));
+
+  output_dag->nodes = output_nodes;
+  output_dag->capacity = output_capacity;
+  output_dag->used = 0;
+  output_dag->root = 0;
+  output_dag->size = mvx_svdag_size(grid_x, grid_y, grid_z);
+
+  builder.dag = output_dag;
+  builder.table_mask = mvx_svdag_table_size(output_capacity) - 1;
+  builder.table = (unsigned int *)mvx_arena_push(&arena, (builder.table_mask + 1) * (unsigned long)sizeof(unsigned int));
+
+  if ((map.brick_count && (!keys || !values || !tmp_keys || !tmp_values)) || !builder.table)
+  {
+    return 0;
+  }
+
+  for (i = 0; i <= builder.table_mask; ++i)
+  {
+    builder.table[i] = 0;
+  }
+
+  /* the bricks in Morton order */
+  for (bz = 0; bz < map.count.z; ++bz)
+  {
+    for (by = 0; by < map.count.y; ++by)
+    {
+      for (bx = 0; bx < map.count.x; ++bx)
+      {
+        unsigned int entry = map.index[bx + by * map.count.x + (long)bz * map.count.x * map.count.y];
+
+        if (entry)
+        {
+          keys[count] = mvx_morton_encode3((unsigned int)bx, (unsigned int)by, (unsigned int)bz);
+          values[count] = entry - 1;
+          ++count;
+        }
+      }
+    }
+  }
+
+  for (span = output_dag->size / MVX_BRICK_SIZE; span > 1; span >>= 1)
+  {
+    key_bits += 3;
+  }
+
+  mvx_radix_sort(keys, values, tmp_keys, tmp_values, count, key_bits);
+
+  /* level of 8^3 bricks */
+  for (i = 0; i < count; ++i)
+  {
+    values[i] = mvx_svdag_add_brick(&builder, map.bricks + (unsigned long)values[i] * MVX_BRICK_WORDS);
+
+    if (values[i] == 0xFFFFFFFFu)
+    {
+      return 0;
+    }
+  }
+
+  /* merge siblings bottom-up until one node covers the whole cube */
+  for (span = MVX_BRICK_SIZE; span < output_dag->size; span <<= 1)
+  {
+    unsigned long read = 0;
+    unsigned long write = 0;
+
+    while (read < count)
+    {
+      unsigned int node[9];
+      unsigned long n = 1;
+      unsigned int parent = keys[read] >> 3;
+
+      node[0] = 0;
+
+      for (; read < count && (keys[read] >> 3) == parent; ++read)
+      {
+        node[0] |= 1u << (keys[read] & 7u);
+        node[n++] = values[read];
+      }
+
+      keys[write] = parent;
+      values[write] = mvx_svdag_add(&builder, node, n);
+
+      if (values[write] == 0xFFFFFFFFu)
+      {
+        return 0;
+      }
+
+      ++write;
+    }
+
+    count = write;
+  }
+
+  if (count)
+  {
+    output_dag->root = values[0];
+  }
+  else
+  {
+    /* empty root */
+    unsigned int node[2];
+    node[0] = node[1] = 0;
+    output_dag->root = mvx_svdag_add(&builder, node, 2);
+
+    if (output_dag->root == 0xFFFFFFFFu)
+    {
+      return 0;
+    }
+  }
+
+  return 1;
+}
+
+/* #############################################################################
+ * # Binary Container
+ * #############################################################################
+ *
+ * Versioned file layout that is used in place (e.g. after mmap), opening it
+ * validates the header (and the brick map index) and sets pointers, the
+ * voxels themselves are never read or copied.
+ *
+ *   offset 0                       mvx_file_header (128 bytes)
+ *   offset payload_offset          MVX_FILE_BYTES:    grid_x * grid_y * grid_z bytes
+ *                                  MVX_FILE_BITS:     mvx_bits_size words (see Bit-packed Voxel Grid)
+ *                                  MVX_FILE_BRICKMAP: brick map index words, then at
+ *                                                     payload_offset + bricks_offset the bricks
+ *
+ * Offsets are MVX_FILE_ALIGNMENT aligned. Values are stored in native byte
+ * order, a file from a machine with a different one fails the magic check.
+ * Opening rejects sizes that overflow, payloads that do not fit the file,
+ * object ranges outside the grid and brick index entries past brick_count,
+ * so no accessor reads outside the file memory.
+ */
+#define MVX_FILE_MAGIC 0x3158564Du /* "MVX1" */
+#define MVX_FILE_VERSION 1
+#define MVX_FILE_ALIGNMENT 64
+
+#define MVX_FILE_BYTES 0
+#define MVX_FILE_BITS 1
+#define MVX_FILE_BRICKMAP 2
+
+#define MVX_FILE_FLAG_SOLID 1u /* the interior is filled */
+
+typedef struct mvx_file_header
+{
+  unsigned int magic;           /* MVX_FILE_MAGIC */
+  unsigned int version;         /* MVX_FILE_VERSION */
+  unsigned int header_size;     /* sizeof(mvx_file_header) */
+  unsigned int layout;          /* MVX_FILE_BYTES, MVX_FILE_BITS or MVX_FILE_BRICKMAP */
+  unsigned int flags;           /* MVX_FILE_FLAG_* */
+  unsigned int payload_offset;  /* from the start of the file */
+  unsigned int payload_size_lo; /* payload bytes, split for 32 bit longs */
+  unsigned int payload_size_hi;
+  int grid_x, grid_y, grid_z;   /* mvx_grid the voxels were produced with */
+  int margin_x, margin_y, margin_z;
+  int need_x, need_y, need_z;
+  float min_x, min_y, min_z;
+  float voxel_size;
+  unsigned int brick_count;     /* brick map: bricks after the index */
+  unsigned int bricks_offset;   /* brick map: from the start of the payload */
+  unsigned int reserved[9];     /* zero */
+
+} mvx_file_header;
+
+/* A opened file, every pointer points into the file memory */
+typedef struct mvx_file
+{
+  mvx_file_header *header;
+  mvx_grid grid;
+  unsigned char *bytes;  /* MVX_FILE_BYTES */
+  unsigned int *bits;    /* MVX_FILE_BITS */
+  mvx_brickmap brickmap; /* MVX_FILE_BRICKMAP: full, no bricks can be added */
+
+} mvx_file;
+
+MVX_API MVX_INLINE unsigned long mvx_file_align(unsigned long bytes)
+{
+  return (bytes + (MVX_FILE_ALIGNMENT - 1)) & ~(unsigned long)(MVX_FILE_ALIGNMENT - 1);
+}
+
+/* a * b * c, or 0 if it does not fit an unsigned long */
+MVX_API MVX_INLINE unsigned long mvx_file_product(unsigned long a, unsigned long b, unsigned long c)
+{
+  unsigned long max = ~0ul;
+
+  if (!a || !b || !c || b > max / a || c > max / (a * b))
+  {
+    return 0;
+  }
+
+  return a * b * c;
+}
+
+/* Payload bytes, and the offset of the bricks for a brick map. 0 for an empty grid or if the size
+ * does not fit an unsigned long.
+ */
+MVX_API MVX_INLINE unsigned long mvx_file_payload_size(mvx_grid *grid, int layout, unsigned int brick_count, unsigned long *bricks_offset)
+{
+  unsigned long max = ~0ul;
+  unsigned long brick_bytes = MVX_BRICK_WORDS * (unsigned long)sizeof(unsigned int);
+  unsigned long x, y, z, index;
+
+  *bricks_offset = 0;
+
+  if (grid->x <= 0 || grid->y <= 0 || grid->z <= 0)
+  {
+    return 0;
+  }
+
+  x = (unsigned long)grid->x;
+  y = (unsigned long)grid->y;
+  z = (unsigned long)grid->z;
+
+  if (layout == MVX_FILE_BITS)
+  {
+    return mvx_file_product((x + MVX_BITS_PER_WORD - 1) / MVX_BITS_PER_WORD * (unsigned long)sizeof(unsigned int), y, z);
+  }
+  else if (layout == MVX_FILE_BRICKMAP)
+  {
+    index = mvx_file_product((x + MVX_BRICK_SIZE - 1) / MVX_BRICK_SIZE, (y + MVX_BRICK_SIZE - 1) / MVX_BRICK_SIZE, (z + MVX_BRICK_SIZE - 1) / MVX_BRICK_SIZE);
+
+    if (!index || index > (max - (MVX_FILE_ALIGNMENT - 1)) / (unsigned long)sizeof(unsigned int))
+    {
+      return 0;
+    }
+
+    *bricks_offset = mvx_file_align(index * (unsigned long)sizeof(unsigned int));
+
+    if ((unsigned long)brick_count > (max - *bricks_offset) / brick_bytes)
+    {
+      *bricks_offset = 0;
+      return 0;
+    }
+
+    return *bricks_offset + (unsigned long)brick_count * brick_bytes;
+  }
+
+  return mvx_file_product(x, y, z);
+}
+
+/* Total file bytes, brick_count is only used for MVX_FILE_BRICKMAP. 0 if the size does not fit an unsigned long. */
+MVX_API MVX_INLINE unsigned long mvx_file_size(mvx_grid *grid, int layout, unsigned int brick_count)
+{
+  unsigned long header_size = mvx_file_align((unsigned long)sizeof(mvx_file_header));
+  unsigned long bricks_offset;
+  unsigned long payload_size = mvx_file_payload_size(grid, layout, brick_count, &bricks_offset);
+
+  if (!payload_size || payload_size > ~0ul - header_size)
+  {
+    return 0;
+  }
+
+  return header_size + payload_size;
+}
+
+MVX_API MVX_INLINE void mvx_file_copy(unsigned char *dst, unsigned char *src, unsigned long bytes)
+{
+  unsigned long i;
+
+  for (i = 0; i < bytes; ++i)
+  {
+    dst[i] = src[i];
+  }
+}
+
+/* Writes the header and returns the payload pointer, 0 if the buffer is too small */
+MVX_API MVX_INLINE unsigned char *mvx_file_write_header(void *buffer, unsigned long buffer_size, mvx_grid *grid, int layout, unsigned int flags, unsigned int brick_count)
+{
+  mvx_file_header *header = (mvx_file_header *)buffer;
+  unsigned long bricks_offset;
+  unsigned long payload_size = mvx_file_payload_size(grid, layout, brick_count, &bricks_offset);
+  unsigned long payload_offset = mvx_file_align((unsigned long)sizeof(mvx_file_header));
+  unsigned char *bytes = (unsigned char *)buffer;
+  unsigned long i;
+
+  if (!buffer || !payload_size || (bricks_offset >> 16) >> 16 ||
+      buffer_size < payload_offset || buffer_size - payload_offset < payload_size)
+  {
+    return 0;
+  }
+
+  /* the gap up to the payload is zero */
+  for (i = 0; i < payload_offset; ++i)
+  {
+    bytes[i] = 0;
+  }
+
+  header->magic = MVX_FILE_MAGIC;
+  header->version = MVX_FILE_VERSION;
+  header->header_size = (unsigned int)sizeof(mvx_file_header);
+  header->layout = (unsigned int)layout;
+  header->flags = flags;
+  header->payload_offset = (unsigned int)payload_offset;
+  header->payload_size_lo = (unsigned int)(payload_size & 0xFFFFFFFFul);
+  header->payload_size_hi = (unsigned int)((payload_size >> 16) >> 16);
+  header->grid_x = grid->x;
+  header->grid_y = grid->y;
+  header->grid_z = grid->z;
+  header->margin_x = grid->margin.x;
+  header->margin_y = grid->margin.y;
+  header->margin_z = grid->margin.z;
+  header->need_x = grid->need.x;
+  header->need_y = grid->need.y;
+  header->need_z = grid->need.z;
+  header->min_x = grid->min_b.x;
+  header->min_y = grid->min_b.y;
+  header->min_z = grid->min_b.z;
+  header->voxel_size = grid->vxsize;
+  header->brick_count = brick_count;
+  header->bricks_offset = (unsigned int)bricks_offset;
+
+  return bytes + payload_offset;
+}
+
+/* Stores the output of mvx_voxelize_mesh produced with grid (see mvx_grid_fit), returns the file size or 0 */
+MVX_API MVX_INLINE unsigned long mvx_file_write_bytes(void *buffer, unsigned long buffer_size, mvx_grid *grid, unsigned int flags, unsigned char *voxels)
+{
+  unsigned char *payload = voxels ? mvx_file_write_header(buffer, buffer_size, grid, MVX_FILE_BYTES, flags, 0) : 0;
+
+  if (!payload)
+  {
+    return 0;
+  }
+
+  mvx_file_copy(payload, voxels, (unsigned long)grid->x * (unsigned long)grid->y * (unsigned long)grid->z);
+
+  return mvx_file_size(grid, MVX_FILE_BYTES, 0);
+}
+
+/* Stores the output of mvx_voxelize_mesh_bits */
+MVX_API MVX_INLINE unsigned long mvx_file_write_bits(void *buffer, unsigned long buffer_size, mvx_grid *grid, unsigned int flags, unsigned int *bits)
+{
+  unsigned char *payload = bits ? mvx_file_write_header(buffer, buffer_size, grid, MVX_FILE_BITS, flags, 0) : 0;
+
+  if (!payload)
+  {
+    return 0;
+  }
+
+  mvx_file_copy(payload, (unsigned char *)bits, (unsigned long)mvx_bits_size(grid->x, grid->y, grid->z) * (unsigned long)sizeof(unsigned int));
+
+  return mvx_file_size(grid, MVX_FILE_BITS, 0);
+}
+
+/* Stores the output of mvx_voxelize_mesh_sparse, only the allocated bricks are written */
+MVX_API MVX_INLINE unsigned long mvx_file_write_brickmap(void *buffer, unsigned long buffer_size, mvx_grid *grid, unsigned int flags, mvx_brickmap *map)
+{
+  unsigned char *payload;
+  mvx_file_header *header;
+
+  if (!map || map->grid_x != grid->x || map->grid_y != grid->y || map->grid_z != grid->z)
+  {
+    return 0;
+  }
+
+  payload = mvx_file_write_header(buffer, buffer_size, grid, MVX_FILE_BRICKMAP, flags, map->brick_count);
+
+  if (!payload)
+  {
+    return 0;
+  }
+
+  header = (mvx_file_header *)buffer;
+
+  mvx_file_copy(payload, (unsigned char *)map->index, (unsigned long)mvx_brickmap_index_count(grid->x, grid->y, grid->z) * (unsigned long)sizeof(unsigned int));
+  mvx_file_copy(payload + header->bricks_offset, (unsigned char *)map->bricks, (unsigned long)map->brick_count * MVX_BRICK_WORDS * (unsigned long)sizeof(unsigned int));
+
+  return mvx_file_size(grid, MVX_FILE_BRICKMAP, map->brick_count);
+}
+
+/* Validates the header of a file in memory (aligned to at least 4 bytes) and points file into it without copying */
+MVX_API MVX_INLINE int mvx_file_open(void *data, unsigned long data_size, mvx_file *file)
+{
+  mvx_file_header *header = (mvx_file_header *)data;
+  unsigned char *bytes = (unsigned char *)data;
+  unsigned long bricks_offset;
+  unsigned long payload_size;
+  unsigned long entries, e;
+  unsigned int *index;
+  int i;
+
+  if (!data || !file || data_size < (unsigned long)sizeof(mvx_file_header))
+  {
+    return 0;
+  }
+
+  /* the grid stays small enough to round up to words and bricks in int */
+  if (header->magic != MVX_FILE_MAGIC || header->version != MVX_FILE_VERSION ||
+      header->header_size != (unsigned int)sizeof(mvx_file_header) ||
+      header->layout > MVX_FILE_BRICKMAP || header->payload_offset % MVX_FILE_ALIGNMENT ||
+      header->payload_offset < mvx_file_align((unsigned long)sizeof(mvx_file_header)) ||
+      header->grid_x <= 0 || header->grid_y <= 0 || header->grid_z <= 0 ||
+      header->grid_x > 0x7FFFFFFF - MVX_BITS_PER_WORD || header->grid_y > 0x7FFFFFFF - MVX_BITS_PER_WORD ||
+      header->grid_z > 0x7FFFFFFF - MVX_BITS_PER_WORD || !(header->voxel_size > 0.0f))
+  {
+    return 0;
+  }
+
+  /* the object range margin .. margin + need - 1 lies in the grid, like the one of mvx_grid_fit */
+  if (header->margin_x < 0 || header->margin_y < 0 || header->margin_z < 0 ||
+      header->need_x <= 0 || header->need_y <= 0 || header->need_z <= 0 ||
+      header->need_x > header->grid_x - header->margin_x ||
+      header->need_y > header->grid_y - header->margin_y ||
+      header->need_z > header->grid_z - header->margin_z)
+  {
+    return 0;
+  }
+
+  /* reserved for later versions */
+  for (i = 0; i < (int)(sizeof(header->reserved) / sizeof(header->reserved[0])); ++i)
+  {
+    if (header->reserved[i])
+    {
+      return 0;
+    }
+  }
+
+  file->header = header;
+  file->grid.x = header->grid_x;
+  file->grid.y = header->grid_y;
+  file->grid.z = header->grid_z;
+  file->grid.margin = mvx_v3i_init(header->margin_x, header->margin_y, header->margin_z);
+  file->grid.need = mvx_v3i_init(header->need_x, header->need_y, header->need_z);
+  file->grid.min_b = mvx_v3_init(header->min_x, header->min_y, header->min_z);
+  file->grid.vxsize = header->voxel_size;
+
+  /* the header has to describe exactly the payload that is there */
+  payload_size = mvx_file_payload_size(&file->grid, (int)header->layout, header->brick_count, &bricks_offset);
+
+  if (!payload_size || (bricks_offset >> 16) >> 16 ||
+      header->payload_size_lo != (unsigned int)(payload_size & 0xFFFFFFFFul) ||
+      header->payload_size_hi != (unsigned int)((payload_size >> 16) >> 16) ||
+      header->bricks_offset != (unsigned int)bricks_offset ||
+      data_size < header->payload_offset || data_size - header->payload_offset < payload_size)
+  {
+    return 0;
+  }
+
+  /* every brick map index entry is empty or names one of the stored bricks */
+  if (header->layout == MVX_FILE_BRICKMAP)
+  {
+    index = (unsigned int *)(bytes + header->payload_offset);
+    entries = (unsigned long)mvx_brickmap_index_count(header->grid_x, header->grid_y, header->grid_z);
+
+    for (e = 0; e < entries; ++e)
+    {
+      if (index[e] > header->brick_count)
+      {
+        return 0;
+      }
+    }
+  }
+
+  file->bytes = 0;
+  file->bits = 0;
+  file->brickmap.grid_x = header->grid_x;
+  file->brickmap.grid_y = header->grid_y;
+  file->brickmap.grid_z = header->grid_z;
+  file->brickmap.count = mvx_v3i_init(
+      (header->grid_x + MVX_BRICK_SIZE - 1) / MVX_BRICK_SIZE,
+      (header->grid_y + MVX_BRICK_SIZE - 1) / MVX_BRICK_SIZE,
+      (header->grid_z + MVX_BRICK_SIZE - 1) / MVX_BRICK_SIZE);
+  file->brickmap.index = 0;
+  file->brickmap.bricks = 0;
+  file->brickmap.brick_count = 0;
+  file->brickmap.brick_capacity = 0;
+  file->brickmap.overflow = 0;
+
+  if (header->layout == MVX_FILE_BYTES)
+  {
+    file->bytes = bytes + header->payload_offset;
+  }
+  else if (header->layout == MVX_FILE_BITS)
+  {
+    file->bits = (unsigned int *)(bytes + header->payload_offset);
+  }
+  else
+  {
+    file->brickmap.index = (unsigned int *)(bytes + header->payload_offset);
+    file->brickmap.bricks = (unsigned int *)(bytes + header->payload_offset + header->bricks_offset);
+    file->brickmap.brick_count = header->brick_count;
+    file->brickmap.brick_capacity = header->brick_count;
+  }
+
+  return 1;
+}
+
+/* #############################################################################
+ * # Voxelization Context
+ * #############################################################################
+ *
+ * One caller supplied memory block (e.g. VirtualAlloc or mmap with huge
+ * pages) that is reused as scratch memory by every call made through the
+ * context, so batch jobs do not have to size and hand in memory per call.
+ * Each call resets the context's arena and pushes the worst case scratch of
+ * that call (see the *_memory_size functions), so a too small block fails
+ * before any work. Outputs that live in the scratch memory (the brick map of
+ * the sparse variant, the rle spans, the lod levels) stay valid until the
+ * next call on the same context. mvx_context_memory_size reports the worst
+ * case bytes over the calls a batch makes.
+ */
+typedef struct mvx_context
+{
+  mvx_arena arena;
+
+} mvx_context;
+
+MVX_API MVX_INLINE void mvx_context_init(mvx_context *context, void *memory, unsigned long memory_size)
+{
+  mvx_arena_init(&context->arena, memory, memory_size);
+}
+
+/* Releases the scratch of the previous call and pushes bytes for the next one. Returns 0 if they do not fit. */
+MVX_API MVX_INLINE void *mvx_context_scratch(mvx_context *context, unsigned long bytes)
+{
+  if (!context || !bytes)
+  {
+    return 0;
+  }
+
+  mvx_arena_reset(&context->arena);
+
+  return mvx_arena_push(&context->arena, bytes);
+}
+
+/* Worst case scratch bytes of the context calls for this mesh and grid. Pass 0 for brick_size,
+ * slab_depth, svdag_capacity, with_rle, with_sdf, edt_job_count or with_lod to leave out the
+ * binned, streaming, DAG, rle, sdf, edt or lod call. 0 on invalid input.
+ */
+MVX_API MVX_INLINE unsigned long mvx_context_memory_size(
+    float *vertices, unsigned long vertices_size,
+    int *indices, unsigned long indices_size,
+    int grid_x, int grid_y, int grid_z,
+    int grid_pad_x, int grid_pad_y, int grid_pad_z,
+    int brick_size,               /* Brick size of mvx_context_voxelize_mesh_binned. */
+    int slab_depth,               /* Slab depth of mvx_context_voxelize_mesh_streaming. */
+    unsigned long svdag_capacity, /* Node pool capacity of mvx_context_voxelize_mesh_svdag. */
+    int with_rle,                 /* 1 for mvx_context_voxelize_mesh_rle. */
+    int with_sdf,                 /* 1 for mvx_context_voxelize_mesh_sdf and mvx_context_voxelize_mesh_sdf_int16. */
+    int edt_job_count,            /* Job count of mvx_context_edt (1 without dispatch). */
+    int with_lod)                 /* 1 for mvx_context_lod_build of the grid (whole chain with counts). */
+{
+  unsigned long result = mvx_voxelize_mesh_sparse_memory_size(
+      vertices, vertices_size, indices, indices_size,
+      grid_x, grid_y, grid_z, grid_pad_x, grid_pad_y, grid_pad_z);
+  unsigned long size;
+
+  if (!result)
+  {
+    return 0;
+  }
+
+  if (brick_size > 0)
+  {
+    size = mvx_voxelize_mesh_binned_memory_size(
+        vertices, vertices_size, indices, indices_size,
+        grid_x, grid_y, grid_z, grid_pad_x, grid_pad_y, grid_pad_z, brick_size);
+    result = size > result ? size : result;
+  }
+
+  if (slab_depth > 0)
+  {
+    /* the byte slab is never smaller than the bit-packed one */
+    size = mvx_voxelize_mesh_streaming_memory_size(
+        vertices, vertices_size, indices, indices_size,
+        grid_x, grid_y, grid_z, grid_pad_x, grid_pad_y, grid_pad_z, slab_depth);
+    result = size > result ? size : result;
+  }
+
+  if (svdag_capacity > 0)
+  {
+    size = mvx_voxelize_mesh_svdag_memory_size(
+        vertices, vertices_size, indices, indices_size,
+        grid_x, grid_y, grid_z, grid_pad_x, grid_pad_y, grid_pad_z, svdag_capacity);
+    result = size > result ? size : result;
+  }
+
+  if (with_rle)
+  {
+    size = mvx_voxelize_mesh_rle_memory_size(
+        vertices, vertices_size, indices, indices_size,
+        grid_x, grid_y, grid_z, grid_pad_x, grid_pad_y, grid_pad_z);
+    result = size > result ? size : result;
+  }
+
+  if (with_sdf)
+  {
+    size = mvx_voxelize_mesh_sdf_memory_size(grid_x, grid_y, grid_z);
+    result = size > result ? size : result;
+  }
+
+  if (edt_job_count > 0)
+  {
+    size = mvx_edt_memory_size(grid_x, grid_y, grid_z, edt_job_count);
+    result = size > result ? size : result;
+  }
+
+  if (with_lod)
+  {
+    size = mvx_lod_memory_size(grid_x, grid_y, grid_z, 0, 1);
+    result = size > result ? size : result;
+  }
+
+  /* the calls push their scratch through the context's arena */
+  return mvx_arena_aligned_size(result);
+}
+
+/* mvx_voxelize_mesh_binned with the context's memory */
+MVX_API MVX_INLINE int mvx_context_voxelize_mesh_binned(
+    mvx_context *context,
+    float *vertices, unsigned long vertices_size,
+    int *indices, unsigned long indices_size,
+    int grid_x, int grid_y, int grid_z,
+    int grid_pad_x, int grid_pad_y, int grid_pad_z,
+    int brick_size,
+    mvx_dispatch_function dispatch, void *dispatch_user_data,
+    unsigned char *output_voxels)
+{
+  unsigned long size = mvx_voxelize_mesh_binned_memory_size(
+      vertices, vertices_size, indices, indices_size,
+      grid_x, grid_y, grid_z, grid_pad_x, grid_pad_y, grid_pad_z, brick_size);
+  void *memory = mvx_context_scratch(context, size);
+
+  if (!memory)
+  {
+    return 0;
+  }
+
+  return mvx_voxelize_mesh_binned(
+      vertices, vertices_size, indices, indices_size,
+      grid_x, grid_y, grid_z, grid_pad_x, grid_pad_y, grid_pad_z,
+      brick_size, memory, size,
+      dispatch, dispatch_user_data, output_voxels);
+}
+
+/* mvx_voxelize_mesh_sparse with the context's memory, the brick map is valid until the next call */
+MVX_API MVX_INLINE int mvx_context_voxelize_mesh_sparse(
+    mvx_context *context,
+    float *vertices, unsigned long vertices_size,
+    int *indices, unsigned long indices_size,
+    int grid_x, int grid_y, int grid_z,
+    int grid_pad_x, int grid_pad_y, int grid_pad_z,
+    mvx_brickmap *output_brickmap)
+{
+  unsigned long size = mvx_voxelize_mesh_sparse_memory_size(
+      vertices, vertices_size, indices, indices_size,
+      grid_x, grid_y, grid_z, grid_pad_x, grid_pad_y, grid_pad_z);
+  void *memory = mvx_context_scratch(context, size);
+
+  if (!memory)
+  {
+    return 0;
+  }
+
+  return mvx_voxelize_mesh_sparse(
+      vertices, vertices_size, indices, indices_size,
+      grid_x, grid_y, grid_z, grid_pad_x, grid_pad_y, grid_pad_z,
+      memory, size, output_brickmap);
+}
+
+/* mvx_voxelize_mesh_streaming with the context's memory */
+MVX_API MVX_INLINE int mvx_context_voxelize_mesh_streaming(
+    mvx_context *context,
+    float *vertices, unsigned long vertices_size,
+    int *indices, unsigned long indices_size,
+    int grid_x, int grid_y, int grid_z,
+    int grid_pad_x, int grid_pad_y, int grid_pad_z,
+    int slab_depth,
+    mvx_slab_function callback, void *callback_user_data)
+{
+  unsigned long size = mvx_voxelize_mesh_streaming_memory_size(
+      vertices, vertices_size, indices, indices_size,
+      grid_x, grid_y, grid_z, grid_pad_x, grid_pad_y, grid_pad_z, slab_depth);
+  void *memory = mvx_context_scratch(context, size);
+
+  if (!memory)
+  {
+    return 0;
+  }
+
+  return mvx_voxelize_mesh_streaming(
+      vertices, vertices_size, indices, indices_size,
+      grid_x, grid_y, grid_z, grid_pad_x, grid_pad_y, grid_pad_z,
+      slab_depth, memory, size,
+      callback, callback_user_data);
+}
+
+/* mvx_voxelize_mesh_svdag with the context's memory */
+MVX_API MVX_INLINE int mvx_context_voxelize_mesh_svdag(
+    mvx_context *context,
+    float *vertices, unsigned long vertices_size,
+    int *indices, unsigned long indices_size,
+    int grid_x, int grid_y, int grid_z,
+    int grid_pad_x, int grid_pad_y, int grid_pad_z,
+    unsigned int *output_nodes, unsigned long output_capacity,
+    mvx_svdag *output_dag)
+{
+  unsigned long size = mvx_voxelize_mesh_svdag_memory_size(
+      vertices, vertices_size, indices, indices_size,
+      grid_x, grid_y, grid_z, grid_pad_x, grid_pad_y, grid_pad_z, output_capacity);
+  void *memory = mvx_context_scratch(context, size);
+
+  if (!memory)
+  {
+    return 0;
+  }
+
+  return mvx_voxelize_mesh_svdag(
+      vertices, vertices_size, indices, indices_size,
+      grid_x, grid_y, grid_z, grid_pad_x, grid_pad_y, grid_pad_z,
+      memory, size,
+      output_nodes, output_capacity, output_dag);
+}
+
+/* mvx_voxelize_mesh_rle with the context's memory, the spans are valid until the next call */
+MVX_API MVX_INLINE int mvx_context_voxelize_mesh_rle(
+    mvx_context *context,
+    float *vertices, unsigned long vertices_size,
+    int *indices, unsigned long indices_size,
+    int grid_x, int grid_y, int grid_z,
+    int grid_pad_x, int grid_pad_y, int grid_pad_z,
+    mvx_rle *output_rle)
+{
+  unsigned long size = mvx_voxelize_mesh_rle_memory_size(
+      vertices, vertices_size, indices, indices_size,
+      grid_x, grid_y, grid_z, grid_pad_x, grid_pad_y, grid_pad_z);
+  void *memory = mvx_context_scratch(context, size);
+
+  if (!memory)
+  {
+    return 0;
+  }
+
+  return mvx_voxelize_mesh_rle(
+      vertices, vertices_size, indices, indices_size,
+      grid_x, grid_y, grid_z, grid_pad_x, grid_pad_y, grid_pad_z,
+      memory, size, output_rle);
+}
+
+/* mvx_voxelize_mesh_sdf with the context's memory */
+MVX_API MVX_INLINE int mvx_context_voxelize_mesh_sdf(
+    mvx_context *context,
+    float *vertices, unsigned long vertices_size,
+    int *indices, unsigned long indices_size,
+    int grid_x, int grid_y, int grid_z,
+    int grid_pad_x, int grid_pad_y, int grid_pad_z,
+    int band,
+    mvx_dispatch_function dispatch, void *dispatch_user_data, int job_count,
+    float *output_distances)
+{
+  unsigned long size = mvx_voxelize_mesh_sdf_memory_size(grid_x, grid_y, grid_z);
+  void *memory = mvx_context_scratch(context, size);
+
+  if (!memory)
+  {
+    return 0;
+  }
+
+  return mvx_voxelize_mesh_sdf(
+      vertices, vertices_size, indices, indices_size,
+      grid_x, grid_y, grid_z, grid_pad_x, grid_pad_y, grid_pad_z,
+      band, memory, size, dispatch, dispatch_user_data, job_count, output_distances);
+}
+
+/* mvx_voxelize_mesh_sdf_int16 with the context's memory */
+MVX_API MVX_INLINE int mvx_context_voxelize_mesh_sdf_int16(
+    mvx_context *context,
+    float *vertices, unsigned long vertices_size,
+    int *indices, unsigned long indices_size,
+    int grid_x, int grid_y, int grid_z,
+    int grid_pad_x, int grid_pad_y, int grid_pad_z,
+    int band,
+    mvx_dispatch_function dispatch, void *dispatch_user_data, int job_count,
+    short *output_distances)
+{
+  unsigned long size = mvx_voxelize_mesh_sdf_memory_size(grid_x, grid_y, grid_z);
+  void *memory = mvx_context_scratch(context, size);
+
+  if (!memory)
+  {
+    return 0;
+  }
+
+  return mvx_voxelize_mesh_sdf_int16(
+      vertices, vertices_size, indices, indices_size,
+      grid_x, grid_y, grid_z, grid_pad_x, grid_pad_y, grid_pad_z,
+      band, memory, size, dispatch, dispatch_user_data, job_count, output_distances);
+}
+
+/* mvx_edt with the context's memory */
+MVX_API MVX_INLINE int mvx_context_edt(
+    mvx_context *context,
+    unsigned char *voxels,
+    int grid_x, int grid_y, int grid_z,
+    mvx_dispatch_function dispatch, void *dispatch_user_data, int job_count,
+    float *output_distances)
+{
+  unsigned long size = mvx_edt_memory_size(grid_x, grid_y, grid_z, dispatch ? job_count : 1);
+  void *memory = mvx_context_scratch(context, size);
+
+  if (!memory)
+  {
+    return 0;
+  }
+
+  return mvx_edt(voxels, grid_x, grid_y, grid_z, memory, size, dispatch, dispatch_user_data, job_count, output_distances);
+}
+
+/* mvx_lod_build with the context's memory, the levels are valid until the next call */
+MVX_API MVX_INLINE int mvx_context_lod_build(
+    mvx_context *context,
+    unsigned int *bits, int grid_x, int grid_y, int grid_z,
+    int level_count,
+    int with_counts,
+    mvx_lod *lod)
+{
+  unsigned long size = mvx_lod_memory_size(grid_x, grid_y, grid_z, level_count, with_counts);
+  void *memory = mvx_context_scratch(context, size);
+
+  /* a single level needs no memory */
+  if (!context || (!memory && size))
+  {
+    return 0;
+  }
+
+  return mvx_lod_build(bits, grid_x, grid_y, grid_z, level_count, with_counts, memory, size, lod);
+}
+
 #endif /* MVX_H */
 
 /*
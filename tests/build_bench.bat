@@ -0,0 +1,8 @@
+@echo off
+
+set DEF_FLAGS_COMPILER=-std=c89 -pedantic -Wall -Wextra -Werror -Wvla -Wconversion -Wdouble-promotion -Wsign-conversion -Wuninitialized -Winit-self -Wunused -Wunused-macros -Wunused-local-typedefs
+set DEF_FLAGS_LINKER=
+set SOURCE_NAME=mvx_bench
+
+cc -s -O2 -march=native %DEF_FLAGS_COMPILER% -o %SOURCE_NAME%.exe %SOURCE_NAME%.c %DEF_FLAGS_LINKER%
+%SOURCE_NAME%.exe 10000000 1024 mvx_bench.json
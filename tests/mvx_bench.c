@@ -0,0 +1,498 @@
+/* mvx_bench.c - throughput benchmark for mvx.h - nickscha 2025
+
+A hosted C89 program (stdio, stdlib and time) that measures the mesh voxelizer (MVX).
+
+This benchmark voxelizes subdivided icospheres and random triangle soups (1K to 10M triangles)
+into bit-packed grids from 32^3 to 1024^3 and reports triangles/s, candidate voxels/s (the plane
+band voxels the sweep visits) and ns per candidate voxel (whole call time divided by the candidates).
+Time is taken with the cpu cycle counter (rdtsc), calibrated once against clock().
+
+USAGE
+    mvx_bench [max_triangles] [max_grid] [json_file]
+
+    Prints one CSV row per mesh and grid size. If json_file is given the same results are
+    written there as a JSON summary that can be tracked over releases.
+
+LICENSE
+
+  Placed in the public domain and also MIT licensed.
+  See end of file for detailed license information.
+
+*/
+#include "../mvx.h" /* Mesh Voxelizer */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+/* #############################################################################
+ * # Cycle Counter
+ * #############################################################################
+ */
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#include <intrin.h>
+static double mvx_bench_cycles(void)
+{
+  return (double)__rdtsc();
+}
+#elif (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+static double mvx_bench_cycles(void)
+{
+  unsigned int lo, hi;
+  __asm__ __volatile__("rdtsc" : "=a"(lo), "=d"(hi));
+  return (double)hi * 4294967296.0 + (double)lo;
+}
+#else
+/* no cycle counter: clock() ticks scaled to "cycles" of one nanosecond */
+static double mvx_bench_cycles(void)
+{
+  return (double)clock() * (1e9 / (double)CLOCKS_PER_SEC);
+}
+#endif
+
+/* Cycles per nanosecond, measured over ~200ms of clock() */
+static double mvx_bench_calibrate(void)
+{
+  clock_t start = clock();
+  clock_t end;
+  double c0 = mvx_bench_cycles();
+  double c1;
+
+  do
+  {
+    end = clock();
+  } while ((double)(end - start) < 0.2 * (double)CLOCKS_PER_SEC);
+
+  c1 = mvx_bench_cycles();
+
+  return (c1 - c0) / ((double)(end - start) * (1e9 / (double)CLOCKS_PER_SEC));
+}
+
+/* #############################################################################
+ * # Mesh Generators
+ * #############################################################################
+ */
+typedef struct mvx_bench_mesh
+{
+  char *name;
+  float *vertices;
+  unsigned long vertices_size;
+  int *indices;
+  unsigned long indices_size;
+
+} mvx_bench_mesh;
+
+static unsigned int mvx_bench_seed = 12345u;
+
+static float mvx_bench_random(void)
+{
+  mvx_bench_seed = mvx_bench_seed * 1664525u + 1013904223u;
+  return (float)(mvx_bench_seed >> 8) / 16777216.0f;
+}
+
+static float mvx_bench_sqrtf(float v)
+{
+  float r = v > 1.0f ? v : 1.0f;
+  int i;
+
+  if (v <= 0.0f)
+  {
+    return 0.0f;
+  }
+
+  for (i = 0; i < 16; ++i)
+  {
+    r = 0.5f * (r + v / r);
+  }
+
+  return r;
+}
+
+static mvx_v3 mvx_bench_normalize(mvx_v3 v)
+{
+  return mvx_v3_scale(v, 1.0f / mvx_bench_sqrtf(mvx_v3_dot(v, v)));
+}
+
+static int mvx_bench_mesh_alloc(mvx_bench_mesh *mesh, char *name, unsigned long triangles)
+{
+  unsigned long i;
+
+  mesh->name = name;
+  mesh->vertices_size = triangles * 9;
+  mesh->indices_size = triangles * 3;
+  mesh->vertices = (float *)malloc(mesh->vertices_size * sizeof(float));
+  mesh->indices = (int *)malloc(mesh->indices_size * sizeof(int));
+
+  if (!mesh->vertices || !mesh->indices)
+  {
+    free(mesh->vertices);
+    free(mesh->indices);
+    return 0;
+  }
+
+  /* triangle soup layout: every triangle owns its three vertices */
+  for (i = 0; i < mesh->indices_size; ++i)
+  {
+    mesh->indices[i] = (int)i;
+  }
+
+  return 1;
+}
+
+static void mvx_bench_mesh_free(mvx_bench_mesh *mesh)
+{
+  free(mesh->vertices);
+  free(mesh->indices);
+}
+
+static void mvx_bench_store(float *p, mvx_v3 v)
+{
+  p[0] = v.x;
+  p[1] = v.y;
+  p[2] = v.z;
+}
+
+/* Icosahedron subdivided level times (20 * 4^level triangles) with the vertices on the unit sphere */
+static int mvx_bench_icosphere(mvx_bench_mesh *mesh, int level)
+{
+  /* unit length icosahedron vertices */
+  float ico_vertices[] = {
+      -0.525731f, 0.850651f, 0.0f,
+      0.525731f, 0.850651f, 0.0f,
+      -0.525731f, -0.850651f, 0.0f,
+      0.525731f, -0.850651f, 0.0f,
+      0.0f, -0.525731f, 0.850651f,
+      0.0f, 0.525731f, 0.850651f,
+      0.0f, -0.525731f, -0.850651f,
+      0.0f, 0.525731f, -0.850651f,
+      0.850651f, 0.0f, -0.525731f,
+      0.850651f, 0.0f, 0.525731f,
+      -0.850651f, 0.0f, -0.525731f,
+      -0.850651f, 0.0f, 0.525731f};
+  int ico_indices[] = {
+      0, 11, 5, 0, 5, 1, 0, 1, 7, 0, 7, 10, 0, 10, 11,
+      1, 5, 9, 5, 11, 4, 11, 10, 2, 10, 7, 6, 7, 1, 8,
+      3, 9, 4, 3, 4, 2, 3, 2, 6, 3, 6, 8, 3, 8, 9,
+      4, 9, 5, 2, 4, 11, 6, 2, 10, 8, 6, 7, 9, 8, 1};
+  unsigned long count = 20;
+  unsigned long i;
+  int l;
+
+  for (l = 0; l < level; ++l)
+  {
+    count *= 4;
+  }
+
+  if (!mvx_bench_mesh_alloc(mesh, "icosphere", count))
+  {
+    return 0;
+  }
+
+  for (i = 0; i < 20; ++i)
+  {
+    for (l = 0; l < 3; ++l)
+    {
+      float *v = ico_vertices + 3 * ico_indices[3 * i + (unsigned long)l];
+      mvx_bench_store(mesh->vertices + 9 * i + 3 * (unsigned long)l, mvx_v3_init(v[0], v[1], v[2]));
+    }
+  }
+
+  /* split every triangle into 4 in place, back to front */
+  for (count = 20, l = 0; l < level; ++l, count *= 4)
+  {
+    i = count;
+
+    while (i-- > 0)
+    {
+      float *src = mesh->vertices + 9 * i;
+      mvx_v3 a = mvx_v3_init(src[0], src[1], src[2]);
+      mvx_v3 b = mvx_v3_init(src[3], src[4], src[5]);
+      mvx_v3 c = mvx_v3_init(src[6], src[7], src[8]);
+      mvx_v3 ab = mvx_bench_normalize(mvx_v3_add(a, b));
+      mvx_v3 bc = mvx_bench_normalize(mvx_v3_add(b, c));
+      mvx_v3 ca = mvx_bench_normalize(mvx_v3_add(c, a));
+      float *dst = mesh->vertices + 36 * i;
+
+      mvx_bench_store(dst + 0, a);
+      mvx_bench_store(dst + 3, ab);
+      mvx_bench_store(dst + 6, ca);
+      mvx_bench_store(dst + 9, ab);
+      mvx_bench_store(dst + 12, b);
+      mvx_bench_store(dst + 15, bc);
+      mvx_bench_store(dst + 18, ca);
+      mvx_bench_store(dst + 21, bc);
+      mvx_bench_store(dst + 24, c);
+      mvx_bench_store(dst + 27, ab);
+      mvx_bench_store(dst + 30, bc);
+      mvx_bench_store(dst + 33, ca);
+    }
+  }
+
+  return 1;
+}
+
+/* Random small triangles (edge up to 1/32 of the box) spread over the unit cube */
+static int mvx_bench_soup(mvx_bench_mesh *mesh, unsigned long triangles)
+{
+  unsigned long i;
+  int k;
+
+  if (!mvx_bench_mesh_alloc(mesh, "soup", triangles))
+  {
+    return 0;
+  }
+
+  for (i = 0; i < triangles; ++i)
+  {
+    mvx_v3 c = mvx_v3_init(mvx_bench_random(), mvx_bench_random(), mvx_bench_random());
+
+    for (k = 0; k < 3; ++k)
+    {
+      mvx_v3 d = mvx_v3_init(mvx_bench_random() - 0.5f, mvx_bench_random() - 0.5f, mvx_bench_random() - 0.5f);
+      mvx_bench_store(mesh->vertices + 9 * i + 3 * (unsigned long)k, mvx_v3_add(c, mvx_v3_scale(d, 1.0f / 32.0f)));
+    }
+  }
+
+  return 1;
+}
+
+/* #############################################################################
+ * # Benchmark
+ * #############################################################################
+ */
+typedef struct mvx_bench_result
+{
+  char *mesh;
+  unsigned long triangles;
+  int grid;
+  double ns;
+  double candidates; /* voxels the sweep visits (plane band of every triangle), each one gets at most one overlap test */
+  double occupied;
+
+} mvx_bench_result;
+
+/* Candidate voxels the sweep visits (the plane band of every triangle in the fitted grid) */
+static double mvx_bench_candidates(mvx_bench_mesh *mesh, int grid_size)
+{
+  mvx_grid grid;
+  mvx_mesh m = mvx_mesh_init(mesh->vertices, mesh->vertices_size, mesh->indices, mesh->indices_size);
+  mvx_v3i clip_min = mvx_v3i_init(0, 0, 0);
+  mvx_v3i clip_max = mvx_v3i_init(grid_size - 1, grid_size - 1, grid_size - 1);
+  unsigned long t;
+  double result = 0.0;
+
+  mvx_grid_fit(&grid, mesh->vertices, mesh->vertices_size, grid_size, grid_size, grid_size, 1, 1, 1);
+
+  for (t = 0; t < mvx_mesh_triangle_count(&m); ++t)
+  {
+    mvx_v3 v0, v1, v2;
+
+    if (mvx_mesh_triangle(&m, t, &v0, &v1, &v2))
+    {
+      result += (double)mvx_voxelize_triangle_candidates(&grid, v0, v1, v2, clip_min, clip_max);
+    }
+  }
+
+  return result;
+}
+
+static double mvx_bench_popcount(unsigned int *bits, unsigned long words)
+{
+  double result = 0.0;
+  unsigned long i;
+
+  for (i = 0; i < words; ++i)
+  {
+    unsigned int w = bits[i];
+
+    while (w)
+    {
+      w &= w - 1;
+      result += 1.0;
+    }
+  }
+
+  return result;
+}
+
+/* Best of a few runs (at least 3 and ~0.5s) */
+static int mvx_bench_run(mvx_bench_mesh *mesh, int grid_size, unsigned int *bits, double cycles_per_ns, mvx_bench_result *result)
+{
+  double best = 0.0;
+  double total = 0.0;
+  int runs = 0;
+
+  while (runs < 3 || (total < 0.5e9 && runs < 100))
+  {
+    double c0 = mvx_bench_cycles();
+    double ns;
+
+    if (!mvx_voxelize_mesh_bits(mesh->vertices, mesh->vertices_size, mesh->indices, mesh->indices_size,
+                                grid_size, grid_size, grid_size, 1, 1, 1, bits))
+    {
+      return 0;
+    }
+
+    ns = (mvx_bench_cycles() - c0) / cycles_per_ns;
+    best = runs == 0 || ns < best ? ns : best;
+    total += ns;
+    ++runs;
+  }
+
+  result->mesh = mesh->name;
+  result->triangles = mesh->indices_size / 3;
+  result->grid = grid_size;
+  result->ns = best;
+  result->candidates = mvx_bench_candidates(mesh, grid_size);
+  result->occupied = mvx_bench_popcount(bits, (unsigned long)mvx_bits_size(grid_size, grid_size, grid_size));
+
+  return 1;
+}
+
+static void mvx_bench_print(mvx_bench_result *r)
+{
+  double seconds = r->ns * 1e-9;
+
+  printf("%s,%lu,%d,%.3f,%.0f,%.0f,%.0f,%.3f,%.0f\n",
+         r->mesh, r->triangles, r->grid, r->ns * 1e-6,
+         (double)r->triangles / seconds, r->candidates, r->candidates / seconds,
+         r->candidates > 0.0 ? r->ns / r->candidates : 0.0, r->occupied);
+}
+
+static void mvx_bench_write_json(char *path, mvx_bench_result *results, int count, double cycles_per_ns)
+{
+  FILE *file = fopen(path, "w");
+  int i;
+
+  if (!file)
+  {
+    fprintf(stderr, "mvx_bench: cannot write %s\n", path);
+    return;
+  }
+
+  fprintf(file, "{\n  \"cycles_per_ns\": %.4f,\n  \"results\": [\n", cycles_per_ns);
+
+  for (i = 0; i < count; ++i)
+  {
+    mvx_bench_result *r = results + i;
+    double seconds = r->ns * 1e-9;
+
+    fprintf(file,
+            "    {\"mesh\": \"%s\", \"triangles\": %lu, \"grid\": %d, \"ms\": %.3f, \"triangles_per_s\": %.0f, "
+            "\"candidate_voxels\": %.0f, \"candidate_voxels_per_s\": %.0f, \"ns_per_candidate_voxel\": %.3f, \"occupied_voxels\": %.0f}%s\n",
+            r->mesh, r->triangles, r->grid, r->ns * 1e-6, (double)r->triangles / seconds,
+            r->candidates, r->candidates / seconds, r->candidates > 0.0 ? r->ns / r->candidates : 0.0,
+            r->occupied, i + 1 < count ? "," : "");
+  }
+
+  fprintf(file, "  ]\n}\n");
+  fclose(file);
+}
+
+#define MVX_BENCH_MAX_RESULTS 128
+
+int main(int argc, char **argv)
+{
+  static mvx_bench_result results[MVX_BENCH_MAX_RESULTS];
+  unsigned long soup_sizes[] = {1000ul, 10000ul, 100000ul, 1000000ul, 10000000ul};
+  unsigned long max_triangles = argc > 1 ? strtoul(argv[1], 0, 10) : 10000000ul;
+  int max_grid = argc > 2 ? atoi(argv[2]) : 1024;
+  char *json_path = argc > 3 ? argv[3] : 0;
+  double cycles_per_ns = mvx_bench_calibrate();
+  unsigned int *bits = (unsigned int *)malloc((unsigned long)mvx_bits_size(max_grid, max_grid, max_grid) * sizeof(unsigned int));
+  int count = 0;
+  int pass, level, grid, i;
+
+  if (!bits)
+  {
+    fprintf(stderr, "mvx_bench: out of memory for a %d^3 grid\n", max_grid);
+    return 1;
+  }
+
+  printf("mesh,triangles,grid,ms,triangles_per_s,candidate_voxels,candidate_voxels_per_s,ns_per_candidate_voxel,occupied_voxels\n");
+
+  /* pass 0: icospheres of 1280 .. 5M triangles, pass 1: soups of 1K .. 10M triangles */
+  for (pass = 0; pass < 2; ++pass)
+  {
+    for (i = 0; i < (pass ? 5 : 7); ++i)
+    {
+      mvx_bench_mesh mesh;
+
+      level = 3 + i;
+
+      if (pass ? soup_sizes[i] > max_triangles : (20ul << (2 * level)) > max_triangles)
+      {
+        break;
+      }
+
+      if (pass ? !mvx_bench_soup(&mesh, soup_sizes[i]) : !mvx_bench_icosphere(&mesh, level))
+      {
+        fprintf(stderr, "mvx_bench: out of memory for the mesh\n");
+        break;
+      }
+
+      for (grid = 32; grid <= max_grid && count < MVX_BENCH_MAX_RESULTS; grid *= 2)
+      {
+        if (mvx_bench_run(&mesh, grid, bits, cycles_per_ns, results + count))
+        {
+          mvx_bench_print(results + count);
+          fflush(stdout);
+          ++count;
+        }
+      }
+
+      mvx_bench_mesh_free(&mesh);
+    }
+  }
+
+  if (json_path)
+  {
+    mvx_bench_write_json(json_path, results, count, cycles_per_ns);
+  }
+
+  free(bits);
+
+  return 0;
+}
+
+/*
+   ------------------------------------------------------------------------------
+   This software is available under 2 licenses -- choose whichever you prefer.
+   ------------------------------------------------------------------------------
+   ALTERNATIVE A - MIT License
+   Copyright (c) 2025 nickscha
+   Permission is hereby granted, free of charge, to any person obtaining a copy of
+   this software and associated documentation files (the "Software"), to deal in
+   the Software without restriction, including without limitation the rights to
+   use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+   of the Software, and to permit persons to whom the Software is furnished to do
+   so, subject to the following conditions:
+   The above copyright notice and this permission notice shall be included in all
+   copies or substantial portions of the Software.
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+   AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+   LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+   OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+   SOFTWARE.
+   ------------------------------------------------------------------------------
+   ALTERNATIVE B - Public Domain (www.unlicense.org)
+   This is free and unencumbered software released into the public domain.
+   Anyone is free to copy, modify, publish, use, compile, sell, or distribute this
+   software, either in source code form or as a compiled binary, for any purpose,
+   commercial or non-commercial, and by any means.
+   In jurisdictions that recognize copyright laws, the author or authors of this
+   software dedicate any and all copyright interest in the software to the public
+   domain. We make this dedication for the benefit of the public at large and to
+   the detriment of our heirs and successors. We intend this dedication to be an
+   overt act of relinquishment in perpetuity of all present and future rights to
+   this software under copyright law.
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+   AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+   ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+   WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+   ------------------------------------------------------------------------------
+*/
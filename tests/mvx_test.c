@@ -225,11 +225,1761 @@ void mvx_test_voxelize_pyramid(void)
   mvx_test_print_voxels(voxels, py_grid_x, py_grid_y, py_grid_z);
 }
 
+/* Fixtures shared by the tests below: the unit cube and the pyramid above */
+static float cube_vertices[] = {
+    0.0f, 0.0f, 0.0f,
+    1.0f, 0.0f, 0.0f,
+    1.0f, 1.0f, 0.0f,
+    0.0f, 1.0f, 0.0f,
+    0.0f, 0.0f, 1.0f,
+    1.0f, 0.0f, 1.0f,
+    1.0f, 1.0f, 1.0f,
+    0.0f, 1.0f, 1.0f};
+
+static int cube_indices[] = {
+    0, 1, 2, 0, 2, 3,
+    4, 5, 6, 4, 6, 7,
+    0, 1, 5, 0, 5, 4,
+    1, 2, 6, 1, 6, 5,
+    2, 3, 7, 2, 7, 6,
+    3, 0, 4, 3, 4, 7};
+
+static float pyramid_vertices[] = {
+    -0.5f, 0.0f, -0.5f,
+    0.5f, 0.0f, -0.5f,
+    0.5f, 0.0f, 0.5f,
+    -0.5f, 0.0f, 0.5f,
+    0.0f, 1.0f, 0.0f};
+
+static int pyramid_indices[] = {
+    0, 1, 2, 0, 2, 3,
+    0, 1, 4, 1, 2, 4, 2, 3, 4, 3, 0, 4};
+
+void mvx_test_voxelize_bits(void)
+{
+  unsigned long vertices_size = sizeof(pyramid_vertices) / sizeof(pyramid_vertices[0]);
+  unsigned long indices_size = sizeof(pyramid_indices) / sizeof(pyramid_indices[0]);
+
+#define bits_grid_x 37
+#define bits_grid_y 21
+#define bits_grid_z 21
+  unsigned char voxels[bits_grid_x * bits_grid_y * bits_grid_z];
+  unsigned int bits[2 * bits_grid_y * bits_grid_z];
+
+  int x, y, z;
+  int mismatches = 0;
+  int occupied = 0;
+  int padding_set = 0;
+
+  assert(mvx_bits_row_words(bits_grid_x) == 2);
+  assert(mvx_bits_size(bits_grid_x, bits_grid_y, bits_grid_z) == 2 * bits_grid_y * bits_grid_z);
+
+  assert(mvx_voxelize_mesh(pyramid_vertices, vertices_size, pyramid_indices, indices_size, bits_grid_x, bits_grid_y, bits_grid_z, 1, 1, 1, voxels));
+  assert(mvx_voxelize_mesh_bits(pyramid_vertices, vertices_size, pyramid_indices, indices_size, bits_grid_x, bits_grid_y, bits_grid_z, 1, 1, 1, bits));
+
+  for (z = 0; z < bits_grid_z; ++z)
+  {
+    for (y = 0; y < bits_grid_y; ++y)
+    {
+      for (x = 0; x < bits_grid_x; ++x)
+      {
+        int v = voxels[x + y * bits_grid_x + z * bits_grid_x * bits_grid_y];
+        occupied += v;
+        mismatches += v != mvx_bits_get(bits, bits_grid_x, bits_grid_y, x, y, z);
+      }
+      padding_set += (bits[(y + z * bits_grid_y) * 2 + 1] >> (bits_grid_x - 32)) != 0;
+    }
+  }
+
+  assert(occupied > 0);
+  assert(mismatches == 0);
+  assert(padding_set == 0);
+}
+
+void mvx_test_voxelize_solid(void)
+{
+#define solid_grid 16
+  unsigned char surface[solid_grid * solid_grid * solid_grid];
+  unsigned char solid[solid_grid * solid_grid * solid_grid];
+  unsigned int solid_bits[solid_grid * solid_grid];
+
+  int x, y, z;
+  int missing_surface = 0;
+  int mismatches = 0;
+  int surface_count = 0;
+  int solid_count = 0;
+  int broken_rows = 0;
+
+  /* cube: every voxel inside the surface hull has to be filled */
+  assert(mvx_voxelize_mesh(cube_vertices, 24, cube_indices, 36, solid_grid, solid_grid, solid_grid, 2, 2, 2, surface));
+  assert(mvx_voxelize_mesh_solid(cube_vertices, 24, cube_indices, 36, solid_grid, solid_grid, solid_grid, 2, 2, 2, solid));
+
+  for (x = 0; x < solid_grid * solid_grid * solid_grid; ++x)
+  {
+    surface_count += surface[x];
+    solid_count += solid[x];
+  }
+
+  assert(surface_count == 12 * 12 * 12 - 10 * 10 * 10);
+  assert(solid_count == 12 * 12 * 12);
+
+  /* pyramid: convex, so every row is one contiguous run that contains the surface */
+  surface_count = solid_count = 0;
+
+  assert(mvx_voxelize_mesh(pyramid_vertices, 15, pyramid_indices, 18, solid_grid, solid_grid, solid_grid, 1, 1, 1, surface));
+  assert(mvx_voxelize_mesh_solid(pyramid_vertices, 15, pyramid_indices, 18, solid_grid, solid_grid, solid_grid, 1, 1, 1, solid));
+  assert(mvx_voxelize_mesh_solid_bits(pyramid_vertices, 15, pyramid_indices, 18, solid_grid, solid_grid, solid_grid, 1, 1, 1, solid_bits));
+
+  for (z = 0; z < solid_grid; ++z)
+  {
+    for (y = 0; y < solid_grid; ++y)
+    {
+      int runs = 0;
+      int prev = 0;
+
+      for (x = 0; x < solid_grid; ++x)
+      {
+        int id = x + y * solid_grid + z * solid_grid * solid_grid;
+
+        missing_surface += surface[id] && !solid[id];
+        mismatches += solid[id] != mvx_bits_get(solid_bits, solid_grid, solid_grid, x, y, z);
+        runs += solid[id] && !prev;
+        prev = solid[id];
+        surface_count += surface[id];
+        solid_count += solid[id];
+      }
+
+      broken_rows += runs > 1;
+    }
+  }
+
+  assert(missing_surface == 0);
+  assert(mismatches == 0);
+  assert(broken_rows == 0);
+  assert(solid_count > surface_count);
+
+  /* bricks, counts and spans have no parity pass */
+  assert(!mvx_voxelize_mesh_target(pyramid_vertices, 15, pyramid_indices, 18, solid_grid, solid_grid, solid_grid, 1, 1, 1, 1, mvx_target_init(MVX_TARGET_BRICKMAP)));
+  assert(!mvx_voxelize_mesh_target(pyramid_vertices, 15, pyramid_indices, 18, solid_grid, solid_grid, solid_grid, 1, 1, 1, 1, mvx_target_init(MVX_TARGET_COUNTS)));
+  assert(!mvx_voxelize_mesh_target(pyramid_vertices, 15, pyramid_indices, 18, solid_grid, solid_grid, solid_grid, 1, 1, 1, 1, mvx_target_init(MVX_TARGET_SPANS)));
+}
+
+static unsigned int mvx_test_seed = 12345u;
+
+float mvx_test_random(void)
+{
+  mvx_test_seed = mvx_test_seed * 1664525u + 1013904223u;
+  return (float)(mvx_test_seed >> 8) / 16777216.0f;
+}
+
+void mvx_test_triangle_setup(void)
+{
+  int mismatches = 0;
+  int hits = 0;
+  int k, x, y, z;
+  float h = 1.0f / 16.0f;
+  mvx_v3 boxh = mvx_v3_init(h, h, h);
+
+  for (k = 0; k < 200; ++k)
+  {
+    mvx_triangle_setup setup;
+    mvx_v3 v0 = mvx_v3_init(mvx_test_random(), mvx_test_random(), mvx_test_random());
+    mvx_v3 v1 = mvx_v3_init(mvx_test_random(), mvx_test_random(), mvx_test_random());
+    mvx_v3 v2 = mvx_v3_init(mvx_test_random(), mvx_test_random(), mvx_test_random());
+
+    /* axis aligned triangles on voxel faces (touching cases) */
+    if (k % 4 == 0)
+    {
+      v0.z = v1.z = v2.z = 0.25f;
+    }
+
+    mvx_triangle_setup_init(&setup, v0, v1, v2, boxh);
+
+    for (z = 0; z < 8; ++z)
+    {
+      for (y = 0; y < 8; ++y)
+      {
+        for (x = 0; x < 8; ++x)
+        {
+          mvx_v3 boxc = mvx_v3_init(((float)x + 0.5f) * 2.0f * h, ((float)y + 0.5f) * 2.0f * h, ((float)z + 0.5f) * 2.0f * h);
+
+          int reference = mvx_point_in_box_eps_world(v0, boxc, boxh, 1e-6f) ||
+                          mvx_point_in_box_eps_world(v1, boxc, boxh, 1e-6f) ||
+                          mvx_point_in_box_eps_world(v2, boxc, boxh, 1e-6f) ||
+                          mvx_triangle_box_overlap(boxc, boxh, v0, v1, v2);
+
+          hits += reference;
+          mismatches += reference != mvx_triangle_setup_overlap(&setup, boxc);
+        }
+      }
+    }
+  }
+
+  assert(hits > 0);
+  assert(mismatches == 0);
+}
+
+/* Runs the jobs on the calling thread in reverse order to show that they are independent */
+void mvx_test_dispatch_reverse(void *user_data, mvx_job_function job, void *job_data, int job_count)
+{
+  int i;
+
+  for (i = job_count - 1; i >= 0; --i)
+  {
+    job(job_data, i);
+  }
+
+  *(int *)user_data += job_count;
+}
+
+void mvx_test_voxelize_parallel(void)
+{
+#define par_grid 24
+  unsigned char reference[par_grid * par_grid * par_grid];
+  unsigned char voxels[par_grid * par_grid * par_grid];
+  unsigned int reference_bits[par_grid * par_grid];
+  unsigned int bits[par_grid * par_grid];
+
+  int job_counts[] = {1, 3, 7, 100};
+  int jobs_run = 0;
+  int i, q;
+
+  assert(mvx_voxelize_mesh(pyramid_vertices, 15, pyramid_indices, 18, par_grid, par_grid, par_grid, 1, 1, 1, reference));
+  assert(mvx_voxelize_mesh_bits(pyramid_vertices, 15, pyramid_indices, 18, par_grid, par_grid, par_grid, 1, 1, 1, reference_bits));
+
+  for (i = 0; i < (int)(sizeof(job_counts) / sizeof(job_counts[0])); ++i)
+  {
+    int mismatches = 0;
+
+    /* leftovers from a previous run have to be cleared by the jobs */
+    for (q = 0; q < par_grid * par_grid * par_grid; ++q)
+    {
+      voxels[q] = 1;
+    }
+    for (q = 0; q < par_grid * par_grid; ++q)
+    {
+      bits[q] = ~0u;
+    }
+
+    jobs_run = 0;
+    assert(mvx_voxelize_mesh_parallel(pyramid_vertices, 15, pyramid_indices, 18, par_grid, par_grid, par_grid, 1, 1, 1, mvx_test_dispatch_reverse, &jobs_run, job_counts[i], voxels));
+    assert(jobs_run == (job_counts[i] < par_grid ? job_counts[i] : par_grid));
+    assert(mvx_voxelize_mesh_parallel_bits(pyramid_vertices, 15, pyramid_indices, 18, par_grid, par_grid, par_grid, 1, 1, 1, mvx_test_dispatch_reverse, &jobs_run, job_counts[i], bits));
+
+    for (q = 0; q < par_grid * par_grid * par_grid; ++q)
+    {
+      mismatches += voxels[q] != reference[q];
+    }
+    for (q = 0; q < par_grid * par_grid; ++q)
+    {
+      mismatches += bits[q] != reference_bits[q];
+    }
+
+    assert(mismatches == 0);
+  }
+
+  assert(!mvx_voxelize_mesh_parallel(pyramid_vertices, 15, pyramid_indices, 18, par_grid, par_grid, par_grid, 1, 1, 1, mvx_test_dispatch_reverse, &jobs_run, 0, voxels));
+}
+
+void mvx_test_voxelize_binned(void)
+{
+#define bin_grid 20
+  unsigned char reference[bin_grid * bin_grid * bin_grid];
+  unsigned char voxels[bin_grid * bin_grid * bin_grid];
+  unsigned int reference_bits[bin_grid * bin_grid];
+  unsigned int bits[bin_grid * bin_grid];
+  unsigned long memory[1024];
+
+  int brick_sizes[] = {4, 8, 16};
+  int jobs_run = 0;
+  int i, q;
+
+  assert(mvx_voxelize_mesh(pyramid_vertices, 15, pyramid_indices, 18, bin_grid, bin_grid, bin_grid, 1, 1, 1, reference));
+  assert(mvx_voxelize_mesh_bits(pyramid_vertices, 15, pyramid_indices, 18, bin_grid, bin_grid, bin_grid, 1, 1, 1, reference_bits));
+
+  for (i = 0; i < (int)(sizeof(brick_sizes) / sizeof(brick_sizes[0])); ++i)
+  {
+    unsigned long memory_size = mvx_voxelize_mesh_binned_memory_size(pyramid_vertices, 15, pyramid_indices, 18, bin_grid, bin_grid, bin_grid, 1, 1, 1, brick_sizes[i]);
+    int mismatches = 0;
+
+    assert(memory_size > 0 && memory_size <= sizeof(memory));
+
+    /* too small scratch memory is reported */
+    assert(!mvx_voxelize_mesh_binned(pyramid_vertices, 15, pyramid_indices, 18, bin_grid, bin_grid, bin_grid, 1, 1, 1, brick_sizes[i], memory, memory_size - 1, 0, 0, voxels));
+
+    assert(mvx_voxelize_mesh_binned(pyramid_vertices, 15, pyramid_indices, 18, bin_grid, bin_grid, bin_grid, 1, 1, 1, brick_sizes[i], memory, memory_size, 0, 0, voxels));
+    assert(mvx_voxelize_mesh_binned_bits(pyramid_vertices, 15, pyramid_indices, 18, bin_grid, bin_grid, bin_grid, 1, 1, 1, brick_sizes[i], memory, memory_size, mvx_test_dispatch_reverse, &jobs_run, bits));
+
+    for (q = 0; q < bin_grid * bin_grid * bin_grid; ++q)
+    {
+      mismatches += voxels[q] != reference[q];
+    }
+    for (q = 0; q < bin_grid * bin_grid; ++q)
+    {
+      mismatches += bits[q] != reference_bits[q];
+    }
+
+    assert(mismatches == 0);
+  }
+}
+
+void mvx_test_voxelize_sparse(void)
+{
+#define sparse_grid_x 37
+#define sparse_grid_y 21
+#define sparse_grid_z 21
+  unsigned char reference[sparse_grid_x * sparse_grid_y * sparse_grid_z];
+  unsigned char occupied_bricks[5 * 3 * 3];
+  unsigned long memory[2048];
+  unsigned long memory_size;
+  mvx_brickmap map;
+
+  int x, y, z;
+  int mismatches = 0;
+  unsigned int expected_bricks = 0;
+
+  assert(mvx_voxelize_mesh(pyramid_vertices, 15, pyramid_indices, 18, sparse_grid_x, sparse_grid_y, sparse_grid_z, 1, 1, 1, reference));
+
+  memory_size = mvx_voxelize_mesh_sparse_memory_size(pyramid_vertices, 15, pyramid_indices, 18, sparse_grid_x, sparse_grid_y, sparse_grid_z, 1, 1, 1);
+  assert(memory_size > 0 && memory_size <= sizeof(memory));
+
+  /* index fits, bricks do not */
+  assert(!mvx_voxelize_mesh_sparse(pyramid_vertices, 15, pyramid_indices, 18, sparse_grid_x, sparse_grid_y, sparse_grid_z, 1, 1, 1, memory, (unsigned long)(5 * 3 * 3 * sizeof(unsigned int) + 64), &map));
+
+  assert(mvx_voxelize_mesh_sparse(pyramid_vertices, 15, pyramid_indices, 18, sparse_grid_x, sparse_grid_y, sparse_grid_z, 1, 1, 1, memory, memory_size, &map));
+  assert(map.count.x == 5 && map.count.y == 3 && map.count.z == 3);
+
+  for (x = 0; x < 5 * 3 * 3; ++x)
+  {
+    occupied_bricks[x] = 0;
+  }
+
+  for (z = 0; z < sparse_grid_z; ++z)
+  {
+    for (y = 0; y < sparse_grid_y; ++y)
+    {
+      for (x = 0; x < sparse_grid_x; ++x)
+      {
+        int v = reference[x + y * sparse_grid_x + z * sparse_grid_x * sparse_grid_y];
+        mismatches += v != mvx_brickmap_get(&map, x, y, z);
+
+        if (v)
+        {
+          occupied_bricks[x / 8 + (y / 8) * 5 + (z / 8) * 15] = 1;
+        }
+      }
+    }
+  }
+
+  for (x = 0; x < 5 * 3 * 3; ++x)
+  {
+    expected_bricks += occupied_bricks[x];
+  }
+
+  assert(mismatches == 0);
+  assert(map.brick_count == expected_bricks);
+  assert(map.brick_count < 5 * 3 * 3);
+}
+
+void mvx_test_voxelize_svdag(void)
+{
+#define svdag_grid_x 37
+#define svdag_grid_y 21
+#define svdag_grid_z 21
+#define svdag_cube 32
+  unsigned char reference[svdag_grid_x * svdag_grid_y * svdag_grid_z];
+  unsigned char cube[svdag_cube * svdag_cube * svdag_cube];
+  unsigned char occupied_leaves[8 * 8 * 8];
+  unsigned long memory[4096];
+  unsigned long memory_size;
+  unsigned int nodes[2048];
+  unsigned long leaf_words = 0;
+  mvx_svdag dag;
+
+  int x, y, z;
+  int mismatches = 0;
+
+  assert(mvx_voxelize_mesh(pyramid_vertices, 15, pyramid_indices, 18, svdag_grid_x, svdag_grid_y, svdag_grid_z, 1, 1, 1, reference));
+
+  memory_size = mvx_voxelize_mesh_svdag_memory_size(pyramid_vertices, 15, pyramid_indices, 18, svdag_grid_x, svdag_grid_y, svdag_grid_z, 1, 1, 1, 2048);
+  assert(memory_size > 0 && memory_size <= sizeof(memory));
+
+  /* node pool too small */
+  assert(!mvx_voxelize_mesh_svdag(pyramid_vertices, 15, pyramid_indices, 18, svdag_grid_x, svdag_grid_y, svdag_grid_z, 1, 1, 1, memory, memory_size, nodes, 16, &dag));
+
+  assert(mvx_voxelize_mesh_svdag(pyramid_vertices, 15, pyramid_indices, 18, svdag_grid_x, svdag_grid_y, svdag_grid_z, 1, 1, 1, memory, memory_size, nodes, 2048, &dag));
+  assert(dag.size == 64);
+
+  for (z = 0; z < dag.size; ++z)
+  {
+    for (y = 0; y < dag.size; ++y)
+    {
+      for (x = 0; x < dag.size; ++x)
+      {
+        int inside = x < svdag_grid_x && y < svdag_grid_y && z < svdag_grid_z;
+        int v = inside ? reference[x + y * svdag_grid_x + z * svdag_grid_x * svdag_grid_y] : 0;
+        mismatches += v != mvx_svdag_get(&dag, x, y, z);
+      }
+    }
+  }
+
+  assert(mismatches == 0);
+
+  /* cube: the flat faces repeat the same leaves */
+  assert(mvx_voxelize_mesh(cube_vertices, 24, cube_indices, 36, svdag_cube, svdag_cube, svdag_cube, 4, 4, 4, cube));
+
+  memory_size = mvx_voxelize_mesh_svdag_memory_size(cube_vertices, 24, cube_indices, 36, svdag_cube, svdag_cube, svdag_cube, 4, 4, 4, 2048);
+  assert(memory_size > 0 && memory_size <= sizeof(memory));
+  assert(mvx_voxelize_mesh_svdag(cube_vertices, 24, cube_indices, 36, svdag_cube, svdag_cube, svdag_cube, 4, 4, 4, memory, memory_size, nodes, 2048, &dag));
+  assert(dag.size == svdag_cube);
+
+  for (x = 0; x < 8 * 8 * 8; ++x)
+  {
+    occupied_leaves[x] = 0;
+  }
+
+  mismatches = 0;
+
+  for (z = 0; z < svdag_cube; ++z)
+  {
+    for (y = 0; y < svdag_cube; ++y)
+    {
+      for (x = 0; x < svdag_cube; ++x)
+      {
+        int v = cube[x + y * svdag_cube + z * svdag_cube * svdag_cube];
+        mismatches += v != mvx_svdag_get(&dag, x, y, z);
+
+        if (v)
+        {
+          occupied_leaves[x / 4 + (y / 4) * 8 + (z / 4) * 64] = 1;
+        }
+      }
+    }
+  }
+
+  for (x = 0; x < 8 * 8 * 8; ++x)
+  {
+    leaf_words += 2ul * occupied_leaves[x];
+  }
+
+  assert(mismatches == 0);
+
+  /* the whole DAG is smaller than its leaves without sharing */
+  assert(dag.used < leaf_words);
+}
+
+#define stream_grid_x 37
+#define stream_grid_y 21
+#define stream_grid_z 21
+
+typedef struct mvx_test_stream
+{
+  unsigned char voxels[stream_grid_x * stream_grid_y * stream_grid_z];
+  unsigned int bits[2 * stream_grid_y * stream_grid_z];
+  int next_z;
+  int stop_after;
+
+} mvx_test_stream;
+
+int mvx_test_stream_bytes(void *user_data, void *voxels, int z_begin, int z_count)
+{
+  mvx_test_stream *stream = (mvx_test_stream *)user_data;
+  unsigned char *slab = (unsigned char *)voxels;
+  int i;
+
+  /* slabs arrive in order */
+  if (z_begin != stream->next_z)
+  {
+    return 0;
+  }
+
+  for (i = 0; i < z_count * stream_grid_x * stream_grid_y; ++i)
+  {
+    stream->voxels[z_begin * stream_grid_x * stream_grid_y + i] = slab[i];
+  }
+
+  stream->next_z = z_begin + z_count;
+
+  return stream->next_z != stream->stop_after;
+}
+
+int mvx_test_stream_bits(void *user_data, void *voxels, int z_begin, int z_count)
+{
+  mvx_test_stream *stream = (mvx_test_stream *)user_data;
+  unsigned int *slab = (unsigned int *)voxels;
+  int i;
+
+  if (z_begin != stream->next_z)
+  {
+    return 0;
+  }
+
+  for (i = 0; i < z_count * 2 * stream_grid_y; ++i)
+  {
+    stream->bits[z_begin * 2 * stream_grid_y + i] = slab[i];
+  }
+
+  stream->next_z = z_begin + z_count;
+
+  return 1;
+}
+
+void mvx_test_voxelize_streaming(void)
+{
+  static mvx_test_stream stream;
+  unsigned char reference[stream_grid_x * stream_grid_y * stream_grid_z];
+  unsigned int reference_bits[2 * stream_grid_y * stream_grid_z];
+  unsigned long memory[512];
+  unsigned long memory_size;
+  int i;
+  int mismatches = 0;
+
+  assert(mvx_voxelize_mesh(pyramid_vertices, 15, pyramid_indices, 18, stream_grid_x, stream_grid_y, stream_grid_z, 1, 1, 1, reference));
+  assert(mvx_voxelize_mesh_bits(pyramid_vertices, 15, pyramid_indices, 18, stream_grid_x, stream_grid_y, stream_grid_z, 1, 1, 1, reference_bits));
+
+  /* 4 slices per slab, the last slab is partial */
+  memory_size = mvx_voxelize_mesh_streaming_memory_size(pyramid_vertices, 15, pyramid_indices, 18, stream_grid_x, stream_grid_y, stream_grid_z, 1, 1, 1, 4);
+  assert(memory_size > 0 && memory_size <= sizeof(memory));
+  assert(memory_size < (unsigned long)sizeof(reference));
+
+  stream.next_z = 0;
+  stream.stop_after = -1;
+  assert(mvx_voxelize_mesh_streaming(pyramid_vertices, 15, pyramid_indices, 18, stream_grid_x, stream_grid_y, stream_grid_z, 1, 1, 1, 4, memory, memory_size, mvx_test_stream_bytes, &stream));
+  assert(stream.next_z == stream_grid_z);
+
+  for (i = 0; i < stream_grid_x * stream_grid_y * stream_grid_z; ++i)
+  {
+    mismatches += stream.voxels[i] != reference[i];
+  }
+
+  assert(mismatches == 0);
+
+  /* the callback stops after the second slab */
+  stream.next_z = 0;
+  stream.stop_after = 8;
+  assert(!mvx_voxelize_mesh_streaming(pyramid_vertices, 15, pyramid_indices, 18, stream_grid_x, stream_grid_y, stream_grid_z, 1, 1, 1, 4, memory, memory_size, mvx_test_stream_bytes, &stream));
+  assert(stream.next_z == 8);
+
+  /* memory too small */
+  assert(!mvx_voxelize_mesh_streaming(pyramid_vertices, 15, pyramid_indices, 18, stream_grid_x, stream_grid_y, stream_grid_z, 1, 1, 1, 4, memory, memory_size - 16, mvx_test_stream_bytes, &stream));
+
+  memory_size = mvx_voxelize_mesh_streaming_bits_memory_size(pyramid_vertices, 15, pyramid_indices, 18, stream_grid_x, stream_grid_y, stream_grid_z, 1, 1, 1, 5);
+  assert(memory_size > 0 && memory_size <= sizeof(memory));
+
+  stream.next_z = 0;
+  assert(mvx_voxelize_mesh_streaming_bits(pyramid_vertices, 15, pyramid_indices, 18, stream_grid_x, stream_grid_y, stream_grid_z, 1, 1, 1, 5, memory, memory_size, mvx_test_stream_bits, &stream));
+  assert(stream.next_z == stream_grid_z);
+
+  mismatches = 0;
+
+  for (i = 0; i < 2 * stream_grid_y * stream_grid_z; ++i)
+  {
+    mismatches += stream.bits[i] != reference_bits[i];
+  }
+
+  assert(mismatches == 0);
+}
+
+#define mode_grid 32
+
+/* Returns 1 if voxel (x, y, z) can be reached from voxel 0 through empty 6-connected voxels */
+int mvx_test_reachable(unsigned char *voxels, int x, int y, int z)
+{
+  static unsigned char visited[mode_grid * mode_grid * mode_grid];
+  static int stack[mode_grid * mode_grid * mode_grid];
+  int count = 0;
+  int i;
+
+  for (i = 0; i < mode_grid * mode_grid * mode_grid; ++i)
+  {
+    visited[i] = 0;
+  }
+
+  stack[count++] = 0;
+  visited[0] = 1;
+
+  while (count)
+  {
+    int id = stack[--count];
+    int n[6];
+
+    n[0] = id % mode_grid > 0 ? id - 1 : -1;
+    n[1] = id % mode_grid < mode_grid - 1 ? id + 1 : -1;
+    n[2] = (id / mode_grid) % mode_grid > 0 ? id - mode_grid : -1;
+    n[3] = (id / mode_grid) % mode_grid < mode_grid - 1 ? id + mode_grid : -1;
+    n[4] = id / (mode_grid * mode_grid) > 0 ? id - mode_grid * mode_grid : -1;
+    n[5] = id / (mode_grid * mode_grid) < mode_grid - 1 ? id + mode_grid * mode_grid : -1;
+
+    for (i = 0; i < 6; ++i)
+    {
+      if (n[i] >= 0 && !visited[n[i]] && !voxels[n[i]])
+      {
+        visited[n[i]] = 1;
+        stack[count++] = n[i];
+      }
+    }
+  }
+
+  return visited[x + y * mode_grid + z * mode_grid * mode_grid];
+}
+
+void mvx_test_voxelize_modes(void)
+{
+  static unsigned char reference[mode_grid * mode_grid * mode_grid];
+  static unsigned char voxels[4][mode_grid * mode_grid * mode_grid];
+  int count[4];
+  int not_conservative[4];
+  int not_26 = 0;
+  int mismatches = 0;
+  int mode, i;
+
+  assert(mvx_voxelize_mesh(pyramid_vertices, 15, pyramid_indices, 18, mode_grid, mode_grid, mode_grid, 2, 2, 2, reference));
+  assert(!mvx_voxelize_mesh_mode(pyramid_vertices, 15, pyramid_indices, 18, mode_grid, mode_grid, mode_grid, 2, 2, 2, 4, voxels[0]));
+
+  for (mode = MVX_MODE_CONSERVATIVE; mode <= MVX_MODE_CENTER; ++mode)
+  {
+    assert(mvx_voxelize_mesh_mode(pyramid_vertices, 15, pyramid_indices, 18, mode_grid, mode_grid, mode_grid, 2, 2, 2, mode, voxels[mode]));
+
+    count[mode] = 0;
+    not_conservative[mode] = 0;
+
+    for (i = 0; i < mode_grid * mode_grid * mode_grid; ++i)
+    {
+      count[mode] += voxels[mode][i];
+      not_conservative[mode] += voxels[mode][i] && !reference[i];
+    }
+  }
+
+  for (i = 0; i < mode_grid * mode_grid * mode_grid; ++i)
+  {
+    mismatches += voxels[MVX_MODE_CONSERVATIVE][i] != reference[i];
+    not_26 += voxels[MVX_MODE_6_SEPARATING][i] && !voxels[MVX_MODE_26_SEPARATING][i];
+  }
+
+  /* conservative mode is mvx_voxelize_mesh, every other mode is a subset of it */
+  assert(mismatches == 0);
+  assert(not_conservative[MVX_MODE_26_SEPARATING] == 0);
+  assert(not_conservative[MVX_MODE_6_SEPARATING] == 0);
+  assert(not_conservative[MVX_MODE_CENTER] == 0);
+  assert(not_26 == 0);
+  assert(count[MVX_MODE_6_SEPARATING] < count[MVX_MODE_CONSERVATIVE]);
+  assert(count[MVX_MODE_CENTER] > 0 && count[MVX_MODE_CENTER] < count[MVX_MODE_CONSERVATIVE]);
+
+  /* thin surfaces still separate the inside from the outside */
+  assert(mvx_test_reachable(voxels[MVX_MODE_26_SEPARATING], mode_grid / 2, mode_grid / 4, mode_grid / 2) == 0);
+  assert(mvx_test_reachable(voxels[MVX_MODE_6_SEPARATING], mode_grid / 2, mode_grid / 4, mode_grid / 2) == 0);
+
+  /* cube faces on voxel borders: one layer in every mode (12^3 hull) */
+  for (mode = MVX_MODE_CONSERVATIVE; mode <= MVX_MODE_CENTER; ++mode)
+  {
+    int c = 0;
+
+    assert(mvx_voxelize_mesh_mode(cube_vertices, 24, cube_indices, 36, 16, 16, 16, 2, 2, 2, mode, voxels[0]));
+
+    for (i = 0; i < 16 * 16 * 16; ++i)
+    {
+      c += voxels[0][i];
+    }
+
+    assert(c == 12 * 12 * 12 - 10 * 10 * 10);
+  }
+}
+
+void mvx_test_voxelize_incremental(void)
+{
+  /* apex moved inside the bounds, so the grid mapping stays the same */
+  float moved_vertices[] = {
+      -0.5f, 0.0f, -0.5f,
+      0.5f, 0.0f, -0.5f,
+      0.5f, 0.0f, 0.5f,
+      -0.5f, 0.0f, 0.5f,
+      0.3f, 1.0f, -0.2f};
+
+  unsigned int changed[] = {2, 3, 4, 5};
+
+#define incremental_grid 24
+  unsigned char reference[incremental_grid * incremental_grid * incremental_grid];
+  unsigned char voxels[incremental_grid * incremental_grid * incremental_grid];
+  unsigned short counts[incremental_grid * incremental_grid * incremental_grid];
+  mvx_incremental inc;
+  int i;
+  int mismatches = 0;
+  int stale = 0;
+
+  assert(mvx_incremental_init(&inc, pyramid_vertices, 15, pyramid_indices, 18, incremental_grid, incremental_grid, incremental_grid, 1, 1, 1, MVX_MODE_CONSERVATIVE, counts, voxels));
+  assert(mvx_voxelize_mesh(pyramid_vertices, 15, pyramid_indices, 18, incremental_grid, incremental_grid, incremental_grid, 1, 1, 1, reference));
+
+  for (i = 0; i < incremental_grid * incremental_grid * incremental_grid; ++i)
+  {
+    mismatches += voxels[i] != reference[i];
+  }
+
+  assert(mismatches == 0);
+
+  /* move the four side triangles */
+  assert(mvx_incremental_update(&inc, pyramid_vertices, moved_vertices, 15, pyramid_indices, 18, changed, 4));
+  assert(mvx_voxelize_mesh(moved_vertices, 15, pyramid_indices, 18, incremental_grid, incremental_grid, incremental_grid, 1, 1, 1, reference));
+
+  mismatches = 0;
+  for (i = 0; i < incremental_grid * incremental_grid * incremental_grid; ++i)
+  {
+    mismatches += voxels[i] != reference[i];
+    stale += voxels[i] != (counts[i] > 0);
+  }
+
+  assert(mismatches == 0);
+  assert(stale == 0);
+
+  /* and back */
+  assert(mvx_incremental_update(&inc, moved_vertices, pyramid_vertices, 15, pyramid_indices, 18, changed, 4));
+  assert(mvx_voxelize_mesh(pyramid_vertices, 15, pyramid_indices, 18, incremental_grid, incremental_grid, incremental_grid, 1, 1, 1, reference));
+
+  mismatches = 0;
+  for (i = 0; i < incremental_grid * incremental_grid * incremental_grid; ++i)
+  {
+    mismatches += voxels[i] != reference[i];
+  }
+
+  assert(mismatches == 0);
+
+  /* triangle index out of range */
+  changed[0] = 6;
+  assert(!mvx_incremental_update(&inc, pyramid_vertices, pyramid_vertices, 15, pyramid_indices, 18, changed, 1));
+}
+
+void mvx_test_voxelize_instances(void)
+{
+  /* scaled, scaled + rotated around y, far outside of the grid */
+  float transforms[] = {
+      8.0f, 0.0f, 0.0f, 4.0f,
+      0.0f, 8.0f, 0.0f, 0.0f,
+      0.0f, 0.0f, 8.0f, 4.0f,
+
+      0.0f, 0.0f, 8.0f, 12.0f,
+      0.0f, 8.0f, 0.0f, 8.0f,
+      -8.0f, 0.0f, 0.0f, 12.0f,
+
+      1.0f, 0.0f, 0.0f, 100.0f,
+      0.0f, 1.0f, 0.0f, 0.0f,
+      0.0f, 0.0f, 1.0f, 0.0f};
+
+#define instance_grid 16
+  float scene_vertices[2 * 15];
+  int scene_indices[2 * 18];
+  unsigned char reference[instance_grid * instance_grid * instance_grid];
+  unsigned char voxels[instance_grid * instance_grid * instance_grid];
+  unsigned int bits[instance_grid * instance_grid]; /* one word per row */
+  int i, j, x, y, z;
+  int mismatches = 0;
+  int count = 0;
+
+  /* the same scene with copied vertices spans [0, 16]^3, so auto-fit maps it to voxels of size 1 at the origin */
+  for (i = 0; i < 2; ++i)
+  {
+    for (j = 0; j < 5; ++j)
+    {
+      mvx_v3 p = mvx_transform_point(transforms + MVX_TRANSFORM_FLOATS * i, mvx_v3_init(pyramid_vertices[3 * j + 0], pyramid_vertices[3 * j + 1], pyramid_vertices[3 * j + 2]));
+      scene_vertices[15 * i + 3 * j + 0] = p.x;
+      scene_vertices[15 * i + 3 * j + 1] = p.y;
+      scene_vertices[15 * i + 3 * j + 2] = p.z;
+    }
+
+    for (j = 0; j < 18; ++j)
+    {
+      scene_indices[18 * i + j] = pyramid_indices[j] + 5 * i;
+    }
+  }
+
+  assert(mvx_voxelize_mesh(scene_vertices, 30, scene_indices, 36, instance_grid, instance_grid, instance_grid, 0, 0, 0, reference));
+  assert(mvx_voxelize_instances(pyramid_vertices, 15, pyramid_indices, 18, transforms, 3, 0.0f, 0.0f, 0.0f, 1.0f, instance_grid, instance_grid, instance_grid, voxels));
+  assert(mvx_voxelize_instances_bits(pyramid_vertices, 15, pyramid_indices, 18, transforms, 3, 0.0f, 0.0f, 0.0f, 1.0f, instance_grid, instance_grid, instance_grid, bits));
+
+  for (z = 0; z < instance_grid; ++z)
+  {
+    for (y = 0; y < instance_grid; ++y)
+    {
+      for (x = 0; x < instance_grid; ++x)
+      {
+        i = x + y * instance_grid + z * instance_grid * instance_grid;
+        mismatches += voxels[i] != reference[i];
+        mismatches += mvx_bits_get(bits, instance_grid, instance_grid, x, y, z) != voxels[i];
+        count += voxels[i];
+      }
+    }
+  }
+
+  assert(mismatches == 0);
+  assert(count > 0);
+
+  /* only the culled instance: the grid is cleared and stays empty */
+  assert(mvx_voxelize_instances(pyramid_vertices, 15, pyramid_indices, 18, transforms + 2 * MVX_TRANSFORM_FLOATS, 1, 0.0f, 0.0f, 0.0f, 1.0f, instance_grid, instance_grid, instance_grid, voxels));
+
+  count = 0;
+  for (i = 0; i < instance_grid * instance_grid * instance_grid; ++i)
+  {
+    count += voxels[i];
+  }
+
+  assert(count == 0);
+  assert(!mvx_voxelize_instances(pyramid_vertices, 15, pyramid_indices, 18, transforms, 3, 0.0f, 0.0f, 0.0f, 0.0f, instance_grid, instance_grid, instance_grid, voxels));
+}
+
+void mvx_test_voxelize_grid(void)
+{
+  /* pyramid spanning [0, 16]^3: auto-fit into 16^3 voxels without padding is the unit lattice at the origin */
+  float lattice_vertices[] = {
+      0.0f, 0.0f, 0.0f,
+      16.0f, 0.0f, 0.0f,
+      16.0f, 0.0f, 16.0f,
+      0.0f, 0.0f, 16.0f,
+      8.0f, 16.0f, 8.0f};
+
+#define lattice_grid 16
+#define chunk_x 4
+  unsigned char reference[lattice_grid * lattice_grid * lattice_grid];
+  unsigned char voxels[lattice_grid * lattice_grid * lattice_grid];
+  unsigned char chunk[chunk_x * lattice_grid * lattice_grid];
+  unsigned int bits[lattice_grid * lattice_grid]; /* one word per row */
+  mvx_target target;
+  mvx_grid grid;
+  int c, i, x, y, z;
+  int mismatches = 0;
+
+  assert(mvx_voxelize_mesh(lattice_vertices, 15, pyramid_indices, 18, lattice_grid, lattice_grid, lattice_grid, 0, 0, 0, reference));
+  assert(mvx_voxelize_mesh_grid(lattice_vertices, 15, pyramid_indices, 18, 0.0f, 0.0f, 0.0f, 1.0f, lattice_grid, lattice_grid, lattice_grid, voxels));
+  assert(mvx_voxelize_mesh_grid_bits(lattice_vertices, 15, pyramid_indices, 18, 0.0f, 0.0f, 0.0f, 1.0f, lattice_grid, lattice_grid, lattice_grid, bits));
+
+  for (z = 0; z < lattice_grid; ++z)
+  {
+    for (y = 0; y < lattice_grid; ++y)
+    {
+      for (x = 0; x < lattice_grid; ++x)
+      {
+        i = x + y * lattice_grid + z * lattice_grid * lattice_grid;
+        mismatches += voxels[i] != reference[i];
+        mismatches += mvx_bits_get(bits, lattice_grid, lattice_grid, x, y, z) != reference[i];
+      }
+    }
+  }
+
+  assert(mismatches == 0);
+
+  /* solid chunks along x share the lattice of the whole grid, the right one only sees crossings left of it */
+  assert(mvx_voxelize_mesh_solid(lattice_vertices, 15, pyramid_indices, 18, lattice_grid, lattice_grid, lattice_grid, 0, 0, 0, reference));
+
+  for (c = 0; c < lattice_grid / chunk_x; ++c)
+  {
+    assert(mvx_grid_init(&grid, mvx_v3_init((float)(c * chunk_x), 0.0f, 0.0f), 1.0f, chunk_x, lattice_grid, lattice_grid));
+
+    target = mvx_target_init(MVX_TARGET_BYTES);
+    target.bytes = chunk;
+    assert(mvx_voxelize_mesh_grid_target(lattice_vertices, 15, pyramid_indices, 18, &grid, 1, MVX_MODE_CONSERVATIVE, target));
+
+    for (z = 0; z < lattice_grid; ++z)
+    {
+      for (y = 0; y < lattice_grid; ++y)
+      {
+        for (x = 0; x < chunk_x; ++x)
+        {
+          mismatches += chunk[x + y * chunk_x + z * chunk_x * lattice_grid] != reference[c * chunk_x + x + y * lattice_grid + z * lattice_grid * lattice_grid];
+        }
+      }
+    }
+  }
+
+  assert(mismatches == 0);
+  assert(!mvx_voxelize_mesh_grid(lattice_vertices, 15, pyramid_indices, 18, 0.0f, 0.0f, 0.0f, -1.0f, lattice_grid, lattice_grid, lattice_grid, voxels));
+}
+
+void mvx_test_voxelize_context(void)
+{
+  static mvx_test_stream stream;
+  static float distances[stream_grid_x * stream_grid_y * stream_grid_z];
+  static float expected[stream_grid_x * stream_grid_y * stream_grid_z];
+  unsigned char reference[stream_grid_x * stream_grid_y * stream_grid_z];
+  unsigned char voxels[stream_grid_x * stream_grid_y * stream_grid_z];
+  unsigned int bits[stream_grid_y * stream_grid_z * 2];
+  unsigned long memory[4096];
+  unsigned long memory_size;
+  unsigned int nodes[2048];
+  mvx_context context;
+  mvx_brickmap map;
+  mvx_svdag dag;
+  mvx_rle rle;
+  mvx_lod lod;
+  int i, x, y, z;
+  int mismatches = 0;
+
+  assert(mvx_voxelize_mesh(pyramid_vertices, 15, pyramid_indices, 18, stream_grid_x, stream_grid_y, stream_grid_z, 1, 1, 1, reference));
+
+  /* one block covers every variant */
+  memory_size = mvx_context_memory_size(pyramid_vertices, 15, pyramid_indices, 18, stream_grid_x, stream_grid_y, stream_grid_z, 1, 1, 1, 8, 4, 2048, 1, 1, 1, 1);
+  assert(memory_size > 0 && memory_size <= sizeof(memory));
+  assert(memory_size >= mvx_voxelize_mesh_binned_memory_size(pyramid_vertices, 15, pyramid_indices, 18, stream_grid_x, stream_grid_y, stream_grid_z, 1, 1, 1, 8));
+  assert(memory_size >= mvx_voxelize_mesh_streaming_memory_size(pyramid_vertices, 15, pyramid_indices, 18, stream_grid_x, stream_grid_y, stream_grid_z, 1, 1, 1, 4));
+  assert(memory_size >= mvx_voxelize_mesh_rle_memory_size(pyramid_vertices, 15, pyramid_indices, 18, stream_grid_x, stream_grid_y, stream_grid_z, 1, 1, 1));
+  assert(memory_size >= mvx_voxelize_mesh_sdf_memory_size(stream_grid_x, stream_grid_y, stream_grid_z));
+  assert(memory_size >= mvx_edt_memory_size(stream_grid_x, stream_grid_y, stream_grid_z, 1));
+  assert(memory_size >= mvx_lod_memory_size(stream_grid_x, stream_grid_y, stream_grid_z, 0, 1));
+  assert(mvx_context_memory_size(pyramid_vertices, 15, pyramid_indices, 18, stream_grid_x, stream_grid_y, stream_grid_z, 1, 1, 1, 8, 4, 2048, 0, 0, 0, 0) <= memory_size);
+
+  mvx_context_init(&context, memory, memory_size);
+
+  assert(mvx_context_voxelize_mesh_binned(&context, pyramid_vertices, 15, pyramid_indices, 18, stream_grid_x, stream_grid_y, stream_grid_z, 1, 1, 1, 8, 0, 0, voxels));
+
+  for (i = 0; i < stream_grid_x * stream_grid_y * stream_grid_z; ++i)
+  {
+    mismatches += voxels[i] != reference[i];
+  }
+
+  stream.next_z = 0;
+  stream.stop_after = -1;
+  assert(mvx_context_voxelize_mesh_streaming(&context, pyramid_vertices, 15, pyramid_indices, 18, stream_grid_x, stream_grid_y, stream_grid_z, 1, 1, 1, 4, mvx_test_stream_bytes, &stream));
+  assert(stream.next_z == stream_grid_z);
+
+  for (i = 0; i < stream_grid_x * stream_grid_y * stream_grid_z; ++i)
+  {
+    mismatches += stream.voxels[i] != reference[i];
+  }
+
+  assert(mvx_context_voxelize_mesh_svdag(&context, pyramid_vertices, 15, pyramid_indices, 18, stream_grid_x, stream_grid_y, stream_grid_z, 1, 1, 1, nodes, 2048, &dag));
+  assert(mvx_context_voxelize_mesh_sparse(&context, pyramid_vertices, 15, pyramid_indices, 18, stream_grid_x, stream_grid_y, stream_grid_z, 1, 1, 1, &map));
+
+  for (z = 0; z < stream_grid_z; ++z)
+  {
+    for (y = 0; y < stream_grid_y; ++y)
+    {
+      for (x = 0; x < stream_grid_x; ++x)
+      {
+        int v = reference[x + y * stream_grid_x + z * stream_grid_x * stream_grid_y];
+        mismatches += v != mvx_brickmap_get(&map, x, y, z);
+        mismatches += v != mvx_svdag_get(&dag, x, y, z);
+      }
+    }
+  }
+
+  assert(mismatches == 0);
+
+  assert(mvx_context_voxelize_mesh_rle(&context, pyramid_vertices, 15, pyramid_indices, 18, stream_grid_x, stream_grid_y, stream_grid_z, 1, 1, 1, &rle));
+
+  for (z = 0; z < stream_grid_z; ++z)
+  {
+    for (y = 0; y < stream_grid_y; ++y)
+    {
+      for (x = 0; x < stream_grid_x; ++x)
+      {
+        mismatches += reference[x + y * stream_grid_x + z * stream_grid_x * stream_grid_y] != mvx_rle_get(&rle, x, y, z);
+      }
+    }
+  }
+
+  /* same distances as with separate scratch memory */
+  assert(mvx_voxelize_mesh_sdf(pyramid_vertices, 15, pyramid_indices, 18, stream_grid_x, stream_grid_y, stream_grid_z, 1, 1, 1, 3, memory + 2048, sizeof(memory) / 2, 0, 0, 0, expected));
+  assert(mvx_context_voxelize_mesh_sdf(&context, pyramid_vertices, 15, pyramid_indices, 18, stream_grid_x, stream_grid_y, stream_grid_z, 1, 1, 1, 3, 0, 0, 0, distances));
+
+  for (i = 0; i < stream_grid_x * stream_grid_y * stream_grid_z; ++i)
+  {
+    mismatches += distances[i] != expected[i];
+  }
+
+  assert(mvx_edt(reference, stream_grid_x, stream_grid_y, stream_grid_z, memory + 2048, sizeof(memory) / 2, 0, 0, 0, expected));
+  assert(mvx_context_edt(&context, reference, stream_grid_x, stream_grid_y, stream_grid_z, 0, 0, 0, distances));
+
+  for (i = 0; i < stream_grid_x * stream_grid_y * stream_grid_z; ++i)
+  {
+    mismatches += distances[i] != expected[i];
+  }
+
+  assert(mvx_voxelize_mesh_bits(pyramid_vertices, 15, pyramid_indices, 18, stream_grid_x, stream_grid_y, stream_grid_z, 1, 1, 1, bits));
+  assert(mvx_context_lod_build(&context, bits, stream_grid_x, stream_grid_y, stream_grid_z, 0, 1, &lod));
+  assert(lod.level_count == mvx_lod_level_count(stream_grid_x, stream_grid_y, stream_grid_z));
+  assert(lod.levels[lod.level_count - 1].bits[0] & 1u);
+
+  assert(mismatches == 0);
+
+  /* too small block */
+  mvx_context_init(&context, memory, 64);
+  assert(!mvx_context_voxelize_mesh_sparse(&context, pyramid_vertices, 15, pyramid_indices, 18, stream_grid_x, stream_grid_y, stream_grid_z, 1, 1, 1, &map));
+  assert(!mvx_context_voxelize_mesh_sdf(&context, pyramid_vertices, 15, pyramid_indices, 18, stream_grid_x, stream_grid_y, stream_grid_z, 1, 1, 1, 3, 0, 0, 0, distances));
+  assert(!mvx_context_lod_build(&context, bits, stream_grid_x, stream_grid_y, stream_grid_z, 0, 1, &lod));
+}
+
+void mvx_test_stats(void)
+{
+#define stats_grid 20
+  unsigned char voxels[stats_grid * stats_grid * stats_grid];
+  unsigned long rejects = 0;
+  unsigned long sum_rejects = 0;
+  unsigned long occupied = 0;
+  unsigned long candidates = 0;
+  mvx_stats stats;
+  mvx_stats job_stats[2];
+  mvx_stats sum;
+  mvx_voxelize_job jobs[2];
+  mvx_target target;
+  mvx_grid grid;
+  int i;
+
+  /* the candidates are the plane band voxels of every triangle */
+  mvx_grid_fit(&grid, pyramid_vertices, 15, stats_grid, stats_grid, stats_grid, 1, 1, 1);
+
+  for (i = 0; i < 18; i += 3)
+  {
+    mvx_v3 v0 = mvx_v3_init(pyramid_vertices[pyramid_indices[i] * 3], pyramid_vertices[pyramid_indices[i] * 3 + 1], pyramid_vertices[pyramid_indices[i] * 3 + 2]);
+    mvx_v3 v1 = mvx_v3_init(pyramid_vertices[pyramid_indices[i + 1] * 3], pyramid_vertices[pyramid_indices[i + 1] * 3 + 1], pyramid_vertices[pyramid_indices[i + 1] * 3 + 2]);
+    mvx_v3 v2 = mvx_v3_init(pyramid_vertices[pyramid_indices[i + 2] * 3], pyramid_vertices[pyramid_indices[i + 2] * 3 + 1], pyramid_vertices[pyramid_indices[i + 2] * 3 + 2]);
+
+    candidates += mvx_voxelize_triangle_candidates(&grid, v0, v1, v2, mvx_v3i_init(0, 0, 0), mvx_v3i_init(stats_grid - 1, stats_grid - 1, stats_grid - 1));
+  }
+
+  target = mvx_target_init(MVX_TARGET_BYTES);
+  target.bytes = voxels;
+  mvx_stats_init(&stats);
+  assert(mvx_voxelize_mesh_stats_target(pyramid_vertices, 15, pyramid_indices, 18, stats_grid, stats_grid, stats_grid, 1, 1, 1, 0, target, &stats));
+
+  /* two slab jobs fill their own stats, their sum sees every triangle of each slab */
+  mvx_stats_init(&sum);
+
+  for (i = 0; i < 2; ++i)
+  {
+    assert(mvx_voxelize_job_init(&jobs[i], pyramid_vertices, 15, pyramid_indices, 18, stats_grid, stats_grid, stats_grid, 1, 1, 1, 0, target));
+    mvx_stats_init(&job_stats[i]);
+    jobs[i].job_count = 2;
+    jobs[i].stats = &job_stats[i];
+    mvx_voxelize_job_run(&jobs[i], i);
+    mvx_stats_add(&sum, &job_stats[i]);
+  }
+
+  for (i = 0; i < MVX_STATS_REJECT_COUNT; ++i)
+  {
+    rejects += stats.rejects[i];
+    sum_rejects += sum.rejects[i];
+  }
+
+  for (i = 0; i < stats_grid * stats_grid * stats_grid; ++i)
+  {
+    occupied += voxels[i];
+  }
+
+#ifdef MVX_STATS
+  /* every test either hits or is rejected by exactly one axis family */
+  assert(stats.triangles == 6);
+  assert(stats.candidates == candidates);
+  assert(stats.tests > 0 && stats.tests <= stats.candidates);
+  assert(stats.tests == stats.hits + rejects);
+  assert(stats.point_hits <= stats.hits);
+  assert(stats.hits >= occupied);
+  assert(sum.triangles >= stats.triangles && sum.tests == sum.hits + sum_rejects);
+  assert(sum.candidates == stats.candidates && sum.hits == stats.hits);
+#else
+  /* compiled out */
+  assert(stats.triangles == 0 && stats.tests == 0 && rejects == 0);
+  assert(sum.triangles == 0 && sum.tests == 0);
+  assert(occupied > 0 && candidates > 0);
+#endif
+}
+
+void mvx_test_voxelize_attributes(void)
+{
+  /* the pyramid twice, the first copy always has to win */
+  int twice_indices[] = {
+      0, 1, 2, 0, 2, 3,
+      0, 1, 4, 1, 2, 4, 2, 3, 4, 3, 0, 4,
+      0, 1, 2, 0, 2, 3,
+      0, 1, 4, 1, 2, 4, 2, 3, 4, 3, 0, 4};
+
+  unsigned int triangle_materials[] = {7, 7, 1, 2, 3, 4, 7, 7, 1, 2, 3, 4};
+
+#define attribute_grid 20
+  unsigned char reference[attribute_grid * attribute_grid * attribute_grid];
+  unsigned char voxels[attribute_grid * attribute_grid * attribute_grid];
+  unsigned int triangles[attribute_grid * attribute_grid * attribute_grid];
+  unsigned int materials[attribute_grid * attribute_grid * attribute_grid];
+  float normals[3 * attribute_grid * attribute_grid * attribute_grid];
+  int i;
+  int mismatches = 0;
+
+  assert(mvx_voxelize_mesh(pyramid_vertices, 15, twice_indices, 36, attribute_grid, attribute_grid, attribute_grid, 1, 1, 1, reference));
+  assert(mvx_voxelize_mesh_attributes(pyramid_vertices, 15, twice_indices, 36, attribute_grid, attribute_grid, attribute_grid, 1, 1, 1, 0, triangle_materials, voxels, triangles, materials, normals));
+
+  for (i = 0; i < attribute_grid * attribute_grid * attribute_grid; ++i)
+  {
+    float n2 = normals[3 * i] * normals[3 * i] + normals[3 * i + 1] * normals[3 * i + 1] + normals[3 * i + 2] * normals[3 * i + 2];
+
+    mismatches += voxels[i] != reference[i];
+
+    if (voxels[i])
+    {
+      mismatches += triangles[i] >= 6;
+      mismatches += triangles[i] < 6 && materials[i] != triangle_materials[triangles[i]];
+      mismatches += !(n2 > 0.0f);
+    }
+    else
+    {
+      mismatches += triangles[i] != MVX_ATTRIBUTE_NONE || materials[i] != MVX_ATTRIBUTE_NONE || n2 != 0.0f;
+    }
+  }
+
+  assert(mismatches == 0);
+
+  /* solid: the interior has occupancy but no attributes, channels are optional */
+  assert(mvx_voxelize_mesh_solid(pyramid_vertices, 15, pyramid_indices, 18, attribute_grid, attribute_grid, attribute_grid, 1, 1, 1, reference));
+  assert(mvx_voxelize_mesh_attributes(pyramid_vertices, 15, pyramid_indices, 18, attribute_grid, attribute_grid, attribute_grid, 1, 1, 1, 1, 0, voxels, triangles, 0, 0));
+
+  for (i = 0; i < attribute_grid * attribute_grid * attribute_grid; ++i)
+  {
+    mismatches += voxels[i] != reference[i];
+    mismatches += !voxels[i] && triangles[i] != MVX_ATTRIBUTE_NONE;
+  }
+
+  assert(mismatches == 0);
+
+  /* materials need the per triangle input */
+  assert(!mvx_voxelize_mesh_attributes(pyramid_vertices, 15, pyramid_indices, 18, attribute_grid, attribute_grid, attribute_grid, 1, 1, 1, 0, 0, voxels, 0, materials, 0));
+}
+
+void mvx_test_voxelize_sdf(void)
+{
+#define sdf_grid 20
+#define sdf_band 3
+  static float distances[sdf_grid * sdf_grid * sdf_grid];
+  static float parallel[sdf_grid * sdf_grid * sdf_grid];
+  static short quantized[sdf_grid * sdf_grid * sdf_grid];
+  unsigned long memory[512];
+  unsigned long memory_size = mvx_voxelize_mesh_sdf_memory_size(sdf_grid, sdf_grid, sdf_grid);
+  int dispatched = 0;
+  int mismatches = 0;
+  int inside = 0;
+  mvx_grid grid;
+  int x, y, z;
+
+  assert(memory_size > 0 && memory_size <= sizeof(memory));
+  assert(mvx_grid_fit(&grid, cube_vertices, 24, sdf_grid, sdf_grid, sdf_grid, 4, 4, 4));
+
+  assert(mvx_voxelize_mesh_sdf(cube_vertices, 24, cube_indices, 36, sdf_grid, sdf_grid, sdf_grid, 4, 4, 4, sdf_band, memory, memory_size, 0, 0, 0, distances));
+  assert(mvx_voxelize_mesh_sdf(cube_vertices, 24, cube_indices, 36, sdf_grid, sdf_grid, sdf_grid, 4, 4, 4, sdf_band, memory, memory_size, mvx_test_dispatch_reverse, &dispatched, 5, parallel));
+  assert(mvx_voxelize_mesh_sdf_int16(cube_vertices, 24, cube_indices, 36, sdf_grid, sdf_grid, sdf_grid, 4, 4, 4, sdf_band, memory, memory_size, 0, 0, 0, quantized));
+  assert(dispatched == 5);
+
+  /* analytic distance of the unit box at the voxel centers */
+  for (z = 0; z < sdf_grid; ++z)
+  {
+    for (y = 0; y < sdf_grid; ++y)
+    {
+      for (x = 0; x < sdf_grid; ++x)
+      {
+        long i = x + y * sdf_grid + (long)z * sdf_grid * sdf_grid;
+        mvx_v3 c = mvx_grid_voxel_center(&grid, x, y, z);
+        mvx_v3 q = mvx_v3_sub(mvx_v3_abs(mvx_v3_sub(c, mvx_v3_init(0.5f, 0.5f, 0.5f))), mvx_v3_init(0.5f, 0.5f, 0.5f));
+        mvx_v3 o = mvx_v3_max_scalar(q, 0.0f);
+        float expected = (mvx_sqrtf(mvx_v3_dot(o, o)) + mvx_minf(mvx_v3_max_element(q), 0.0f)) / grid.vxsize;
+
+        expected = mvx_clampf(expected, -(float)sdf_band, (float)sdf_band);
+        inside += expected < -1.0f;
+
+        mismatches += mvx_absf(distances[i] - expected) > 1e-3f;
+        mismatches += parallel[i] != distances[i];
+        mismatches += mvx_absf((float)quantized[i] - expected * MVX_SDF_INT16_SCALE) > 1.0f;
+      }
+    }
+  }
+
+  assert(inside > 0);
+  assert(mismatches == 0);
+
+  /* invalid band or too little scratch memory */
+  assert(!mvx_voxelize_mesh_sdf(cube_vertices, 24, cube_indices, 36, sdf_grid, sdf_grid, sdf_grid, 4, 4, 4, 0, memory, memory_size, 0, 0, 0, distances));
+  assert(!mvx_voxelize_mesh_sdf_int16(cube_vertices, 24, cube_indices, 36, sdf_grid, sdf_grid, sdf_grid, 4, 4, 4, 128, memory, memory_size, 0, 0, 0, quantized));
+  assert(!mvx_voxelize_mesh_sdf(cube_vertices, 24, cube_indices, 36, sdf_grid, sdf_grid, sdf_grid, 4, 4, 4, sdf_band, memory, 64, 0, 0, 0, distances));
+}
+
+void mvx_test_edt(void)
+{
+#define edt_grid_x 13
+#define edt_grid_y 9
+#define edt_grid_z 7
+  unsigned char voxels[edt_grid_x * edt_grid_y * edt_grid_z];
+  float distances[edt_grid_x * edt_grid_y * edt_grid_z];
+  float parallel[edt_grid_x * edt_grid_y * edt_grid_z];
+  unsigned long memory[256];
+  unsigned long memory_size = mvx_edt_memory_size(edt_grid_x, edt_grid_y, edt_grid_z, 4);
+  int dispatched = 0;
+  int mismatches = 0;
+  int i, j, x, y, z;
+
+  assert(memory_size > 0 && memory_size <= sizeof(memory));
+
+  for (i = 0; i < edt_grid_x * edt_grid_y * edt_grid_z; ++i)
+  {
+    voxels[i] = mvx_test_random() < 0.02f;
+  }
+
+  assert(mvx_edt(voxels, edt_grid_x, edt_grid_y, edt_grid_z, memory, memory_size, 0, 0, 0, distances));
+  assert(mvx_edt(voxels, edt_grid_x, edt_grid_y, edt_grid_z, memory, memory_size, mvx_test_dispatch_reverse, &dispatched, 4, parallel));
+  assert(dispatched == 3 * 4);
+
+  /* brute force nearest occupied voxel */
+  for (i = 0; i < edt_grid_x * edt_grid_y * edt_grid_z; ++i)
+  {
+    float best = 1e30f;
+
+    x = i % edt_grid_x;
+    y = (i / edt_grid_x) % edt_grid_y;
+    z = i / (edt_grid_x * edt_grid_y);
+
+    for (j = 0; j < edt_grid_x * edt_grid_y * edt_grid_z; ++j)
+    {
+      if (voxels[j])
+      {
+        int dx = j % edt_grid_x - x;
+        int dy = (j / edt_grid_x) % edt_grid_y - y;
+        int dz = j / (edt_grid_x * edt_grid_y) - z;
+        best = mvx_minf(best, (float)(dx * dx + dy * dy + dz * dz));
+      }
+    }
+
+    mismatches += mvx_absf(distances[i] - mvx_sqrtf(best)) > 1e-4f;
+    mismatches += parallel[i] != distances[i];
+  }
+
+  assert(mismatches == 0);
+
+  /* nothing occupied, too little scratch memory */
+  for (i = 0; i < edt_grid_x * edt_grid_y * edt_grid_z; ++i)
+  {
+    voxels[i] = 0;
+  }
+
+  assert(mvx_edt(voxels, edt_grid_x, edt_grid_y, edt_grid_z, memory, memory_size, 0, 0, 0, distances));
+  assert(distances[0] >= mvx_sqrtf(MVX_EDT_FAR) * 0.99f);
+  assert(!mvx_edt(voxels, edt_grid_x, edt_grid_y, edt_grid_z, memory, 16, 0, 0, 0, distances));
+}
+
+void mvx_test_voxelize_rle(void)
+{
+#define rle_grid_x 70
+#define rle_grid_y 21
+#define rle_grid_z 23
+  static unsigned char reference[rle_grid_x * rle_grid_y * rle_grid_z];
+  unsigned char row[rle_grid_x];
+  static unsigned long memory[16384];
+  unsigned long memory_size;
+  unsigned long span_count = 0;
+  int mismatches = 0;
+  mvx_rle rle;
+  int x, y, z;
+
+  assert(mvx_voxelize_mesh(pyramid_vertices, 15, pyramid_indices, 18, rle_grid_x, rle_grid_y, rle_grid_z, 1, 1, 1, reference));
+
+  memory_size = mvx_voxelize_mesh_rle_memory_size(pyramid_vertices, 15, pyramid_indices, 18, rle_grid_x, rle_grid_y, rle_grid_z, 1, 1, 1);
+  assert(memory_size > 0 && memory_size <= sizeof(memory));
+  assert(mvx_voxelize_mesh_rle(pyramid_vertices, 15, pyramid_indices, 18, rle_grid_x, rle_grid_y, rle_grid_z, 1, 1, 1, memory, memory_size, &rle));
+
+  for (z = 0; z < rle_grid_z; ++z)
+  {
+    for (y = 0; y < rle_grid_y; ++y)
+    {
+      unsigned char *expected = reference + (long)y * rle_grid_x + (long)z * rle_grid_x * rle_grid_y;
+      unsigned long count, i;
+      mvx_span *spans = mvx_rle_row_spans(&rle, y, z, &count);
+
+      mvx_rle_decode_row(&rle, y, z, row);
+
+      for (x = 0; x < rle_grid_x; ++x)
+      {
+        mismatches += row[x] != expected[x];
+        mismatches += mvx_rle_get(&rle, x, y, z) != expected[x];
+        span_count += expected[x] && (x == 0 || !expected[x - 1]);
+      }
+
+      /* sorted, non-empty and separated by at least one empty voxel */
+      for (i = 0; i < count; ++i)
+      {
+        mismatches += spans[i].begin >= spans[i].end;
+        mismatches += i > 0 && spans[i].begin <= spans[i - 1].end;
+      }
+    }
+  }
+
+  assert(mismatches == 0);
+  assert(span_count > 0 && rle.span_count == span_count);
+
+  /* not enough room for the records */
+  assert(!mvx_voxelize_mesh_rle(pyramid_vertices, 15, pyramid_indices, 18, rle_grid_x, rle_grid_y, rle_grid_z, 1, 1, 1, memory, mvx_rle_memory_size(rle_grid_y, rle_grid_z, 8), &rle));
+}
+
+/* the header fields share their names with the grid size macros of the cube test */
+#undef grid_x
+#undef grid_y
+#undef grid_z
+
+void mvx_test_file(void)
+{
+#define file_grid_x 37
+#define file_grid_y 21
+#define file_grid_z 21
+  static unsigned char voxels[file_grid_x * file_grid_y * file_grid_z];
+  static unsigned int bits[file_grid_y * file_grid_z * 2];
+  static unsigned long memory[4096];
+  static unsigned long buffer[8192];
+  unsigned long size;
+  int mismatches = 0;
+  mvx_file_header saved;
+  mvx_brickmap map;
+  mvx_grid grid, huge;
+  mvx_file file;
+  int x, y, z;
+
+  assert(sizeof(mvx_file_header) == 128);
+  assert(mvx_grid_fit(&grid, pyramid_vertices, 15, file_grid_x, file_grid_y, file_grid_z, 1, 1, 1));
+  assert(mvx_voxelize_mesh(pyramid_vertices, 15, pyramid_indices, 18, file_grid_x, file_grid_y, file_grid_z, 1, 1, 1, voxels));
+  assert(mvx_voxelize_mesh_bits(pyramid_vertices, 15, pyramid_indices, 18, file_grid_x, file_grid_y, file_grid_z, 1, 1, 1, bits));
+  assert(mvx_voxelize_mesh_sparse(pyramid_vertices, 15, pyramid_indices, 18, file_grid_x, file_grid_y, file_grid_z, 1, 1, 1, memory, sizeof(memory), &map));
+
+  /* dense bytes, used in place */
+  size = mvx_file_write_bytes(buffer, sizeof(buffer), &grid, 0, voxels);
+  assert(size == mvx_file_size(&grid, MVX_FILE_BYTES, 0) && size <= sizeof(buffer));
+  assert(mvx_file_open(buffer, size, &file));
+  assert(file.bytes == (unsigned char *)buffer + file.header->payload_offset);
+  assert(file.grid.vxsize == grid.vxsize && file.grid.margin.y == grid.margin.y && file.grid.min_b.z == grid.min_b.z);
+
+  for (x = 0; x < file_grid_x * file_grid_y * file_grid_z; ++x)
+  {
+    mismatches += file.bytes[x] != voxels[x];
+  }
+
+  /* truncated, damaged */
+  assert(!mvx_file_open(buffer, size - 1, &file));
+  file.header->version = MVX_FILE_VERSION + 1;
+  assert(!mvx_file_open(buffer, size, &file));
+  file.header->version = MVX_FILE_VERSION;
+  assert(mvx_file_open(buffer, size, &file));
+  file.header->payload_offset = 0;
+  assert(!mvx_file_open(buffer, size, &file));
+  file.header->payload_offset = (unsigned int)mvx_file_align((unsigned long)sizeof(mvx_file_header));
+  file.header->reserved[8] = 1;
+  assert(!mvx_file_open(buffer, size, &file));
+  file.header->reserved[8] = 0;
+  file.header->voxel_size = 0.0f;
+  assert(!mvx_file_open(buffer, size, &file));
+  assert(!mvx_file_write_bytes(buffer, size - 1, &grid, 0, voxels));
+
+  /* sizes that overflow, payloads past the end, object ranges outside the grid */
+  huge = grid;
+  huge.x = huge.y = huge.z = 0x7FFFFF00;
+  assert(!mvx_file_size(&huge, MVX_FILE_BYTES, 0));
+  assert(!mvx_file_size(&huge, MVX_FILE_BRICKMAP, 0));
+  assert(!mvx_file_write_bytes(buffer, sizeof(buffer), &huge, 0, voxels));
+
+  size = mvx_file_write_bytes(buffer, sizeof(buffer), &grid, 0, voxels);
+  assert(mvx_file_open(buffer, size, &file));
+  saved = *file.header;
+  file.header->grid_x = file.header->grid_y = file.header->grid_z = 0x7FFFFF00;
+  assert(!mvx_file_open(buffer, size, &file));
+  *file.header = saved;
+  file.header->payload_offset += MVX_FILE_ALIGNMENT;
+  assert(!mvx_file_open(buffer, size, &file));
+  *file.header = saved;
+  file.header->need_x = file_grid_x;
+  assert(!mvx_file_open(buffer, size, &file));
+  *file.header = saved;
+  file.header->margin_z = -1;
+  assert(!mvx_file_open(buffer, size, &file));
+  *file.header = saved;
+  assert(mvx_file_open(buffer, size, &file));
+
+  /* bits and bricks */
+  size = mvx_file_write_bits(buffer, sizeof(buffer), &grid, MVX_FILE_FLAG_SOLID, bits);
+  assert(size > 0 && mvx_file_open(buffer, size, &file));
+  assert(file.bits && file.header->flags == MVX_FILE_FLAG_SOLID);
+
+  for (z = 0; z < file_grid_z; ++z)
+  {
+    for (y = 0; y < file_grid_y; ++y)
+    {
+      for (x = 0; x < file_grid_x; ++x)
+      {
+        mismatches += mvx_bits_get(file.bits, file_grid_x, file_grid_y, x, y, z) != voxels[x + y * file_grid_x + z * file_grid_x * file_grid_y];
+      }
+    }
+  }
+
+  size = mvx_file_write_brickmap(buffer, sizeof(buffer), &grid, 0, &map);
+  assert(size == mvx_file_size(&grid, MVX_FILE_BRICKMAP, map.brick_count));
+  assert(mvx_file_open(buffer, size, &file));
+  assert(file.brickmap.brick_count == map.brick_count && file.header->bricks_offset % MVX_FILE_ALIGNMENT == 0);
+
+  /* an index entry past the stored bricks */
+  file.brickmap.index[1] = map.brick_count + 1;
+  assert(!mvx_file_open(buffer, size, &file));
+  file.brickmap.index[1] = map.index[1];
+  assert(mvx_file_open(buffer, size, &file));
+
+  for (z = 0; z < file_grid_z; ++z)
+  {
+    for (y = 0; y < file_grid_y; ++y)
+    {
+      for (x = 0; x < file_grid_x; ++x)
+      {
+        mismatches += mvx_brickmap_get(&file.brickmap, x, y, z) != voxels[x + y * file_grid_x + z * file_grid_x * file_grid_y];
+      }
+    }
+  }
+
+  assert(mismatches == 0);
+}
+
+void mvx_test_voxelize_layout(void)
+{
+#define layout_grid_x 37
+#define layout_grid_y 21
+#define layout_grid_z 19
+  static unsigned char reference[layout_grid_x * layout_grid_y * layout_grid_z];
+  static unsigned char linear[layout_grid_x * layout_grid_y * layout_grid_z];
+  static unsigned char voxels[64 * 32 * 32];
+  static unsigned char converted[64 * 32 * 32];
+  int mismatches = 0;
+  int layout, solid;
+  long i, size;
+
+  for (i = 0; i < 1024; i += 7)
+  {
+    mismatches += mvx_morton_compact3(mvx_morton_spread3((unsigned int)i)) != (unsigned int)i;
+  }
+
+  for (solid = 0; solid <= 1; ++solid)
+  {
+    if (solid)
+    {
+      assert(mvx_voxelize_mesh_solid(pyramid_vertices, 15, pyramid_indices, 18, layout_grid_x, layout_grid_y, layout_grid_z, 1, 1, 1, reference));
+    }
+    else
+    {
+      assert(mvx_voxelize_mesh(pyramid_vertices, 15, pyramid_indices, 18, layout_grid_x, layout_grid_y, layout_grid_z, 1, 1, 1, reference));
+    }
+
+    for (layout = MVX_LAYOUT_LINEAR; layout <= MVX_LAYOUT_TILED8; ++layout)
+    {
+      size = mvx_layout_size(layout, layout_grid_x, layout_grid_y, layout_grid_z);
+      assert(size >= layout_grid_x * layout_grid_y * layout_grid_z && size <= (long)sizeof(voxels));
+
+      assert(mvx_voxelize_mesh_layout(pyramid_vertices, 15, pyramid_indices, 18, layout_grid_x, layout_grid_y, layout_grid_z, 1, 1, 1, solid, layout, voxels));
+
+      /* round trip through linear order, holes stay zero */
+      mvx_layout_to_linear(layout, layout_grid_x, layout_grid_y, layout_grid_z, voxels, linear);
+      mvx_layout_from_linear(layout, layout_grid_x, layout_grid_y, layout_grid_z, reference, converted);
+
+      for (i = 0; i < layout_grid_x * layout_grid_y * layout_grid_z; ++i)
+      {
+        mismatches += linear[i] != reference[i];
+      }
+
+      for (i = 0; i < size; ++i)
+      {
+        mismatches += converted[i] != voxels[i];
+      }
+    }
+  }
+
+  assert(mismatches == 0);
+  assert(mvx_layout_index(MVX_LAYOUT_MORTON, layout_grid_x, layout_grid_y, 1, 1, 1) == 7);
+  assert(mvx_layout_index(MVX_LAYOUT_TILED4, layout_grid_x, layout_grid_y, 4, 0, 0) == 64);
+  assert(!mvx_voxelize_mesh_layout(pyramid_vertices, 15, pyramid_indices, 18, 1025, 4, 4, 0, 0, 0, 0, MVX_LAYOUT_MORTON, voxels));
+}
+
+void mvx_test_lod(void)
+{
+#define lod_grid_x 75
+#define lod_grid_y 21
+#define lod_grid_z 19
+  static unsigned char voxels[lod_grid_x * lod_grid_y * lod_grid_z];
+  static unsigned int bits[3 * lod_grid_y * lod_grid_z];
+  static unsigned long memory[4096];
+  unsigned long memory_size;
+  int mismatches = 0;
+  int levels = mvx_lod_level_count(lod_grid_x, lod_grid_y, lod_grid_z);
+  int l, x, y, z, dx, dy, dz;
+  mvx_lod lod;
+
+  assert(levels == 8);
+  assert(mvx_voxelize_mesh(pyramid_vertices, 15, pyramid_indices, 18, lod_grid_x, lod_grid_y, lod_grid_z, 1, 1, 1, voxels));
+  assert(mvx_voxelize_mesh_bits(pyramid_vertices, 15, pyramid_indices, 18, lod_grid_x, lod_grid_y, lod_grid_z, 1, 1, 1, bits));
+
+  memory_size = mvx_lod_memory_size(lod_grid_x, lod_grid_y, lod_grid_z, levels, 1);
+  assert(memory_size > 0 && memory_size <= sizeof(memory));
+  assert(memory_size == mvx_lod_memory_size(lod_grid_x, lod_grid_y, lod_grid_z, 0, 1));
+  assert(mvx_lod_build(bits, lod_grid_x, lod_grid_y, lod_grid_z, 0, 1, memory, memory_size, &lod));
+  assert(lod.level_count == levels);
+  assert(lod.levels[levels - 1].x == 1 && lod.levels[levels - 1].y == 1 && lod.levels[levels - 1].z == 1);
+
+  /* every coarse voxel against the finest bytes it covers */
+  for (l = 1; l < levels; ++l)
+  {
+    mvx_lod_level *level = &lod.levels[l];
+    int size = 1 << l;
+
+    for (z = 0; z < level->z; ++z)
+    {
+      for (y = 0; y < level->y; ++y)
+      {
+        for (x = 0; x < level->x; ++x)
+        {
+          int any = 0;
+
+          for (dz = 0; dz < size; ++dz)
+          {
+            for (dy = 0; dy < size; ++dy)
+            {
+              for (dx = 0; dx < size; ++dx)
+              {
+                int fx = x * size + dx, fy = y * size + dy, fz = z * size + dz;
+
+                if (fx < lod_grid_x && fy < lod_grid_y && fz < lod_grid_z)
+                {
+                  any |= voxels[fx + fy * lod_grid_x + fz * lod_grid_x * lod_grid_y];
+                }
+              }
+            }
+          }
+
+          mismatches += mvx_bits_get(level->bits, level->x, level->y, x, y, z) != any;
+        }
+      }
+    }
+  }
+
+  /* coverage counts of level 1 */
+  for (z = 0; z < lod.levels[1].z; ++z)
+  {
+    for (y = 0; y < lod.levels[1].y; ++y)
+    {
+      for (x = 0; x < lod.levels[1].x; ++x)
+      {
+        int count = 0;
+
+        for (dz = 0; dz < 2; ++dz)
+        {
+          for (dy = 0; dy < 2; ++dy)
+          {
+            for (dx = 0; dx < 2; ++dx)
+            {
+              int fx = 2 * x + dx, fy = 2 * y + dy, fz = 2 * z + dz;
+
+              if (fx < lod_grid_x && fy < lod_grid_y && fz < lod_grid_z)
+              {
+                count += voxels[fx + fy * lod_grid_x + fz * lod_grid_x * lod_grid_y];
+              }
+            }
+          }
+        }
+
+        mismatches += lod.levels[1].counts[x + y * lod.levels[1].x + z * lod.levels[1].x * lod.levels[1].y] != count;
+      }
+    }
+  }
+
+  assert(mismatches == 0);
+  assert(!mvx_lod_build(bits, lod_grid_x, lod_grid_y, lod_grid_z, 0, 1, memory, memory_size - 16, &lod));
+}
+
+typedef struct mvx_test_vertex
+{
+  float normal[3];
+  float position[3];
+  float uv[2];
+
+} mvx_test_vertex;
+
+void mvx_test_voxelize_input(void)
+{
+#define input_grid_x 23
+#define input_grid_y 17
+#define input_grid_z 19
+  static unsigned char reference[input_grid_x * input_grid_y * input_grid_z];
+  static unsigned char voxels[input_grid_x * input_grid_y * input_grid_z];
+  static unsigned int reference_bits[input_grid_y * input_grid_z]; /* one word per row */
+  static unsigned int bits[input_grid_y * input_grid_z];
+  mvx_test_vertex interleaved[5];
+  mvx_test_vertex soup[18];
+  unsigned short indices16[18 + 3];
+  unsigned int indices32[18];
+  mvx_mesh mesh;
+  int mismatches = 0;
+  int i, q, solid;
+
+  /* positions between normals and uvs, the soup repeats every corner */
+  for (i = 0; i < 5; ++i)
+  {
+    interleaved[i].normal[0] = interleaved[i].normal[1] = interleaved[i].normal[2] = -7.0f;
+    interleaved[i].uv[0] = interleaved[i].uv[1] = 9.0f;
+    interleaved[i].position[0] = pyramid_vertices[3 * i + 0];
+    interleaved[i].position[1] = pyramid_vertices[3 * i + 1];
+    interleaved[i].position[2] = pyramid_vertices[3 * i + 2];
+  }
+
+  for (i = 0; i < 18; ++i)
+  {
+    soup[i] = interleaved[pyramid_indices[i]];
+    indices16[i] = (unsigned short)pyramid_indices[i];
+    indices32[i] = (unsigned int)pyramid_indices[i];
+  }
+
+  for (solid = 0; solid < 2; ++solid)
+  {
+    if (solid)
+    {
+      assert(mvx_voxelize_mesh_solid(pyramid_vertices, 15, pyramid_indices, 18, input_grid_x, input_grid_y, input_grid_z, 1, 1, 1, reference));
+      assert(mvx_voxelize_mesh_solid_bits(pyramid_vertices, 15, pyramid_indices, 18, input_grid_x, input_grid_y, input_grid_z, 1, 1, 1, reference_bits));
+    }
+    else
+    {
+      assert(mvx_voxelize_mesh(pyramid_vertices, 15, pyramid_indices, 18, input_grid_x, input_grid_y, input_grid_z, 1, 1, 1, reference));
+      assert(mvx_voxelize_mesh_bits(pyramid_vertices, 15, pyramid_indices, 18, input_grid_x, input_grid_y, input_grid_z, 1, 1, 1, reference_bits));
+    }
+
+    mesh = mvx_mesh_init_strided(interleaved[0].position, sizeof(mvx_test_vertex), 5, indices16, MVX_INDEX_U16, 18);
+    assert(mvx_voxelize_mesh_input(&mesh, input_grid_x, input_grid_y, input_grid_z, 1, 1, 1, solid, voxels));
+    for (q = 0; q < input_grid_x * input_grid_y * input_grid_z; ++q)
+    {
+      mismatches += voxels[q] != reference[q];
+    }
+
+    mesh = mvx_mesh_init_strided(interleaved[0].position, sizeof(mvx_test_vertex), 5, indices32, MVX_INDEX_U32, 18);
+    assert(mvx_voxelize_mesh_input_bits(&mesh, input_grid_x, input_grid_y, input_grid_z, 1, 1, 1, solid, bits));
+    for (q = 0; q < input_grid_y * input_grid_z; ++q)
+    {
+      mismatches += bits[q] != reference_bits[q];
+    }
+
+    mesh = mvx_mesh_init_strided(soup[0].position, sizeof(mvx_test_vertex), 18, 0, MVX_INDEX_NONE, 0);
+    assert(mvx_voxelize_mesh_input(&mesh, input_grid_x, input_grid_y, input_grid_z, 1, 1, 1, solid, voxels));
+    for (q = 0; q < input_grid_x * input_grid_y * input_grid_z; ++q)
+    {
+      mismatches += voxels[q] != reference[q];
+    }
+  }
+
+  /* a triangle with an index out of range is skipped */
+  indices16[18] = 0, indices16[19] = 1, indices16[20] = 5;
+  mesh = mvx_mesh_init_strided(interleaved[0].position, sizeof(mvx_test_vertex), 5, indices16, MVX_INDEX_U16, 21);
+  assert(mvx_voxelize_mesh_input(&mesh, input_grid_x, input_grid_y, input_grid_z, 1, 1, 1, 1, voxels));
+  for (q = 0; q < input_grid_x * input_grid_y * input_grid_z; ++q)
+  {
+    mismatches += voxels[q] != reference[q];
+  }
+
+  assert(mismatches == 0);
+
+  /* positions have to be float aligned and must not overlap */
+  mesh = mvx_mesh_init_strided(interleaved[0].position, 2 * sizeof(float), 5, indices16, MVX_INDEX_U16, 18);
+  assert(!mvx_voxelize_mesh_input(&mesh, input_grid_x, input_grid_y, input_grid_z, 1, 1, 1, 0, voxels));
+  mesh = mvx_mesh_init_strided(interleaved[0].position, sizeof(mvx_test_vertex) + 2, 5, indices16, MVX_INDEX_U16, 18);
+  assert(!mvx_voxelize_mesh_input(&mesh, input_grid_x, input_grid_y, input_grid_z, 1, 1, 1, 0, voxels));
+  mesh = mvx_mesh_init_strided(interleaved[0].position, sizeof(mvx_test_vertex), 5, 0, MVX_INDEX_U32, 18);
+  assert(!mvx_voxelize_mesh_input(&mesh, input_grid_x, input_grid_y, input_grid_z, 1, 1, 1, 0, voxels));
+}
+
+void mvx_test_voxelize_band(void)
+{
+#define band_grid 40
+  static unsigned char voxels[band_grid * band_grid * band_grid];
+  mvx_v3i clip_min = mvx_v3i_init(0, 0, 0);
+  mvx_v3i clip_max = mvx_v3i_init(band_grid - 1, band_grid - 1, band_grid - 1);
+  mvx_v3 origin = mvx_v3_init(1000.0f, -250.0f, 30.0f);
+  float vxsize = 0.125f;
+  int mismatches = 0;
+  int hits = 0;
+  int k, q, x, y, z;
+  mvx_grid grid;
+
+  assert(mvx_grid_init(&grid, origin, vxsize, band_grid, band_grid, band_grid));
+
+  /* large triangles across the grid, a third of them almost parallel to an axis */
+  for (k = 0; k < 60; ++k)
+  {
+    mvx_target target = mvx_target_init(MVX_TARGET_BYTES);
+    mvx_triangle_setup setup;
+    mvx_v3 v[3];
+    float h = 0.5f * vxsize;
+    int i;
+
+    for (i = 0; i < 3; ++i)
+    {
+      v[i] = mvx_v3_add(origin, mvx_v3_scale(mvx_v3_init(mvx_test_random(), mvx_test_random(), mvx_test_random()), band_grid * vxsize));
+    }
+
+    if (k % 3 == 1)
+    {
+      v[1].y = v[0].y + 1e-4f;
+      v[2].y = v[0].y - 1e-4f;
+    }
+    else if (k % 3 == 2)
+    {
+      v[1].x = v[0].x;
+      v[2].x = v[0].x + 1e-5f;
+    }
+
+    for (q = 0; q < band_grid * band_grid * band_grid; ++q)
+    {
+      voxels[q] = 0;
+    }
+
+    target.bytes = voxels;
+    mvx_voxelize_triangle(&grid, v[0], v[1], v[2], clip_min, clip_max, &target, 0);
+
+    /* every voxel of the grid with the row test the sweep is built on */
+    mvx_triangle_setup_init(&setup, v[0], v[1], v[2], mvx_v3_init(h, h, h));
+
+    for (z = 0; z < band_grid; ++z)
+    {
+      for (y = 0; y < band_grid; ++y)
+      {
+        mvx_triangle_row row;
+        int row_hit = mvx_triangle_row_init(&setup, &grid, y, z, &row);
+
+        for (x = 0; x < band_grid; ++x)
+        {
+          int reference = row_hit && mvx_triangle_row_overlap(&setup, &row, &grid, x);
+
+          hits += reference;
+          mismatches += voxels[x + y * band_grid + z * band_grid * band_grid] != reference;
+        }
+      }
+    }
+  }
+
+  assert(hits > 0);
+  assert(mismatches == 0);
+}
+
 int main(void)
 {
   mvx_test_voxelize_cube();
   mvx_test_voxelize_icosphere();
   mvx_test_voxelize_pyramid();
+  mvx_test_voxelize_bits();
+  mvx_test_voxelize_solid();
+  mvx_test_triangle_setup();
+  mvx_test_voxelize_parallel();
+  mvx_test_voxelize_binned();
+  mvx_test_voxelize_sparse();
+  mvx_test_voxelize_svdag();
+  mvx_test_voxelize_streaming();
+  mvx_test_voxelize_modes();
+  mvx_test_voxelize_incremental();
+  mvx_test_voxelize_instances();
+  mvx_test_voxelize_grid();
+  mvx_test_voxelize_context();
+  mvx_test_stats();
+  mvx_test_voxelize_attributes();
+  mvx_test_voxelize_sdf();
+  mvx_test_edt();
+  mvx_test_voxelize_rle();
+  mvx_test_file();
+  mvx_test_voxelize_layout();
+  mvx_test_lod();
+  mvx_test_voxelize_input();
+  mvx_test_voxelize_band();
 
   return 0;
 }